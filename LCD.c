@@ -5,6 +5,9 @@
 #include "hardware/i2c.h"
 #include "hardware/gpio.h"
 #include "hardware_definition.h"
+#include "profile.h"
+#include "latency.h"
+#include "energy.h"
 
 // タイムアウト付きI2C送信（LCD専用）
 // 成功: 送信バイト数、失敗: 負のエラー値
@@ -18,7 +21,9 @@ static int lcd_i2c_write_with_retry(const uint8_t *buf, size_t len, bool nostop)
     for (int attempt = 0; attempt < max_attempts; ++attempt)
     {
         // タイムアウト付き送信
+        energy_activity_begin(ENERGY_I2C);
         int ret = i2c_write_timeout_us(I2C_PORT, LCD_ADDR, buf, len, nostop, timeout_us);
+        energy_activity_end(ENERGY_I2C);
         if (ret == (int)len)
             return ret; // 成功
         last_err = ret;
@@ -46,6 +51,7 @@ static void lcd_send_data_bytes(const uint8_t *data, uint8_t len)
 {
     if (!data || len == 0)
         return;
+    uint32_t t0 = profile_cycles();
     uint8_t buf[17];
     uint8_t n = (len > 16) ? 16 : len;
     buf[0] = 0x40;
@@ -53,6 +59,8 @@ static void lcd_send_data_bytes(const uint8_t *data, uint8_t len)
         buf[1 + i] = data[i];
     lcd_i2c_write_with_retry(buf, (size_t)(1 + n), false);
     sleep_ms(2);
+    profile_stop("lcd", t0);
+    latency_note_lcd_write();
 }
 
 void lcd_init(void)
@@ -2,6 +2,12 @@
 #include "key.h"
 #include "settings.h"
 #include "macro.h"
+#include "compute.h"
+#include "profile.h"
+#include "datalist.h"
+#include "cplx.h"
+#include "fraction.h"
+#include "bid_ops.h"
 
 // 科学定数（2グループ×10件）
 typedef struct
@@ -43,26 +49,107 @@ BID_UINT128 stack[4];
 BID_UINT128 last_x;
 // 変数メモリ VA..VF
 static BID_UINT128 vars_mem[6];
+// 統計レジスタ（添字は統計セクションの STAT_*）
+static BID_UINT128 stat_reg[RPN_STAT_REG_COUNT];
+// 3D ベクトル演算の u（成分 x,y,z。常に実数）
+static BID_UINT128 vec_u[RPN_VEC_U_COUNT];
 static rpn_var_op_t pending_var_op = RPN_VAR_OP_NONE;
 
-// 生のスタック操作（Undo記録なし）
+// 複素数の虚部（添字 0..3=スタック, 4=LAST X, 5..10=VA..VF）
+// im_mask のビットが立っているレジスタだけが複素数で、実数だけの間は虚部を一切参照しない
+#define IM_LAST 4
+#define IM_VAR0 5
+#define IM_STACK_BITS 0x0Fu
+static BID_UINT128 im_reg[RPN_IM_REG_COUNT];
+static uint16_t im_mask = 0;
+// 区間演算モード中は im_reg を区間の上端として使う（実部側が下端、ビットが無いレジスタは点値）
+static bool g_interval = false;
+
+static inline bool im_has(int r) { return (im_mask >> r) & 1u; }
+static inline void im_clear(int r) { im_mask &= (uint16_t)~(1u << r); }
+// 虚部を設定（0なら実数に戻す）
+static void im_set(int r, BID_UINT128 v)
+{
+    int z = 0;
+    __bid128_isZero(&z, &v);
+    if (z)
+    {
+        im_clear(r);
+        return;
+    }
+    im_reg[r] = v;
+    im_mask |= (uint16_t)(1u << r);
+}
+static inline void im_copy(int dst, int src)
+{
+    if (im_has(src))
+    {
+        im_reg[dst] = im_reg[src];
+        im_mask |= (uint16_t)(1u << dst);
+    }
+    else
+    {
+        im_clear(dst);
+    }
+}
+static inline BID_UINT128 im_get(int r)
+{
+    BID_UINT128 v;
+    if (im_has(r))
+        return im_reg[r];
+    bid128_from_string(&v, "0");
+    return v;
+}
+
+// 生のスタック操作（Undo記録なし）。虚部は複素数があるときだけ同じ順で動かす
 static inline void stack_push_raw(void)
 {
     stack[3] = stack[2];
     stack[2] = stack[1];
     stack[1] = stack[0];
+    if (im_mask & IM_STACK_BITS)
+    {
+        im_copy(3, 2);
+        im_copy(2, 1);
+        im_copy(1, 0);
+    }
 }
 static inline void stack_pop_raw(void)
 {
     stack[0] = stack[1];
     stack[1] = stack[2];
     stack[2] = stack[3];
+    if (im_mask & IM_STACK_BITS)
+    {
+        im_copy(0, 1);
+        im_copy(1, 2);
+        im_copy(2, 3);
+    }
+}
+// スタック部分の虚部ビットを並べ替える（perm[i] = 移動後に位置 i に来る元の位置）
+static inline void im_permute_stack(const int perm[4])
+{
+    if ((im_mask & IM_STACK_BITS) == 0)
+        return;
+    BID_UINT128 v[4];
+    uint16_t m = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        v[i] = im_reg[perm[i]];
+        if (im_has(perm[i]))
+            m |= (uint16_t)(1u << i);
+    }
+    for (int i = 0; i < 4; ++i)
+        im_reg[i] = v[i];
+    im_mask = (uint16_t)((im_mask & ~IM_STACK_BITS) | m);
 }
 static inline void stack_swap_raw(void)
 {
     BID_UINT128 tmp = stack[0];
     stack[0] = stack[1];
     stack[1] = tmp;
+    static const int perm[4] = {1, 0, 2, 3};
+    im_permute_stack(perm);
 }
 static inline void stack_roll_up_raw(void)
 {
@@ -71,6 +158,8 @@ static inline void stack_roll_up_raw(void)
     stack[2] = stack[1];
     stack[1] = stack[0];
     stack[0] = tmp;
+    static const int perm[4] = {3, 0, 1, 2};
+    im_permute_stack(perm);
 }
 static inline void stack_roll_down_raw(void)
 {
@@ -79,6 +168,15 @@ static inline void stack_roll_down_raw(void)
     stack[1] = stack[2];
     stack[2] = stack[3];
     stack[3] = tmp;
+    static const int perm[4] = {1, 2, 3, 0};
+    im_permute_stack(perm);
+}
+
+// LAST X へ X を退避（虚部も）
+static inline void save_last_x(void)
+{
+    last_x = stack[0];
+    im_copy(IM_LAST, 0);
 }
 
 // Undo リング（スタックのみ）
@@ -87,8 +185,23 @@ typedef struct
     BID_UINT128 x, y, z, t;
 } undo_entry_t;
 static undo_entry_t undo_buf[100];
+#define UNDO_DEPTH ((int)(sizeof(undo_buf) / sizeof(undo_buf[0])))
 static int undo_len = 0; // 有効エントリ数
 static int undo_pos = 0; // 次にUndoで取り出す位置（undo_pos-1）
+static uint32_t undo_push_count = 0; // 積んだ回数（取消し時に巻き戻す分の判定用）
+static bool undo_suspended = false;   // ヘッドレス実行中は記録しない
+
+// 複素数を含むスナップショットの虚部は別の小さなプールに置く（実数だけのエントリは使わない）
+// プールは古い順に再利用し、上書きされるスロットを持つエントリより古い履歴は捨てる
+#define UNDO_IM_SLOTS 16
+#define UNDO_NO_IM 0xFFu
+static struct
+{
+    BID_UINT128 im[4];
+    uint8_t mask;
+} undo_im_pool[UNDO_IM_SLOTS];
+static uint8_t undo_im_slot[UNDO_DEPTH]; // エントリごとのプール番号（UNDO_NO_IM=実数のみ）
+static uint8_t undo_im_next = 0;
 
 static void undo_clear_all(void)
 {
@@ -96,6 +209,22 @@ static void undo_clear_all(void)
     undo_pos = 0;
 }
 
+// 古い方から k 件を捨てる
+static void undo_drop_oldest(int k)
+{
+    if (k <= 0)
+        return;
+    if (k > undo_len)
+        k = undo_len;
+    for (int i = k; i < undo_len; ++i)
+    {
+        undo_buf[i - k] = undo_buf[i];
+        undo_im_slot[i - k] = undo_im_slot[i];
+    }
+    undo_len -= k;
+    undo_pos = (undo_pos > k) ? (undo_pos - k) : 0;
+}
+
 static void undo_truncate_future(void)
 {
     if (undo_pos < undo_len)
@@ -106,25 +235,38 @@ static void undo_push_snapshot_if_enabled(void)
 {
     if (settings_get_last_key_mode() != LAST_KEY_UNDO)
         return;
-    if (macro_is_recording() || macro_is_playing())
+    if (macro_is_recording() || macro_is_playing() || undo_suspended)
         return; // マクロ記録/再生中は記録しない
     // 未来分を切り捨て
     undo_truncate_future();
-    // 満杯なら前詰め
-    if (undo_len >= (int)(sizeof(undo_buf) / sizeof(undo_buf[0])))
+    uint8_t slot = UNDO_NO_IM;
+    if (im_mask & IM_STACK_BITS)
     {
-        for (int i = 1; i < undo_len; ++i)
-            undo_buf[i - 1] = undo_buf[i];
-        undo_len--;
-        if (undo_pos > 0)
-            undo_pos--;
+        slot = undo_im_next;
+        undo_im_next = (uint8_t)((slot + 1u) % UNDO_IM_SLOTS);
+        for (int i = 0; i < undo_len; ++i)
+        {
+            if (undo_im_slot[i] == slot)
+            {
+                undo_drop_oldest(i + 1);
+                break;
+            }
+        }
+        undo_im_pool[slot].mask = (uint8_t)(im_mask & IM_STACK_BITS);
+        for (int i = 0; i < 4; ++i)
+            undo_im_pool[slot].im[i] = im_reg[i];
     }
+    // 満杯なら前詰め
+    if (undo_len >= UNDO_DEPTH)
+        undo_drop_oldest(1);
     undo_buf[undo_len].x = stack[0];
     undo_buf[undo_len].y = stack[1];
     undo_buf[undo_len].z = stack[2];
     undo_buf[undo_len].t = stack[3];
+    undo_im_slot[undo_len] = slot;
     undo_len++;
     undo_pos = undo_len;
+    undo_push_count++;
 }
 
 void stack_init()
@@ -137,6 +279,9 @@ void stack_init()
     // 変数領域初期化
     for (int i = 0; i < 6; ++i)
         bid128_from_string(&vars_mem[i], "0");
+    for (int i = 0; i < RPN_VEC_U_COUNT; ++i)
+        bid128_from_string(&vec_u[i], "0");
+    im_mask = 0;
     pending_var_op = RPN_VAR_OP_NONE;
     undo_clear_all();
 }
@@ -212,10 +357,11 @@ void handle_digit(char digit)
         input_state.input_len++;
     }
     bid128_from_string(&stack[0], input_state.input_str);
+    im_clear(0);
 }
 
-// 演算の後の処理
-void after_operation()
+// 演算の後の処理（X の実部/虚部とも）
+static void finish_operation(void)
 {
     // 直前の演算で立った例外フラグを保存してから全クリア
     last_exceptions = _IDEC_glbflags;
@@ -233,6 +379,14 @@ void after_operation()
     int is_inf = 0, is_nan = 0;
     __bid128_isInf(&is_inf, &stack[0]);
     __bid128_isNaN(&is_nan, &stack[0]);
+    if (im_has(0))
+    {
+        int im_inf = 0, im_nan = 0;
+        __bid128_isInf(&im_inf, &im_reg[0]);
+        __bid128_isNaN(&im_nan, &im_reg[0]);
+        is_inf |= im_inf;
+        is_nan |= im_nan;
+    }
 
     clear_input_state();
     flag_state.push_flag = !(is_inf || is_nan);
@@ -240,6 +394,38 @@ void after_operation()
     key_set_shift_state(false);
 }
 
+// 実数演算の後の処理（結果は実数）
+void after_operation()
+{
+    im_clear(0);
+    finish_operation();
+}
+
+// 複素数演算の後の処理（X の虚部は演算結果のまま）
+static void after_complex_operation(void)
+{
+    finish_operation();
+}
+
+// 演算を行わずに無効演算として終える（スタックと Undo 履歴は変えない）
+static void reject_operation(void)
+{
+    last_exceptions = _IDEC_glbflags | BID_INVALID_EXCEPTION;
+    _IDEC_glbflags = BID_EXACT_STATUS;
+    clear_input_state();
+    flag_state.push_flag = true;
+    key_set_shift_state(false);
+}
+
+// 複素数を受け付けない演算（統計/階乗など）: 対象に複素数があればスタックを変えずに無効演算とする
+static bool reject_complex(unsigned stack_bits)
+{
+    if ((im_mask & stack_bits) == 0)
+        return false;
+    reject_operation();
+    return true;
+}
+
 // 直近演算の例外フラグを返す（BID_*_EXCEPTION の OR）。
 // 取得のみでフラグは維持される（必要なら利用側でゼロクリア）。
 _IDEC_flags rpn_get_last_exceptions()
@@ -337,7 +523,7 @@ static int rpn_round_bankers(char *digits, int len, int keep)
     return new_len;
 }
 
-void bid128_to_str(BID_UINT128 x, char *buf, int bufsize)
+static void format_bid128(BID_UINT128 x, char *buf, int bufsize)
 {
     // 安全ガード
     if (!buf || bufsize <= 0)
@@ -724,7 +910,7 @@ void bid128_to_str(BID_UINT128 x, char *buf, int bufsize)
         // 科学表記へフォールバック
         disp_mode_t old = init_state.disp_mode;
         init_state.disp_mode = DISP_MODE_SCIENTIFIC;
-        bid128_to_str(x, buf, bufsize);
+        format_bid128(x, buf, bufsize);
         init_state.disp_mode = old;
         return;
     }
@@ -764,7 +950,7 @@ void bid128_to_str(BID_UINT128 x, char *buf, int bufsize)
         {
             disp_mode_t old = init_state.disp_mode;
             init_state.disp_mode = DISP_MODE_SCIENTIFIC;
-            bid128_to_str(x, buf, bufsize);
+            format_bid128(x, buf, bufsize);
             init_state.disp_mode = old;
             return;
         }
@@ -829,7 +1015,7 @@ void bid128_to_str(BID_UINT128 x, char *buf, int bufsize)
         {
             disp_mode_t old = init_state.disp_mode;
             init_state.disp_mode = DISP_MODE_SCIENTIFIC;
-            bid128_to_str(x, buf, bufsize);
+            format_bid128(x, buf, bufsize);
             init_state.disp_mode = old;
             return;
         }
@@ -943,6 +1129,14 @@ void bid128_to_str(BID_UINT128 x, char *buf, int bufsize)
     }
 }
 
+void bid128_to_str(BID_UINT128 x, char *buf, int bufsize)
+{
+    uint32_t t0 = profile_cycles();
+    if (init_state.disp_mode != DISP_MODE_FRACTION || !frac_format_value(x, buf, bufsize))
+        format_bid128(x, buf, bufsize);
+    profile_stop("format", t0);
+}
+
 // #########################
 //  RPN電卓本体
 // #########################
@@ -955,6 +1149,7 @@ void init_rpn()
     clear_input_state();
     load_settings();
     undo_clear_all();
+    rpn_reset_stats();
 }
 
 // #########################
@@ -971,9 +1166,22 @@ void rpn_set_x(BID_UINT128 x)
 {
     undo_push_snapshot_if_enabled();
     // LAST X は上書き前のXを保存
-    last_x = stack[0];
+    save_last_x();
+    stack[0] = x;
+    im_clear(0);
+    clear_input_state();
+}
+
+// X,Y,Z,T をまとめて設定（確定値として扱い、次の入力は push される）
+void rpn_load_stack(BID_UINT128 x, BID_UINT128 y, BID_UINT128 z, BID_UINT128 t)
+{
     stack[0] = x;
+    stack[1] = y;
+    stack[2] = z;
+    stack[3] = t;
+    im_mask &= (uint16_t)~IM_STACK_BITS;
     clear_input_state();
+    flag_state.push_flag = true;
 }
 
 void rpn_var_set_pending_op(rpn_var_op_t op)
@@ -997,6 +1205,7 @@ bool rpn_var_apply_slot(int slot_idx)
     case RPN_VAR_OP_ST:
         undo_push_snapshot_if_enabled();
         vars_mem[slot_idx] = stack[0];
+        im_copy(IM_VAR0 + slot_idx, 0);
         break;
     case RPN_VAR_OP_LD:
     {
@@ -1009,6 +1218,7 @@ bool rpn_var_apply_slot(int slot_idx)
         clear_input_state();
         undo_push_snapshot_if_enabled();
         stack[0] = vars_mem[slot_idx];
+        im_copy(0, IM_VAR0 + slot_idx);
         flag_state.push_flag = true;
         break;
     }
@@ -1018,6 +1228,7 @@ bool rpn_var_apply_slot(int slot_idx)
         BID_UINT128 zero;
         bid128_from_string(&zero, "0");
         vars_mem[slot_idx] = zero;
+        im_clear(IM_VAR0 + slot_idx);
         break;
     }
     default:
@@ -1072,6 +1283,7 @@ bool rpn_const_apply(int group, int index)
     }
     clear_input_state();
     stack[0] = v;
+    im_clear(0);
     flag_state.push_flag = true;
     return true;
 }
@@ -1119,6 +1331,7 @@ static void update_x_from_input_if_valid()
     if (!input_ends_with_digit())
         return; // 不完全な入力は反映しない
     bid128_from_string(&stack[0], input_state.input_str);
+    im_clear(0);
 }
 
 void rpn_input_clear()
@@ -1154,8 +1367,11 @@ void rpn_input_dot()
         clear_input_state();
         flag_state.push_flag = false;
     }
+    im_clear(0); // 入力中の X は実数
     if (input_state.dot_pos >= 0)
         return; // 重複禁止
+    if (input_state.exp_pos >= 0)
+        return; // 指数部に小数点は不可（"1E5." は数値として解釈できない）
     if (input_state.input_len == 0)
     {
         // "0." から開始
@@ -1257,6 +1473,9 @@ void rpn_input_toggle_sign()
                 input_state.input_str[0] = '-';
                 input_state.input_len++;
                 input_state.input_str[input_state.input_len] = '\0';
+                // 挿入で後ろにずれた小数点の位置を追従させる（ここでは指数部は未入力）
+                if (input_state.dot_pos >= 0)
+                    input_state.dot_pos++;
             }
         }
         update_x_from_input_if_valid();
@@ -1264,8 +1483,21 @@ void rpn_input_toggle_sign()
     else
     {
         // 入力確定後はXレジスタの符号を反転
-        last_x = stack[0];
+        save_last_x();
         __bid128_negate(&stack[0], &stack[0]);
+        if (im_has(0))
+        {
+            __bid128_negate(&im_reg[0], &im_reg[0]);
+            if (g_interval)
+            {
+                // [lo, hi] → [-hi, -lo]
+                BID_UINT128 t = stack[0];
+                stack[0] = im_reg[0];
+                im_reg[0] = t;
+            }
+            after_complex_operation();
+            return;
+        }
         after_operation();
     }
 }
@@ -1288,12 +1520,14 @@ void rpn_input_backspace()
         // 単独符号は無効とみなしてクリア
         clear_input_state();
         bid128_from_string(&stack[0], "0");
+        im_clear(0);
         return;
     }
     if (input_state.input_len == 0)
     {
         // 空になったらXを0に
         bid128_from_string(&stack[0], "0");
+        im_clear(0);
         return;
     }
     update_x_from_input_if_valid();
@@ -1303,6 +1537,7 @@ void rpn_clear_x()
 {
     clear_input_state();
     bid128_from_string(&stack[0], "0");
+    im_clear(0);
     // 次の入力で上書き開始
     flag_state.push_flag = false;
 }
@@ -1353,210 +1588,848 @@ void rpn_roll_down()
     flag_state.push_flag = true;
 }
 
-void rpn_add()
+// #########################
+//  複素数演算の振り分け
+// #########################
+// X（二項演算は X,Y）に虚部があるか、Complex=ON で実数では定義域外のときだけ複素数で計算する。
+// それ以外は従来の実数演算をそのまま使う（実数だけなら im_mask のビット判定のみの負担）
+static cplx_t stack_cplx(int i)
 {
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 res;
-    __bid128_add(&res, &stack[1], &stack[0]);
-    stack_pop_raw();
-    stack[0] = res;
-    after_operation();
+    return cplx_make(stack[i], im_get(i));
 }
-void rpn_sub()
+
+static bool complex_wanted(unsigned stack_bits, bool real_ok)
 {
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 res;
-    __bid128_sub(&res, &stack[1], &stack[0]); // y - x
-    stack_pop_raw();
-    stack[0] = res;
-    after_operation();
+    if (im_mask & stack_bits)
+        return true;
+    return !real_ok && settings_get_complex_results();
 }
-void rpn_mul()
+
+static bool complex_unary(cplx_t (*fn)(cplx_t), bool real_ok)
 {
+    if (g_interval)
+        return reject_complex(0x1u); // 区間演算に対応しない演算は区間を受け付けない
+    if (!complex_wanted(0x1u, real_ok))
+        return false;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 res;
-    __bid128_mul(&res, &stack[1], &stack[0]);
-    stack_pop_raw();
-    stack[0] = res;
-    after_operation();
+    save_last_x();
+    cplx_t r = fn(stack_cplx(0));
+    stack[0] = r.re;
+    im_set(0, r.im);
+    after_complex_operation();
+    return true;
 }
-void rpn_div()
+
+// fn(y, x)
+static bool complex_binary(cplx_t (*fn)(cplx_t, cplx_t), bool real_ok)
 {
+    if (g_interval)
+        return reject_complex(0x3u);
+    if (!complex_wanted(0x3u, real_ok))
+        return false;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 res;
-    __bid128_div(&res, &stack[1], &stack[0]); // y / x
+    save_last_x();
+    cplx_t r = fn(stack_cplx(1), stack_cplx(0));
     stack_pop_raw();
-    stack[0] = res;
-    after_operation();
+    stack[0] = r.re;
+    im_set(0, r.im);
+    after_complex_operation();
+    return true;
 }
 
-// 単項演算
-void rpn_sqrt()
+// #########################
+//  区間演算
+// #########################
+// 下端は切下げ、上端は切上げで同じ演算を2回行う（_IDEC_glbround を一時的に切り替え）。
+// 正しく丸められる四則・1/x・√・x² だけを区間で計算し、それ以外の演算は区間を受け付けない。
+// モード OFF の間は各演算の入口で g_interval を1回見るだけ
+typedef struct
 {
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_sqrt(&stack[0], &stack[0]);
-    after_operation();
+    BID_UINT128 lo, hi;
+} ival_t;
+
+static ival_t stack_ival(int r)
+{
+    ival_t v = {stack[r], im_has(r) ? im_reg[r] : stack[r]};
+    return v;
 }
-void rpn_rev()
+
+// 幅が 0 なら点値として置く
+static void stack_set_ival(int r, ival_t v)
 {
-    // 1 / x
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 one, res;
-    bid128_from_string(&one, "1");
-    __bid128_div(&res, &one, &stack[0]);
-    stack[0] = res;
-    after_operation();
+    stack[r] = v.lo;
+    if (d_eq(v.lo, v.hi))
+    {
+        im_clear(r);
+        return;
+    }
+    im_reg[r] = v.hi;
+    im_mask |= (uint16_t)(1u << r);
 }
-void rpn_pow2()
+
+static ival_t ival_invalid(void)
+{
+    ival_t r;
+    r.lo = d_from_str("NaN");
+    r.hi = r.lo;
+    _IDEC_glbflags |= BID_INVALID_EXCEPTION;
+    return r;
+}
+
+static inline bool ival_has_nan(ival_t v)
 {
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 t;
-    __bid128_mul(&t, &stack[0], &stack[0]);
-    stack[0] = t;
-    after_operation();
+    int a = 0, b = 0;
+    __bid128_isNaN(&a, &v.lo);
+    __bid128_isNaN(&b, &v.hi);
+    return a || b;
 }
-void rpn_pow()
+
+static inline BID_UINT128 d_min(BID_UINT128 a, BID_UINT128 b) { return d_lt(b, a) ? b : a; }
+static inline BID_UINT128 d_max(BID_UINT128 a, BID_UINT128 b) { return d_gt(b, a) ? b : a; }
+
+static ival_t iv_add(ival_t a, ival_t b)
 {
-    // y^x
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 res;
-    __bid128_pow(&res, &stack[1], &stack[0]);
-    stack_pop_raw();
-    stack[0] = res;
-    after_operation();
+    ival_t r;
+    _IDEC_round saved = _IDEC_glbround;
+    _IDEC_glbround = BID_ROUNDING_DOWN;
+    r.lo = d_add(a.lo, b.lo);
+    _IDEC_glbround = BID_ROUNDING_UP;
+    r.hi = d_add(a.hi, b.hi);
+    _IDEC_glbround = saved;
+    return r;
 }
-void rpn_nth_root()
+
+static ival_t iv_sub(ival_t a, ival_t b)
 {
-    // y√x = x^(1/y)
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 one, inv_y, res;
-    bid128_from_string(&one, "1");
-    __bid128_div(&inv_y, &one, &stack[1]); // 1/Y
-    __bid128_pow(&res, &stack[0], &inv_y); // X^(1/Y)
-    stack_pop();
-    stack[0] = res;
-    after_operation();
+    ival_t r;
+    _IDEC_round saved = _IDEC_glbround;
+    _IDEC_glbround = BID_ROUNDING_DOWN;
+    r.lo = d_sub(a.lo, b.hi);
+    _IDEC_glbround = BID_ROUNDING_UP;
+    r.hi = d_sub(a.hi, b.lo);
+    _IDEC_glbround = saved;
+    return r;
 }
-void rpn_log()
+
+// 端点の積4通りのうち最小（切下げ）と最大（切上げ）
+static ival_t iv_mul(ival_t a, ival_t b)
 {
-    // log10(x)
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_log10(&stack[0], &stack[0]);
-    after_operation();
+    const BID_UINT128 x[4] = {a.lo, a.lo, a.hi, a.hi};
+    const BID_UINT128 y[4] = {b.lo, b.hi, b.lo, b.hi};
+    ival_t r;
+    _IDEC_round saved = _IDEC_glbround;
+    _IDEC_glbround = BID_ROUNDING_DOWN;
+    r.lo = d_mul(x[0], y[0]);
+    for (int i = 1; i < 4; ++i)
+        r.lo = d_min(r.lo, d_mul(x[i], y[i]));
+    _IDEC_glbround = BID_ROUNDING_UP;
+    r.hi = d_mul(x[0], y[0]);
+    for (int i = 1; i < 4; ++i)
+        r.hi = d_max(r.hi, d_mul(x[i], y[i]));
+    _IDEC_glbround = saved;
+    return ival_has_nan(r) ? ival_invalid() : r;
 }
-void rpn_ln()
+
+// 0 を内部に含む幅のある区間での除算は無効（点値の 0 は通常どおり ÷0）
+static ival_t iv_div(ival_t a, ival_t b)
 {
-    // ln(x)
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_log(&stack[0], &stack[0]);
-    after_operation();
+    if (!d_eq(b.lo, b.hi) && !d_gt(b.lo, d_from_int(0)) && !d_lt(b.hi, d_from_int(0)))
+        return ival_invalid();
+    const BID_UINT128 x[4] = {a.lo, a.lo, a.hi, a.hi};
+    const BID_UINT128 y[4] = {b.lo, b.hi, b.lo, b.hi};
+    ival_t r;
+    _IDEC_round saved = _IDEC_glbround;
+    _IDEC_glbround = BID_ROUNDING_DOWN;
+    r.lo = d_div(x[0], y[0]);
+    for (int i = 1; i < 4; ++i)
+        r.lo = d_min(r.lo, d_div(x[i], y[i]));
+    _IDEC_glbround = BID_ROUNDING_UP;
+    r.hi = d_div(x[0], y[0]);
+    for (int i = 1; i < 4; ++i)
+        r.hi = d_max(r.hi, d_div(x[i], y[i]));
+    _IDEC_glbround = saved;
+    return ival_has_nan(r) ? ival_invalid() : r;
 }
-// 角度→ラジアン変換（DEG/GRAD→RAD。RADはそのまま）
-static void rpn_convert_angle_to_rad(BID_UINT128 *x)
+
+static ival_t iv_recip(ival_t a)
 {
-    if (init_state.angle_mode == ANGLE_MODE_DEG)
+    ival_t one = {d_from_int(1), d_from_int(1)};
+    return iv_div(one, a);
+}
+
+static ival_t iv_sqrt(ival_t a)
+{
+    if (d_lt(a.lo, d_from_int(0)))
+        return ival_invalid();
+    ival_t r;
+    _IDEC_round saved = _IDEC_glbround;
+    _IDEC_glbround = BID_ROUNDING_DOWN;
+    __bid128_sqrt(&r.lo, &a.lo);
+    _IDEC_glbround = BID_ROUNDING_UP;
+    __bid128_sqrt(&r.hi, &a.hi);
+    _IDEC_glbround = saved;
+    return r;
+}
+
+// x²: 0 をまたぐ区間は下端 0
+static ival_t iv_square(ival_t a)
+{
+    BID_UINT128 zero = d_from_int(0);
+    BID_UINT128 small, large;
+    if (!d_lt(a.lo, zero))
     {
-        BID_UINT128 k; // pi/180
-        bid128_from_string(&k, "0.017453292519943295769236907684886127134");
-        __bid128_mul(x, x, &k);
+        small = a.lo;
+        large = a.hi;
     }
-    else if (init_state.angle_mode == ANGLE_MODE_GRAD)
+    else if (!d_gt(a.hi, zero))
     {
-        BID_UINT128 k; // pi/200
-        bid128_from_string(&k, "0.015707963267948966192313216916397514421");
-        __bid128_mul(x, x, &k);
+        small = d_abs(a.hi);
+        large = d_abs(a.lo);
+    }
+    else
+    {
+        small = zero;
+        large = d_max(d_abs(a.lo), a.hi);
     }
+    ival_t r;
+    _IDEC_round saved = _IDEC_glbround;
+    _IDEC_glbround = BID_ROUNDING_DOWN;
+    r.lo = d_mul(small, small);
+    _IDEC_glbround = BID_ROUNDING_UP;
+    r.hi = d_mul(large, large);
+    _IDEC_glbround = saved;
+    return r;
 }
 
-void rpn_sin()
+// fn(y, x)。区間演算モードでなければ false
+static bool interval_binary(ival_t (*fn)(ival_t, ival_t))
 {
-    // 角度モードに応じて入力xをラジアンへ変換しsin
+    if (!g_interval)
+        return false;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 x = stack[0];
-    BID_UINT128 res;
-    rpn_convert_angle_to_rad(&x);
-    __bid128_sin(&res, &x);
-    stack[0] = res;
-    after_operation();
+    save_last_x();
+    ival_t r = fn(stack_ival(1), stack_ival(0));
+    stack_pop_raw();
+    stack_set_ival(0, r);
+    finish_operation();
+    return true;
 }
-void rpn_cos()
+
+static bool interval_unary(ival_t (*fn)(ival_t))
 {
+    if (!g_interval)
+        return false;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 x = stack[0];
-    BID_UINT128 res;
-    rpn_convert_angle_to_rad(&x);
-    __bid128_cos(&res, &x);
-    stack[0] = res;
-    after_operation();
+    save_last_x();
+    stack_set_ival(0, fn(stack_ival(0)));
+    finish_operation();
+    return true;
 }
-void rpn_tan()
+
+// 区間 Y,X（点値可）から [min, max] を作る。X が区間なら Y←下端, X←上端 に分ける
+static void interval_compose(void)
 {
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 x = stack[0];
-    BID_UINT128 res;
-    rpn_convert_angle_to_rad(&x);
-    __bid128_tan(&res, &x);
-    stack[0] = res;
-    after_operation();
+    save_last_x();
+    if (im_has(0))
+    {
+        BID_UINT128 hi = im_reg[0];
+        stack_push_raw();
+        im_clear(1);
+        im_clear(0);
+        stack[0] = hi;
+        finish_operation();
+        return;
+    }
+    ival_t y = stack_ival(1), x = stack_ival(0);
+    ival_t r = {d_min(y.lo, x.lo), d_max(y.hi, x.hi)};
+    stack_pop_raw();
+    stack_set_ival(0, r);
+    finish_operation();
 }
 
-// 追加単項・二項演算
-void rpn_cube()
+bool rpn_get_interval_mode(void)
 {
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    BID_UINT128 t, res;
-    __bid128_mul(&t, &stack[0], &stack[0]);
-    __bid128_mul(&res, &t, &stack[0]);
-    stack[0] = res;
-    after_operation();
+    return g_interval;
 }
 
-void rpn_cbrt()
+void rpn_interval_mid_rad(BID_UINT128 lo, BID_UINT128 hi, BID_UINT128 *mid, BID_UINT128 *rad)
 {
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_cbrt(&stack[0], &stack[0]);
-    after_operation();
+    _IDEC_flags saved_flags = _IDEC_glbflags;
+    _IDEC_round saved = _IDEC_glbround;
+    BID_UINT128 m = d_div(d_add(lo, hi), d_from_int(2));
+    _IDEC_glbround = BID_ROUNDING_UP;
+    BID_UINT128 r = d_max(d_sub(hi, m), d_sub(m, lo));
+    _IDEC_glbround = saved;
+    _IDEC_glbflags = saved_flags;
+    if (mid)
+        *mid = m;
+    if (rad)
+        *rad = r;
 }
 
-void rpn_exp()
+// 区間レジスタ r の実部側の格納先（添字は im_reg と同じ）
+static BID_UINT128 *base_reg(int r)
 {
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_exp(&stack[0], &stack[0]);
-    after_operation();
+    if (r < 4)
+        return &stack[r];
+    if (r == IM_LAST)
+        return &last_x;
+    return &vars_mem[r - IM_VAR0];
 }
 
-void rpn_exp10()
+void rpn_set_interval_mode(bool on)
 {
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_exp10(&stack[0], &stack[0]);
-    after_operation();
+    if (on == g_interval)
+        return;
+    // OFF にするときは区間を中点に、ON にするときは複素数の虚部を捨てる
+    if (!on)
+    {
+        for (int i = 0; i < RPN_IM_REG_COUNT; ++i)
+        {
+            if (im_has(i))
+                rpn_interval_mid_rad(*base_reg(i), im_reg[i], base_reg(i), NULL);
+        }
+    }
+    im_mask = 0;
+    g_interval = on;
+    undo_clear_all(); // 虚部と上端が混ざらないよう履歴は捨てる
 }
 
-void rpn_fact()
+bool rpn_stack_interval(int level, BID_UINT128 *lo, BID_UINT128 *hi)
 {
-    // 整数は自前実装（精度改善）。非整数は x! = Γ(x + 1)
-    undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-
-    BID_UINT128 x = stack[0];
+    if (!g_interval || level < 0 || level > 3 || !im_has(level))
+        return false;
+    if (lo)
+        *lo = stack[level];
+    if (hi)
+        *hi = im_reg[level];
+    return true;
+}
+
+// 分数モードの四則: Y,X がともに正確な分数で、結果も64ビットに収まるときだけ整数演算で行う
+// fn(y, x)。扱えなければ false（通常の BID128 演算へ）
+static bool fraction_binary(bool (*fn)(frac_t, frac_t, frac_t *))
+{
+    frac_t a, b, r;
+    if (init_state.disp_mode != DISP_MODE_FRACTION)
+        return false;
+    if (!frac_exact(stack[1], &a) || !frac_exact(stack[0], &b) || !fn(a, b, &r))
+        return false;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 res = frac_to_bid(r);
+    stack_pop_raw();
+    stack[0] = res;
+    frac_remember(res, r);
+    after_operation();
+    return true;
+}
+
+static bool fraction_unary(bool (*fn)(frac_t, frac_t *))
+{
+    frac_t a, r;
+    if (init_state.disp_mode != DISP_MODE_FRACTION)
+        return false;
+    if (!frac_exact(stack[0], &a) || !fn(a, &r))
+        return false;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    stack[0] = frac_to_bid(r);
+    frac_remember(stack[0], r);
+    after_operation();
+    return true;
+}
+
+// 作業精度が16桁なら BID64 で計算して BID128 へ戻す（BID64→BID128 は正確）。
+// レジスタ・角度換算・統計などの内部計算は常に BID128 のまま
+typedef void (*bid128_unary_fn)(BID_UINT128 *, BID_UINT128 *);
+typedef void (*bid128_binary_fn)(BID_UINT128 *, BID_UINT128 *, BID_UINT128 *);
+typedef void (*bid64_unary_fn)(BID_UINT64 *, BID_UINT64 *);
+typedef void (*bid64_binary_fn)(BID_UINT64 *, BID_UINT64 *, BID_UINT64 *);
+
+static void eval_unary(bid128_unary_fn f128, bid64_unary_fn f64, BID_UINT128 *res, BID_UINT128 *x)
+{
+    if (settings_get_precision() != PRECISION_16)
+    {
+        f128(res, x);
+        return;
+    }
+    BID_UINT64 a, r;
+    __bid128_to_bid64(&a, x);
+    f64(&r, &a);
+    __bid64_to_bid128(res, &r);
+}
+
+static void eval_binary(bid128_binary_fn f128, bid64_binary_fn f64, BID_UINT128 *res, BID_UINT128 *x, BID_UINT128 *y)
+{
+    if (settings_get_precision() != PRECISION_16)
+    {
+        f128(res, x, y);
+        return;
+    }
+    BID_UINT64 a, b, r;
+    __bid128_to_bid64(&a, x);
+    __bid128_to_bid64(&b, y);
+    f64(&r, &a, &b);
+    __bid64_to_bid128(res, &r);
+}
+
+// res = x·y + z（丸めは1回）
+static void eval_fma(BID_UINT128 *res, BID_UINT128 *x, BID_UINT128 *y, BID_UINT128 *z)
+{
+    if (settings_get_precision() != PRECISION_16)
+    {
+        __bid128_fma(res, x, y, z);
+        return;
+    }
+    BID_UINT64 a, b, c, r;
+    __bid128_to_bid64(&a, x);
+    __bid128_to_bid64(&b, y);
+    __bid128_to_bid64(&c, z);
+    __bid64_fma(&r, &a, &b, &c);
+    __bid64_to_bid128(res, &r);
+}
+
+// 整数かどうか（例外フラグは汚さない）
+static bool is_integral(BID_UINT128 x)
+{
+    _IDEC_flags saved = _IDEC_glbflags;
+    _IDEC_glbflags = BID_EXACT_STATUS;
+    BID_UINT128 xi;
+    bid128_round_integral_exact(&xi, &x);
+    bool exact = ((_IDEC_glbflags & (BID_INEXACT_EXCEPTION | BID_INVALID_EXCEPTION)) == 0);
+    _IDEC_glbflags = saved;
+    return exact;
+}
+
+static inline bool is_negative(BID_UINT128 x)
+{
+    return d_lt(x, d_from_int(0));
+}
+
+// |x| <= 1（NaN は実数側で扱う）
+static inline bool within_unit(BID_UINT128 x)
+{
+    return !d_gt(d_abs(x), d_from_int(1));
+}
+
+static cplx_t c_pow2(cplx_t z) { return cplx_mul(z, z); }
+static cplx_t c_cube(cplx_t z) { return cplx_mul(cplx_mul(z, z), z); }
+static cplx_t c_cbrt(cplx_t z) { return cplx_pow(z, cplx_make(d_div(d_from_int(1), d_from_int(3)), d_from_int(0))); }
+static cplx_t c_nth_root(cplx_t y, cplx_t x) { return cplx_pow(x, cplx_recip(y)); } // X^(1/Y)
+static cplx_t c_logxy(cplx_t y, cplx_t x) { return cplx_div(cplx_ln(y), cplx_ln(x)); }
+
+// COMPLEX: 実数 Y,X → Y+iX。X が複素数なら Y←実部, X←虚部 に分ける
+void rpn_complex(void)
+{
+    if (input_state.input_len > 0)
+        update_x_from_input_if_valid();
+    if (g_interval)
+    {
+        interval_compose();
+        return;
+    }
+    if (im_has(0))
+    {
+        undo_push_snapshot_if_enabled();
+        BID_UINT128 im = im_reg[0];
+        save_last_x();
+        stack_push_raw();
+        im_clear(1);
+        stack[0] = im;
+        im_clear(0);
+        after_complex_operation();
+        return;
+    }
+    if (reject_complex(0x2u)) // Y だけが複素数なら組み立てられない
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 im = stack[0];
+    stack_pop_raw();
+    im_set(0, im);
+    after_complex_operation();
+}
+
+bool rpn_stack_im(int level, BID_UINT128 *im)
+{
+    if (g_interval || level < 0 || level > 3 || !im_has(level))
+        return false;
+    if (im)
+        *im = im_reg[level];
+    return true;
+}
+
+void rpn_add()
+{
+    if (interval_binary(iv_add))
+        return;
+    if (complex_binary(cplx_add, true))
+        return;
+    if (fraction_binary(frac_add))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 res;
+    eval_binary(__bid128_add, __bid64_add, &res, &stack[1], &stack[0]);
+    stack_pop_raw();
+    stack[0] = res;
+    after_operation();
+}
+void rpn_sub()
+{
+    if (interval_binary(iv_sub))
+        return;
+    if (complex_binary(cplx_sub, true))
+        return;
+    if (fraction_binary(frac_sub))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 res;
+    eval_binary(__bid128_sub, __bid64_sub, &res, &stack[1], &stack[0]); // y - x
+    stack_pop_raw();
+    stack[0] = res;
+    after_operation();
+}
+void rpn_mul()
+{
+    if (interval_binary(iv_mul))
+        return;
+    if (complex_binary(cplx_mul, true))
+        return;
+    if (fraction_binary(frac_mul))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 res;
+    eval_binary(__bid128_mul, __bid64_mul, &res, &stack[1], &stack[0]);
+    stack_pop_raw();
+    stack[0] = res;
+    after_operation();
+}
+void rpn_div()
+{
+    if (interval_binary(iv_div))
+        return;
+    if (complex_binary(cplx_div, true))
+        return;
+    if (fraction_binary(frac_div))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 res;
+    eval_binary(__bid128_div, __bid64_div, &res, &stack[1], &stack[0]); // y / x
+    stack_pop_raw();
+    stack[0] = res;
+    after_operation();
+}
+
+// 単項演算
+void rpn_sqrt()
+{
+    if (interval_unary(iv_sqrt))
+        return;
+    if (complex_unary(cplx_sqrt, !is_negative(stack[0])))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_sqrt, __bid64_sqrt, &stack[0], &stack[0]);
+    after_operation();
+}
+void rpn_rev()
+{
+    if (interval_unary(iv_recip))
+        return;
+    if (complex_unary(cplx_recip, true))
+        return;
+    if (fraction_unary(frac_recip))
+        return;
+    // 1 / x
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 one, res;
+    bid128_from_string(&one, "1");
+    eval_binary(__bid128_div, __bid64_div, &res, &one, &stack[0]);
+    stack[0] = res;
+    after_operation();
+}
+void rpn_pow2()
+{
+    if (interval_unary(iv_square))
+        return;
+    if (complex_unary(c_pow2, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 t;
+    eval_binary(__bid128_mul, __bid64_mul, &t, &stack[0], &stack[0]);
+    stack[0] = t;
+    after_operation();
+}
+void rpn_pow()
+{
+    // 負の数の非整数乗は複素数
+    if (complex_binary(cplx_pow, !(is_negative(stack[1]) && !is_integral(stack[0]))))
+        return;
+    // y^x
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 res;
+    eval_binary(__bid128_pow, __bid64_pow, &res, &stack[1], &stack[0]);
+    stack_pop_raw();
+    stack[0] = res;
+    after_operation();
+}
+void rpn_nth_root()
+{
+    if (complex_wanted(0x3u, true) || (is_negative(stack[0]) && settings_get_complex_results()))
+    {
+        // 負の数の累乗根（1/Y が整数でない）は実数演算では NaN になるため複素数の主値を返す
+        BID_UINT128 inv_y = d_div(d_from_int(1), stack[1]);
+        if (complex_binary(c_nth_root, !(is_negative(stack[0]) && !is_integral(inv_y))))
+            return;
+    }
+    // y√x = x^(1/y)
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 one, inv_y, res;
+    bid128_from_string(&one, "1");
+    eval_binary(__bid128_div, __bid64_div, &inv_y, &one, &stack[1]); // 1/Y
+    eval_binary(__bid128_pow, __bid64_pow, &res, &stack[0], &inv_y); // X^(1/Y)
+    stack_pop();
+    stack[0] = res;
+    after_operation();
+}
+void rpn_log()
+{
+    if (complex_unary(cplx_log10, !is_negative(stack[0])))
+        return;
+    // log10(x)
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_log10, __bid64_log10, &stack[0], &stack[0]);
+    after_operation();
+}
+void rpn_ln()
+{
+    if (complex_unary(cplx_ln, !is_negative(stack[0])))
+        return;
+    // ln(x)
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_log, __bid64_log, &stack[0], &stack[0]);
+    after_operation();
+}
+// 角度→ラジアン変換（DEG/GRAD→RAD。RADはそのまま）
+static void rpn_convert_angle_to_rad(BID_UINT128 *x)
+{
+    if (init_state.angle_mode == ANGLE_MODE_DEG)
+    {
+        BID_UINT128 k; // pi/180
+        bid128_from_string(&k, "0.017453292519943295769236907684886127134");
+        __bid128_mul(x, x, &k);
+    }
+    else if (init_state.angle_mode == ANGLE_MODE_GRAD)
+    {
+        BID_UINT128 k; // pi/200
+        bid128_from_string(&k, "0.015707963267948966192313216916397514421");
+        __bid128_mul(x, x, &k);
+    }
+}
+
+// 複素数の三角関数も角度モードに従う（実部/虚部を同じ係数で換算）
+static cplx_t angle_to_rad_c(cplx_t z)
+{
+    rpn_convert_angle_to_rad(&z.re);
+    rpn_convert_angle_to_rad(&z.im);
+    return z;
+}
+static cplx_t c_sin(cplx_t z) { return cplx_sin(angle_to_rad_c(z)); }
+static cplx_t c_cos(cplx_t z) { return cplx_cos(angle_to_rad_c(z)); }
+static cplx_t c_tan(cplx_t z) { return cplx_tan(angle_to_rad_c(z)); }
+
+// 実数の三角関数
+// DEG/GRAD は 1周（360/400）の剰余を fmod で10進のまま正確に求め、象限と 1/8 周で折り返してから
+// 0〜45°（0〜50g）の角だけをラジアンに換算する。π の近似誤差が大きな角で増幅されず、
+// 0/90/180/270°（GRAD は 100g 刻み）は正確に 0/±1、DEG の 30/150/210/330° の sin は正確に ±0.5、
+// 45°（50g）の奇数倍の tan は正確に ±1 になる。tan は折り返した角で __bid128_tan を1回だけ呼ぶ
+typedef enum
+{
+    TRIG_SIN,
+    TRIG_COS,
+    TRIG_TAN
+} trig_fn_t;
+
+// 0〜1/8周の角 b の sin/cos（want_sin=false なら cos）
+static BID_UINT128 octant_sin_cos(BID_UINT128 b, bool want_sin, bool deg)
+{
+    if (d_is_zero(b))
+        return d_from_int(want_sin ? 0 : 1);
+    if (want_sin && deg && d_eq(b, d_from_int(30)))
+        return d_from_str("0.5");
+    // 1/8周では sin = cos なので同じ式で求めて値を揃える
+    if (d_eq(b, d_from_int(deg ? 45 : 50)))
+        want_sin = true;
+    BID_UINT128 r = b, res;
+    rpn_convert_angle_to_rad(&r);
+    if (want_sin)
+        eval_unary(__bid128_sin, __bid64_sin, &res, &r);
+    else
+        eval_unary(__bid128_cos, __bid64_cos, &res, &r);
+    return res;
+}
+
+// 0〜1/8周の角 b の tan
+static BID_UINT128 octant_tan(BID_UINT128 b, bool deg)
+{
+    if (d_is_zero(b))
+        return d_from_int(0);
+    if (d_eq(b, d_from_int(deg ? 45 : 50)))
+        return d_from_int(1);
+    BID_UINT128 r = b, res;
+    rpn_convert_angle_to_rad(&r);
+    eval_unary(__bid128_tan, __bid64_tan, &res, &r);
+    return res;
+}
+
+static BID_UINT128 trig_eval(trig_fn_t fn, BID_UINT128 x)
+{
+    BID_UINT128 res;
+    if (init_state.angle_mode == ANGLE_MODE_RAD)
+    {
+        if (fn == TRIG_SIN)
+            eval_unary(__bid128_sin, __bid64_sin, &res, &x);
+        else if (fn == TRIG_COS)
+            eval_unary(__bid128_cos, __bid64_cos, &res, &x);
+        else
+            eval_unary(__bid128_tan, __bid64_tan, &res, &x);
+        return res;
+    }
+    bool deg = (init_state.angle_mode == ANGLE_MODE_DEG);
+    BID_UINT128 full = d_from_int(deg ? 360 : 400);
+    const BID_UINT128 quarter = d_from_int(deg ? 90 : 100);
+    const BID_UINT128 eighth = d_from_int(deg ? 45 : 50);
+    // sin, tan は奇関数、cos は偶関数なので |x| で求めて最後に符号を戻す
+    bool neg = d_is_neg(x) && fn != TRIG_COS;
+    BID_UINT128 ax = d_abs(x), a;
+    __bid128_fmod(&a, &ax, &full); // 剰余は常に正確
+    int k = 0;                     // 象限
+    while (k < 3 && !d_lt(a, quarter))
+    {
+        a = d_sub(a, quarter); // 桁が減る方向なので正確
+        k++;
+    }
+    // 1/8周を超えたら余角 b = 1/4周 − a で求める（sin a = cos b）
+    bool co = d_gt(a, eighth);
+    BID_UINT128 b = co ? d_sub(quarter, a) : a;
+    bool odd = (k & 1) != 0;
+    if (fn == TRIG_TAN)
+    {
+        // tan の周期は半周。奇数象限は −1/tan a、余角は 1/tan b（90°/270° は ÷0）
+        BID_UINT128 t = octant_tan(b, deg);
+        if (co ^ odd)
+            t = d_div(d_from_int(1), t);
+        res = odd ? d_neg(t) : t;
+        return neg ? d_neg(res) : res;
+    }
+    // 象限 k での sin = {s, c, −s, −c}、cos = {c, −s, −c, s}
+    if (fn == TRIG_SIN)
+    {
+        BID_UINT128 s = octant_sin_cos(b, !odd ^ co, deg);
+        res = (k >= 2) ? d_neg(s) : s;
+    }
+    else
+    {
+        BID_UINT128 c = octant_sin_cos(b, odd ^ co, deg);
+        res = (k == 1 || k == 2) ? d_neg(c) : c;
+    }
+    return neg ? d_neg(res) : res;
+}
+
+void rpn_sin()
+{
+    if (complex_unary(c_sin, true))
+        return;
+    // 角度モードに応じて sin（DEG/GRAD は1周で正確に剰余をとる）
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    stack[0] = trig_eval(TRIG_SIN, stack[0]);
+    after_operation();
+}
+void rpn_cos()
+{
+    if (complex_unary(c_cos, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    stack[0] = trig_eval(TRIG_COS, stack[0]);
+    after_operation();
+}
+void rpn_tan()
+{
+    if (complex_unary(c_tan, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    stack[0] = trig_eval(TRIG_TAN, stack[0]);
+    after_operation();
+}
+
+// 追加単項・二項演算
+void rpn_cube()
+{
+    if (complex_unary(c_cube, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 t, res;
+    eval_binary(__bid128_mul, __bid64_mul, &t, &stack[0], &stack[0]);
+    eval_binary(__bid128_mul, __bid64_mul, &res, &t, &stack[0]);
+    stack[0] = res;
+    after_operation();
+}
+
+void rpn_cbrt()
+{
+    if (complex_unary(c_cbrt, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_cbrt, __bid64_cbrt, &stack[0], &stack[0]);
+    after_operation();
+}
+
+void rpn_exp()
+{
+    if (complex_unary(cplx_exp, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_exp, __bid64_exp, &stack[0], &stack[0]);
+    after_operation();
+}
+
+void rpn_exp10()
+{
+    if (complex_unary(cplx_exp10, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_exp10, __bid64_exp10, &stack[0], &stack[0]);
+    after_operation();
+}
+
+void rpn_fact()
+{
+    if (reject_complex(0x1u))
+        return;
+    // 整数は自前実装（精度改善）。非整数は x! = Γ(x + 1)
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+
+    BID_UINT128 x = stack[0];
     // 整数判定: round_integral_exact の INEXACT が立たないか
     _IDEC_flags saved = _IDEC_glbflags;
     _IDEC_glbflags = BID_EXACT_STATUS;
@@ -1598,6 +2471,9 @@ void rpn_fact()
                 bid128_quiet_less_equal(&le, &i, &n);
                 if (!le)
                     break;
+                // 取消し要求があれば結果を書き戻さずに中断
+                if (compute_cancel_requested())
+                    return;
                 __bid128_mul(&acc, &acc, &i);
                 // 途中で∞になったら打ち切り
                 int is_inf = 0;
@@ -1631,13 +2507,15 @@ void rpn_fact()
 
 void rpn_logxy()
 {
+    if (complex_binary(c_logxy, !is_negative(stack[0]) && !is_negative(stack[1])))
+        return;
     // log_x(y)
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
+    save_last_x();
     BID_UINT128 ln_y, ln_x, res;
-    __bid128_log(&ln_y, &stack[1]);
-    __bid128_log(&ln_x, &stack[0]);
-    __bid128_div(&res, &ln_y, &ln_x);
+    eval_unary(__bid128_log, __bid64_log, &ln_y, &stack[1]);
+    eval_unary(__bid128_log, __bid64_log, &ln_x, &stack[0]);
+    eval_binary(__bid128_div, __bid64_div, &res, &ln_y, &ln_x);
     stack_pop();
     stack[0] = res;
     after_operation();
@@ -1646,99 +2524,320 @@ void rpn_logxy()
 // 逆三角関数（結果は角度モードに合わせて出力: RADはそのまま、DEGは*180/pi、GRADは*200/pi）
 static void rpn_convert_angle_from_rad(BID_UINT128 *x)
 {
-    if (init_state.angle_mode == ANGLE_MODE_DEG)
-    {
-        BID_UINT128 k; // 180/pi
-        bid128_from_string(&k, "57.295779513082320876798154814105170332");
-        __bid128_mul(x, x, &k);
-    }
-    else if (init_state.angle_mode == ANGLE_MODE_GRAD)
-    {
-        BID_UINT128 k; // 200/pi
-        bid128_from_string(&k, "63.661977236758134307553505349005744814");
-        __bid128_mul(x, x, &k);
-    }
+    if (init_state.angle_mode == ANGLE_MODE_DEG)
+    {
+        BID_UINT128 k; // 180/pi
+        bid128_from_string(&k, "57.295779513082320876798154814105170332");
+        __bid128_mul(x, x, &k);
+    }
+    else if (init_state.angle_mode == ANGLE_MODE_GRAD)
+    {
+        BID_UINT128 k; // 200/pi
+        bid128_from_string(&k, "63.661977236758134307553505349005744814");
+        __bid128_mul(x, x, &k);
+    }
+}
+
+static cplx_t angle_from_rad_c(cplx_t z)
+{
+    rpn_convert_angle_from_rad(&z.re);
+    rpn_convert_angle_from_rad(&z.im);
+    return z;
+}
+static cplx_t c_asin(cplx_t z) { return angle_from_rad_c(cplx_asin(z)); }
+static cplx_t c_acos(cplx_t z) { return angle_from_rad_c(cplx_acos(z)); }
+static cplx_t c_atan(cplx_t z) { return angle_from_rad_c(cplx_atan(z)); }
+
+void rpn_asin()
+{
+    if (complex_unary(c_asin, within_unit(stack[0])))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 r;
+    eval_unary(__bid128_asin, __bid64_asin, &r, &stack[0]); // radians
+    rpn_convert_angle_from_rad(&r);
+    stack[0] = r;
+    after_operation();
+}
+
+void rpn_acos()
+{
+    if (complex_unary(c_acos, within_unit(stack[0])))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 r;
+    eval_unary(__bid128_acos, __bid64_acos, &r, &stack[0]); // radians
+    rpn_convert_angle_from_rad(&r);
+    stack[0] = r;
+    after_operation();
+}
+
+void rpn_atan()
+{
+    if (complex_unary(c_atan, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 r;
+    eval_unary(__bid128_atan, __bid64_atan, &r, &stack[0]); // radians
+    rpn_convert_angle_from_rad(&r);
+    stack[0] = r;
+    after_operation();
+}
+
+// 双曲線関数（角度モードは適用しない: 引数は無次元としてそのまま扱う）
+void rpn_sinh()
+{
+    if (complex_unary(cplx_sinh, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_sinh, __bid64_sinh, &stack[0], &stack[0]);
+    after_operation();
+}
+
+void rpn_cosh()
+{
+    if (complex_unary(cplx_cosh, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_cosh, __bid64_cosh, &stack[0], &stack[0]);
+    after_operation();
+}
+
+void rpn_tanh()
+{
+    if (complex_unary(cplx_tanh, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_tanh, __bid64_tanh, &stack[0], &stack[0]);
+    after_operation();
+}
+
+void rpn_asinh()
+{
+    if (complex_unary(cplx_asinh, true))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_asinh, __bid64_asinh, &stack[0], &stack[0]);
+    after_operation();
+}
+
+void rpn_acosh()
+{
+    if (complex_unary(cplx_acosh, !d_lt(stack[0], d_from_int(1))))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_acosh, __bid64_acosh, &stack[0], &stack[0]);
+    after_operation();
+}
+
+void rpn_atanh()
+{
+    if (complex_unary(cplx_atanh, within_unit(stack[0])))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    eval_unary(__bid128_atanh, __bid64_atanh, &stack[0], &stack[0]);
+    after_operation();
+}
+
+// 1回丸めのカーネルを使う演算（キー操作の組合せより速く、丸め誤差も1回分）
+// FMA: Z + Y·X（3つを消費して結果を X に）
+void rpn_fma(void)
+{
+    if (reject_complex(0x7u))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 res;
+    eval_fma(&res, &stack[1], &stack[0], &stack[2]);
+    stack_pop_raw();
+    stack_pop_raw();
+    stack[0] = res;
+    after_operation();
+}
+
+// R→P: X=x, Y=y → X=r, Y=θ（角度モードの単位）
+void rpn_to_polar(void)
+{
+    if (reject_complex(0x3u))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 r, theta;
+    eval_binary(__bid128_hypot, __bid64_hypot, &r, &stack[0], &stack[1]);
+    eval_binary(__bid128_atan2, __bid64_atan2, &theta, &stack[1], &stack[0]); // atan2(y, x)
+    rpn_convert_angle_from_rad(&theta);
+    stack[0] = r;
+    stack[1] = theta;
+    after_operation();
+}
+
+// P→R: X=r, Y=θ → X=x, Y=y
+void rpn_to_rect(void)
+{
+    if (reject_complex(0x3u))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 c = trig_eval(TRIG_COS, stack[1]);
+    BID_UINT128 s = trig_eval(TRIG_SIN, stack[1]);
+    BID_UINT128 x, y;
+    eval_binary(__bid128_mul, __bid64_mul, &x, &stack[0], &c);
+    eval_binary(__bid128_mul, __bid64_mul, &y, &stack[0], &s);
+    stack[0] = x;
+    stack[1] = y;
+    after_operation();
+}
+
+// ベクトル演算
+// 2D は T,Z = u、Y,X = v。3D は u レジスタ（rpn_vec_store_u で設定）と Z,Y,X = v
+// 結果がスカラーなら使った分だけスタックを下げて X に置く。作業精度に従う
+
+static BID_UINT128 dot3(BID_UINT128 a[3], BID_UINT128 b[3])
+{
+    BID_UINT128 r;
+    eval_binary(__bid128_mul, __bid64_mul, &r, &a[2], &b[2]);
+    eval_fma(&r, &a[1], &b[1], &r);
+    eval_fma(&r, &a[0], &b[0], &r);
+    return r;
+}
+
+// a·d − b·c（積の一方は fma の中で丸めない）
+static BID_UINT128 cross_term(BID_UINT128 a, BID_UINT128 d, BID_UINT128 b, BID_UINT128 c)
+{
+    BID_UINT128 r;
+    eval_binary(__bid128_mul, __bid64_mul, &r, &b, &c);
+    r = d_neg(r);
+    eval_fma(&r, &a, &d, &r);
+    return r;
 }
 
-void rpn_asin()
+void rpn_vec_norm2(void)
 {
+    if (reject_complex(0x3u))
+        return;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
+    save_last_x();
     BID_UINT128 r;
-    __bid128_asin(&r, &stack[0]); // radians
-    rpn_convert_angle_from_rad(&r);
+    eval_binary(__bid128_hypot, __bid64_hypot, &r, &stack[1], &stack[0]);
+    stack_pop_raw();
     stack[0] = r;
     after_operation();
 }
 
-void rpn_acos()
+void rpn_vec_norm3(void)
 {
+    if (reject_complex(0x7u))
+        return;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
+    save_last_x();
     BID_UINT128 r;
-    __bid128_acos(&r, &stack[0]); // radians
-    rpn_convert_angle_from_rad(&r);
+    eval_binary(__bid128_hypot, __bid64_hypot, &r, &stack[2], &stack[1]);
+    eval_binary(__bid128_hypot, __bid64_hypot, &r, &r, &stack[0]);
+    stack_pop_raw();
+    stack_pop_raw();
     stack[0] = r;
     after_operation();
 }
 
-void rpn_atan()
+void rpn_vec_dot2(void)
 {
+    if (reject_complex(0xFu))
+        return;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
+    save_last_x();
     BID_UINT128 r;
-    __bid128_atan(&r, &stack[0]); // radians
-    rpn_convert_angle_from_rad(&r);
+    eval_binary(__bid128_mul, __bid64_mul, &r, &stack[2], &stack[0]);
+    eval_fma(&r, &stack[3], &stack[1], &r);
+    stack_pop_raw();
+    stack_pop_raw();
+    stack_pop_raw();
     stack[0] = r;
     after_operation();
 }
 
-// 双曲線関数（角度モードは適用しない: 引数は無次元としてそのまま扱う）
-void rpn_sinh()
+// 2D の外積（z 成分）: u_x·v_y − u_y·v_x
+void rpn_vec_cross2(void)
 {
+    if (reject_complex(0xFu))
+        return;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_sinh(&stack[0], &stack[0]);
+    save_last_x();
+    BID_UINT128 r = cross_term(stack[3], stack[0], stack[2], stack[1]);
+    stack_pop_raw();
+    stack_pop_raw();
+    stack_pop_raw();
+    stack[0] = r;
     after_operation();
 }
 
-void rpn_cosh()
+// Z,Y,X を u レジスタへ（スタックはそのまま。統計レジスタと同様に Undo の対象外）
+void rpn_vec_store_u(void)
 {
+    if (reject_complex(0x7u))
+        return;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_cosh(&stack[0], &stack[0]);
+    save_last_x();
+    for (int i = 0; i < RPN_VEC_U_COUNT; ++i)
+        vec_u[i] = stack[2 - i];
     after_operation();
 }
 
-void rpn_tanh()
+void rpn_vec_dot3(void)
 {
+    if (reject_complex(0x7u))
+        return;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_tanh(&stack[0], &stack[0]);
+    save_last_x();
+    BID_UINT128 v[3] = {stack[2], stack[1], stack[0]};
+    BID_UINT128 r = dot3(vec_u, v);
+    stack_pop_raw();
+    stack_pop_raw();
+    stack[0] = r;
     after_operation();
 }
 
-void rpn_asinh()
+// u × v を Z,Y,X に（x,y,z 成分の順）
+void rpn_vec_cross3(void)
 {
+    if (reject_complex(0x7u))
+        return;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_asinh(&stack[0], &stack[0]);
+    save_last_x();
+    const BID_UINT128 *u = vec_u;
+    const BID_UINT128 v[3] = {stack[2], stack[1], stack[0]};
+    stack[2] = cross_term(u[1], v[2], u[2], v[1]);
+    stack[1] = cross_term(u[2], v[0], u[0], v[2]);
+    stack[0] = cross_term(u[0], v[1], u[1], v[0]);
     after_operation();
 }
 
-void rpn_acosh()
+// ln(1+x)、e^x−1（x が 0 に近くても桁落ちしない）
+void rpn_ln1p(void)
 {
+    if (reject_complex(0x1u))
+        return;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_acosh(&stack[0], &stack[0]);
+    save_last_x();
+    eval_unary(__bid128_log1p, __bid64_log1p, &stack[0], &stack[0]);
     after_operation();
 }
 
-void rpn_atanh()
+void rpn_expm1(void)
 {
+    if (reject_complex(0x1u))
+        return;
     undo_push_snapshot_if_enabled();
-    last_x = stack[0];
-    __bid128_atanh(&stack[0], &stack[0]);
+    save_last_x();
+    eval_unary(__bid128_expm1, __bid64_expm1, &stack[0], &stack[0]);
     after_operation();
 }
 
@@ -1751,6 +2850,7 @@ void rpn_last()
     }
     clear_input_state();
     stack[0] = last_x;
+    im_copy(0, IM_LAST);
     flag_state.push_flag = true;
     // 特殊値でもpushフラグ維持
 }
@@ -1787,6 +2887,17 @@ void rpn_set_hyperbolic_mode(hyperbolic_mode_t mode)
     init_state.hyperbolic_mode = mode;
     notify_changed();
 }
+// キー操作での切替（対話実行とマクロのヘッドレス実行で共通）
+void rpn_cycle_disp_mode(void)
+{
+    disp_mode_t m = init_state.disp_mode;
+    rpn_set_disp_mode(m == DISP_MODE_FRACTION ? DISP_MODE_NORMAL : (disp_mode_t)(m + 1));
+}
+void rpn_cycle_angle_mode(void)
+{
+    angle_mode_t a = init_state.angle_mode;
+    rpn_set_angle_mode(a == ANGLE_MODE_GRAD ? ANGLE_MODE_DEG : (angle_mode_t)(a + 1));
+}
 
 // #########################
 //  定数入力
@@ -1802,10 +2913,31 @@ void rpn_input_pi()
     clear_input_state();
     undo_push_snapshot_if_enabled();
     bid128_from_string(&stack[0], "3.1415926535897932384626433832795028842");
+    im_clear(0);
     // 定数は確定値として扱うので、次の数値入力で push されるようにする
     flag_state.push_flag = true;
 }
 
+void rpn_input_value(BID_UINT128 v)
+{
+    // 入力中の数値があれば先に確定（pushはしない）
+    if (input_state.input_len > 0)
+    {
+        update_x_from_input_if_valid();
+        flag_state.push_flag = true;
+    }
+    if (flag_state.push_flag)
+    {
+        undo_push_snapshot_if_enabled();
+        stack_push_raw();
+    }
+    clear_input_state();
+    stack[0] = v;
+    im_clear(0);
+    // 確定値として扱い、次の値は push される
+    flag_state.push_flag = true;
+}
+
 void rpn_input_e()
 {
     if (flag_state.push_flag)
@@ -1816,9 +2948,374 @@ void rpn_input_e()
     clear_input_state();
     undo_push_snapshot_if_enabled();
     bid128_from_string(&stack[0], "2.7182818284590452353602874713526624978");
+    im_clear(0);
+    flag_state.push_flag = true;
+}
+
+// #########################
+//  統計（Σ+/Σ−）
+// #########################
+// 総和をそのまま積み上げると Σx² - (Σx)²/n で桁落ちするため、
+// Welford法で平均と偏差平方和/偏差積和を保持し、総和は要求時に n·x̄ などから求める
+enum
+{
+    STAT_N,
+    STAT_MEAN_X,
+    STAT_MEAN_Y,
+    STAT_SXX, // Σ(x-x̄)²
+    STAT_SYY, // Σ(y-ȳ)²
+    STAT_SXY, // Σ(x-x̄)(y-ȳ)
+};
+
+static void stat_clear_all(void)
+{
+    for (int i = 0; i < RPN_STAT_REG_COUNT; ++i)
+        bid128_from_string(&stat_reg[i], "0");
+}
+
+// 1組を追加（remove=true なら取り除く）。n が0以下になる場合は false
+static bool stat_accumulate(BID_UINT128 x, BID_UINT128 y, bool remove)
+{
+    BID_UINT128 one, n, dx, dy, t, u;
+    bid128_from_string(&one, "1");
+    if (!remove)
+    {
+        __bid128_add(&n, &stat_reg[STAT_N], &one);
+        // x̄ₙ = x̄ₙ₋₁ + (x - x̄ₙ₋₁)/n
+        __bid128_sub(&dx, &x, &stat_reg[STAT_MEAN_X]);
+        __bid128_sub(&dy, &y, &stat_reg[STAT_MEAN_Y]);
+        __bid128_div(&t, &dx, &n);
+        __bid128_add(&stat_reg[STAT_MEAN_X], &stat_reg[STAT_MEAN_X], &t);
+        __bid128_div(&t, &dy, &n);
+        __bid128_add(&stat_reg[STAT_MEAN_Y], &stat_reg[STAT_MEAN_Y], &t);
+        // Sxxₙ = Sxxₙ₋₁ + (x - x̄ₙ₋₁)(x - x̄ₙ)、Sxy は (x - x̄ₙ₋₁)(y - ȳₙ)
+        __bid128_sub(&t, &x, &stat_reg[STAT_MEAN_X]);
+        __bid128_sub(&u, &y, &stat_reg[STAT_MEAN_Y]);
+        __bid128_fma(&stat_reg[STAT_SXX], &dx, &t, &stat_reg[STAT_SXX]);
+        __bid128_fma(&stat_reg[STAT_SYY], &dy, &u, &stat_reg[STAT_SYY]);
+        __bid128_fma(&stat_reg[STAT_SXY], &dx, &u, &stat_reg[STAT_SXY]);
+        stat_reg[STAT_N] = n;
+        return true;
+    }
+
+    __bid128_sub(&n, &stat_reg[STAT_N], &one);
+    int negative = 0, empty = 0;
+    BID_UINT128 zero;
+    bid128_from_string(&zero, "0");
+    __bid128_quiet_less(&negative, &n, &zero);
+    if (negative)
+        return false; // データが無い
+    __bid128_quiet_equal(&empty, &n, &zero);
+    if (empty)
+    {
+        // 最後の1組を除いたら初期状態に戻す（誤差を残さない）
+        stat_clear_all();
+        return true;
+    }
+    // 追加の逆算: x̄ₙ₋₁ = x̄ₙ - (x - x̄ₙ)/(n-1)
+    BID_UINT128 dxn, dyn;
+    __bid128_sub(&dxn, &x, &stat_reg[STAT_MEAN_X]);
+    __bid128_sub(&dyn, &y, &stat_reg[STAT_MEAN_Y]);
+    __bid128_div(&t, &dxn, &n);
+    __bid128_sub(&stat_reg[STAT_MEAN_X], &stat_reg[STAT_MEAN_X], &t);
+    __bid128_div(&t, &dyn, &n);
+    __bid128_sub(&stat_reg[STAT_MEAN_Y], &stat_reg[STAT_MEAN_Y], &t);
+    // Sxxₙ₋₁ = Sxxₙ - (x - x̄ₙ₋₁)(x - x̄ₙ)
+    __bid128_sub(&dx, &x, &stat_reg[STAT_MEAN_X]);
+    __bid128_sub(&dy, &y, &stat_reg[STAT_MEAN_Y]);
+    __bid128_negate(&dx, &dx);
+    __bid128_negate(&dy, &dy);
+    __bid128_fma(&stat_reg[STAT_SXX], &dx, &dxn, &stat_reg[STAT_SXX]);
+    __bid128_fma(&stat_reg[STAT_SYY], &dy, &dyn, &stat_reg[STAT_SYY]);
+    __bid128_fma(&stat_reg[STAT_SXY], &dx, &dyn, &stat_reg[STAT_SXY]);
+    stat_reg[STAT_N] = n;
+    return true;
+}
+
+// 結果をスタックへ積む（pi/e と同様、push無効時はXを上書き）
+static void stat_push_result(BID_UINT128 v)
+{
+    if (input_state.input_len > 0)
+    {
+        update_x_from_input_if_valid();
+        flag_state.push_flag = true;
+    }
+    if (flag_state.push_flag)
+        stack_push_raw();
+    stack[0] = v;
+    im_clear(0);
     flag_state.push_flag = true;
 }
 
+// 2値の結果を Y←y, X←x として積む
+static void stat_push_pair(BID_UINT128 x, BID_UINT128 y)
+{
+    stat_push_result(y);
+    stat_push_result(x);
+}
+
+// 偏差平方和を割って平方根を取る（標本: n-1、母: n）
+static void stat_deviation(bool sample, BID_UINT128 *sx, BID_UINT128 *sy)
+{
+    BID_UINT128 d = stat_reg[STAT_N];
+    if (sample)
+    {
+        BID_UINT128 one;
+        bid128_from_string(&one, "1");
+        __bid128_sub(&d, &d, &one);
+    }
+    __bid128_div(sx, &stat_reg[STAT_SXX], &d);
+    __bid128_sqrt(sx, sx);
+    __bid128_div(sy, &stat_reg[STAT_SYY], &d);
+    __bid128_sqrt(sy, sy);
+}
+
+// データが min_n 組に満たなければスタックを変えずに無効演算とする
+static bool stat_reject_short(int min_n)
+{
+    if (rpn_stat_count() >= min_n)
+        return false;
+    reject_operation();
+    return true;
+}
+
+// 回帰直線 y = a·x + b
+static void stat_regression(BID_UINT128 *a, BID_UINT128 *b)
+{
+    __bid128_div(a, &stat_reg[STAT_SXY], &stat_reg[STAT_SXX]);
+    BID_UINT128 t;
+    __bid128_negate(&t, a);
+    __bid128_fma(b, &t, &stat_reg[STAT_MEAN_X], &stat_reg[STAT_MEAN_Y]); // ȳ - a·x̄
+}
+
+void rpn_stat_add(void)
+{
+    if (reject_complex(0x3u))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    stat_accumulate(stack[0], stack[1], false);
+    stack[0] = stat_reg[STAT_N];
+    after_operation();
+    // 続けて次のデータを入力できるよう、次の数値は n を上書きする
+    flag_state.push_flag = false;
+}
+
+void rpn_stat_sub(void)
+{
+    if (reject_complex(0x3u) || stat_reject_short(1))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    stat_accumulate(stack[0], stack[1], true);
+    stack[0] = stat_reg[STAT_N];
+    after_operation();
+    flag_state.push_flag = false;
+}
+
+void rpn_stat_mean(void)
+{
+    if (stat_reject_short(1))
+        return;
+    undo_push_snapshot_if_enabled();
+    stat_push_pair(stat_reg[STAT_MEAN_X], stat_reg[STAT_MEAN_Y]);
+    after_operation();
+}
+
+void rpn_stat_sdev(void)
+{
+    if (stat_reject_short(2))
+        return;
+    undo_push_snapshot_if_enabled();
+    BID_UINT128 sx, sy;
+    stat_deviation(true, &sx, &sy);
+    stat_push_pair(sx, sy);
+    after_operation();
+}
+
+void rpn_stat_pdev(void)
+{
+    if (stat_reject_short(1))
+        return;
+    undo_push_snapshot_if_enabled();
+    BID_UINT128 sx, sy;
+    stat_deviation(false, &sx, &sy);
+    stat_push_pair(sx, sy);
+    after_operation();
+}
+
+void rpn_stat_linreg(void)
+{
+    if (stat_reject_short(2))
+        return;
+    undo_push_snapshot_if_enabled();
+    BID_UINT128 a, b;
+    stat_regression(&a, &b);
+    stat_push_pair(b, a);
+    after_operation();
+}
+
+void rpn_stat_estimate(void)
+{
+    if (reject_complex(0x1u) || stat_reject_short(2))
+        return;
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    BID_UINT128 a, b;
+    stat_regression(&a, &b);
+    __bid128_fma(&stack[0], &a, &stack[0], &b);
+    after_operation();
+}
+
+void rpn_stat_corr(void)
+{
+    if (stat_reject_short(2))
+        return;
+    undo_push_snapshot_if_enabled();
+    // r = Sxy / √(Sxx·Syy)
+    BID_UINT128 t, r;
+    __bid128_mul(&t, &stat_reg[STAT_SXX], &stat_reg[STAT_SYY]);
+    __bid128_sqrt(&t, &t);
+    __bid128_div(&r, &stat_reg[STAT_SXY], &t);
+    stat_push_result(r);
+    after_operation();
+}
+
+void rpn_stat_recall(rpn_stat_sum_t which)
+{
+    undo_push_snapshot_if_enabled();
+    BID_UINT128 *n = &stat_reg[STAT_N];
+    BID_UINT128 v, t;
+    switch (which)
+    {
+    case RPN_STAT_SUM_X: // n·x̄
+        __bid128_mul(&v, n, &stat_reg[STAT_MEAN_X]);
+        break;
+    case RPN_STAT_SUM_Y:
+        __bid128_mul(&v, n, &stat_reg[STAT_MEAN_Y]);
+        break;
+    case RPN_STAT_SUM_X2: // Sxx + n·x̄²
+        __bid128_mul(&t, n, &stat_reg[STAT_MEAN_X]);
+        __bid128_fma(&v, &t, &stat_reg[STAT_MEAN_X], &stat_reg[STAT_SXX]);
+        break;
+    case RPN_STAT_SUM_Y2:
+        __bid128_mul(&t, n, &stat_reg[STAT_MEAN_Y]);
+        __bid128_fma(&v, &t, &stat_reg[STAT_MEAN_Y], &stat_reg[STAT_SYY]);
+        break;
+    case RPN_STAT_SUM_XY: // Sxy + n·x̄·ȳ
+        __bid128_mul(&t, n, &stat_reg[STAT_MEAN_X]);
+        __bid128_fma(&v, &t, &stat_reg[STAT_MEAN_Y], &stat_reg[STAT_SXY]);
+        break;
+    case RPN_STAT_N:
+    default:
+        v = *n;
+        break;
+    }
+    stat_push_result(v);
+    after_operation();
+}
+
+// u を Z,Y,X に呼び出す（3つ積む。統計レジスタの呼出しと同じ積み方）
+void rpn_vec_recall_u(void)
+{
+    undo_push_snapshot_if_enabled();
+    for (int i = 0; i < RPN_VEC_U_COUNT; ++i)
+        stat_push_result(vec_u[i]);
+    after_operation();
+}
+
+int rpn_stat_count(void)
+{
+    int n = 0;
+    __bid128_to_int32_int(&n, &stat_reg[STAT_N]);
+    return n;
+}
+
+// #########################
+//  データリスト（中央値/四分位/百分位）
+// #########################
+void rpn_list_add(void)
+{
+    if (reject_complex(0x1u))
+        return;
+    // 満杯ならスタックと Undo 履歴を変えずに無効演算とする
+    if (datalist_count() >= DATALIST_MAX)
+    {
+        reject_operation();
+        return;
+    }
+    undo_push_snapshot_if_enabled();
+    datalist_append(stack[0]);
+    save_last_x();
+    int n = datalist_count();
+    __bid128_from_int32(&stack[0], &n);
+    after_operation();
+    // Σ+ と同じく、次の数値はデータ数を上書きする
+    flag_state.push_flag = false;
+}
+
+// 分位点（p は 0..1）。データが無ければ NaN
+static BID_UINT128 list_quantile(BID_UINT128 p)
+{
+    BID_UINT128 v;
+    if (!datalist_quantile(p, &v))
+    {
+        _IDEC_glbflags |= BID_INVALID_EXCEPTION;
+        bid128_from_string(&v, "NaN");
+    }
+    return v;
+}
+
+// データが無ければスタックを変えずに無効演算とする（Σ 系の stat_reject_short と同じ扱い）
+static bool list_reject_empty(void)
+{
+    if (datalist_count() > 0)
+        return false;
+    reject_operation();
+    return true;
+}
+
+// quarters/4 の分位点を積む（0.25/0.5/0.75 は10進で正確）
+static void list_push_quantile(int quarters)
+{
+    if (list_reject_empty())
+        return;
+    undo_push_snapshot_if_enabled();
+    BID_UINT128 p = d_div(d_from_int(quarters), d_from_int(4));
+    stat_push_result(list_quantile(p));
+    after_operation();
+}
+
+void rpn_list_median(void) { list_push_quantile(2); }
+void rpn_list_q1(void) { list_push_quantile(1); }
+void rpn_list_q3(void) { list_push_quantile(3); }
+
+void rpn_list_percentile(void)
+{
+    if (reject_complex(0x1u) || list_reject_empty())
+        return;
+    // p = X/100 が 0..1 の外（NaN を含む）ならスタックを変えずに無効演算とする
+    BID_UINT128 p = d_div(stack[0], d_from_int(100));
+    BID_UINT128 zero = d_from_int(0), one = d_from_int(1);
+    int ge0 = 0, le1 = 0;
+    __bid128_quiet_greater_equal(&ge0, &p, &zero);
+    __bid128_quiet_less_equal(&le1, &p, &one);
+    if (!ge0 || !le1)
+    {
+        reject_operation();
+        return;
+    }
+    undo_push_snapshot_if_enabled();
+    save_last_x();
+    stack[0] = list_quantile(p);
+    after_operation();
+}
+
+void rpn_list_sort(void)
+{
+    datalist_sort();
+}
+
 // 設定保存（電源OFF直前にmainから呼ぶ）
 void rpn_settings_maybe_save()
 {
@@ -1856,6 +3353,14 @@ void rpn_undo()
     stack[1] = undo_buf[idx].y;
     stack[2] = undo_buf[idx].z;
     stack[3] = undo_buf[idx].t;
+    im_mask &= (uint16_t)~IM_STACK_BITS;
+    if (undo_im_slot[idx] != UNDO_NO_IM)
+    {
+        const int slot = undo_im_slot[idx];
+        for (int i = 0; i < 4; ++i)
+            im_reg[i] = undo_im_pool[slot].im[i];
+        im_mask |= undo_im_pool[slot].mask;
+    }
     undo_pos = idx;
     clear_input_state();
     flag_state.push_flag = true;
@@ -1871,6 +3376,72 @@ void rpn_undo_capture_boundary(void)
     undo_push_snapshot_if_enabled();
 }
 
+void rpn_undo_suspend(bool suspend)
+{
+    undo_suspended = suspend;
+}
+
+// 取消し用: 演算開始前の状態（Undo無効時やマクロ再生中も保持する）
+static struct
+{
+    undo_entry_t stack;
+    BID_UINT128 last_x;
+    BID_UINT128 stat[RPN_STAT_REG_COUNT];
+    BID_UINT128 vars[6];
+    BID_UINT128 vec_u[RPN_VEC_U_COUNT];
+    BID_UINT128 im[RPN_IM_REG_COUNT];
+    uint16_t im_mask;
+    input_state_t input;
+    flag_state_t flag;
+    uint32_t undo_push_count;
+} cancel_snapshot;
+
+void rpn_cancel_snapshot(void)
+{
+    cancel_snapshot.stack.x = stack[0];
+    cancel_snapshot.stack.y = stack[1];
+    cancel_snapshot.stack.z = stack[2];
+    cancel_snapshot.stack.t = stack[3];
+    cancel_snapshot.last_x = last_x;
+    memcpy(cancel_snapshot.stat, stat_reg, sizeof(stat_reg));
+    memcpy(cancel_snapshot.vars, vars_mem, sizeof(vars_mem));
+    memcpy(cancel_snapshot.vec_u, vec_u, sizeof(vec_u));
+    memcpy(cancel_snapshot.im, im_reg, sizeof(im_reg));
+    cancel_snapshot.im_mask = im_mask;
+    cancel_snapshot.input = input_state;
+    cancel_snapshot.flag = flag_state;
+    cancel_snapshot.undo_push_count = undo_push_count;
+}
+
+void rpn_cancel_restore(void)
+{
+    stack[0] = cancel_snapshot.stack.x;
+    stack[1] = cancel_snapshot.stack.y;
+    stack[2] = cancel_snapshot.stack.z;
+    stack[3] = cancel_snapshot.stack.t;
+    last_x = cancel_snapshot.last_x;
+    memcpy(stat_reg, cancel_snapshot.stat, sizeof(stat_reg));
+    memcpy(vars_mem, cancel_snapshot.vars, sizeof(vars_mem));
+    memcpy(vec_u, cancel_snapshot.vec_u, sizeof(vec_u));
+    memcpy(im_reg, cancel_snapshot.im, sizeof(im_reg));
+    im_mask = cancel_snapshot.im_mask;
+    input_state = cancel_snapshot.input;
+    flag_state = cancel_snapshot.flag;
+    // 取消した演算が積んだUndoスナップショットは捨てる（先頭が演算前のスタック）
+    int dropped = (int)(undo_push_count - cancel_snapshot.undo_push_count);
+    if (dropped > undo_len)
+        dropped = undo_len;
+    if (dropped > 0)
+    {
+        undo_len -= dropped;
+        undo_pos = undo_len;
+    }
+    undo_push_count = cancel_snapshot.undo_push_count;
+    // 中断した演算の例外フラグは残さない
+    _IDEC_glbflags = BID_EXACT_STATUS;
+    key_set_shift_state(false);
+}
+
 void rpn_reset_stack_only(void)
 {
     bid128_from_string(&last_x, "0");
@@ -1878,6 +3449,7 @@ void rpn_reset_stack_only(void)
     bid128_from_string(&stack[1], "0");
     bid128_from_string(&stack[2], "0");
     bid128_from_string(&stack[3], "0");
+    im_mask &= (uint16_t)~(IM_STACK_BITS | (1u << IM_LAST));
     clear_input_state();
     flag_state.push_flag = false;
     undo_clear_all();
@@ -1886,7 +3458,17 @@ void rpn_reset_stack_only(void)
 void rpn_reset_vars_only(void)
 {
     for (int i = 0; i < 6; ++i)
+    {
         bid128_from_string(&vars_mem[i], "0");
+        im_clear(IM_VAR0 + i);
+    }
+    for (int i = 0; i < RPN_VEC_U_COUNT; ++i)
+        bid128_from_string(&vec_u[i], "0");
+}
+
+void rpn_reset_stats(void)
+{
+    stat_clear_all();
 }
 
 void rpn_reset_memory(void)
@@ -1906,6 +3488,26 @@ void rpn_get_state(rpn_state_t *out)
     out->last_x = last_x;
     for (int i = 0; i < 6; ++i)
         out->vars[i] = vars_mem[i];
+    for (int i = 0; i < RPN_STAT_REG_COUNT; ++i)
+        out->stat[i] = stat_reg[i];
+    for (int i = 0; i < RPN_VEC_U_COUNT; ++i)
+        out->vec_u[i] = vec_u[i];
+    // 実数のレジスタは虚部 0（レジュームでは 0 のレジスタを書かない）
+    for (int i = 0; i < RPN_IM_REG_COUNT; ++i)
+        out->im[i] = im_get(i);
+    // 区間演算モードは保存しないので、区間は中点として保存する
+    if (g_interval)
+    {
+        BID_UINT128 *base[RPN_IM_REG_COUNT] = {&out->x, &out->y, &out->z, &out->t, &out->last_x,
+                                               &out->vars[0], &out->vars[1], &out->vars[2],
+                                               &out->vars[3], &out->vars[4], &out->vars[5]};
+        for (int i = 0; i < RPN_IM_REG_COUNT; ++i)
+        {
+            if (im_has(i))
+                rpn_interval_mid_rad(*base[i], im_reg[i], base[i], NULL);
+            out->im[i] = d_from_int(0);
+        }
+    }
 }
 
 void rpn_set_state(const rpn_state_t *st)
@@ -1919,6 +3521,13 @@ void rpn_set_state(const rpn_state_t *st)
     last_x = st->last_x;
     for (int i = 0; i < 6; ++i)
         vars_mem[i] = st->vars[i];
+    for (int i = 0; i < RPN_STAT_REG_COUNT; ++i)
+        stat_reg[i] = st->stat[i];
+    for (int i = 0; i < RPN_VEC_U_COUNT; ++i)
+        vec_u[i] = st->vec_u[i];
+    im_mask = 0;
+    for (int i = 0; i < RPN_IM_REG_COUNT; ++i)
+        im_set(i, st->im[i]);
     clear_input_state();
     flag_state.push_flag = true;
     undo_clear_all();
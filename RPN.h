@@ -42,7 +42,8 @@ extern "C"
     {
         DISP_MODE_NORMAL,
         DISP_MODE_SCIENTIFIC,
-        DISP_MODE_ENGINEERING
+        DISP_MODE_ENGINEERING,
+        DISP_MODE_FRACTION // 分数表示（四則と 1/x は分子/分母で正確に計算）
     } disp_mode_t;
 
     // 小数部末尾ゼロの表示モード
@@ -87,6 +88,8 @@ extern "C"
     BID_UINT128 rpn_stack_t();
     // Xレジスタを直接設定（入力状態はクリア）
     void rpn_set_x(BID_UINT128 x);
+    // X,Y,Z,T をまとめて設定（Undo記録なし、次の入力は push される）
+    void rpn_load_stack(BID_UINT128 x, BID_UINT128 y, BID_UINT128 z, BID_UINT128 t);
 
     // 変数操作（VA..VF）
     typedef enum
@@ -162,15 +165,51 @@ extern "C"
     void rpn_acosh();
     void rpn_atanh();
     void rpn_last(); // LAST X をXに復帰
+    // 1回丸めの複合演算（実数のみ）
+    void rpn_fma(void);      // Z + Y·X
+    void rpn_to_polar(void); // R→P: X=x, Y=y → X=r, Y=θ
+    void rpn_to_rect(void);  // P→R: X=r, Y=θ → X=x, Y=y
+    void rpn_ln1p(void);     // ln(1+x)
+    void rpn_expm1(void);    // e^x − 1
+    // ベクトル（2D: u=T,Z v=Y,X / 3D: u=u レジスタ v=Z,Y,X。成分は x,y(,z) の順に入力）
+#define RPN_VEC_U_COUNT 3
+    void rpn_vec_norm2(void);    // |(Y,X)|
+    void rpn_vec_norm3(void);    // |(Z,Y,X)|
+    void rpn_vec_dot2(void);     // u·v → X
+    void rpn_vec_cross2(void);   // u×v の z 成分 → X
+    void rpn_vec_store_u(void);  // Z,Y,X → u レジスタ
+    void rpn_vec_recall_u(void); // u → Z,Y,X
+    void rpn_vec_dot3(void);     // u·v → X
+    void rpn_vec_cross3(void);   // u×v → Z,Y,X
+
+    // 複素数（X,Y,Z,T, LAST X, VA..VF の各レジスタが実部と虚部を持てる）
+#define RPN_IM_REG_COUNT 11 // 虚部レジスタ数: X,Y,Z,T, LAST X, VA..VF
+    // COMPLEX: 実数 Y,X から Y+iX を作る。X が複素数なら Y←実部, X←虚部 に分ける
+    void rpn_complex(void);
+    // スタック level(0=X..3=T) の虚部を取得。実数なら false（区間演算モード中は常に false）
+    bool rpn_stack_im(int level, BID_UINT128 *im);
+
+    // 区間演算モード: 各レジスタが [下端, 上端] を持ち、四則・1/x・√・x² を切下げ/切上げの2回で計算する
+    // 他の演算は区間を受け付けない（点値には従来どおり）。COMPLEX キーで Y,X から区間を作る/分ける。
+    // モードは保存しない（電源OFF時の区間は中点としてレジュームされる）。
+    // ON にすると複素数の虚部は捨て、OFF にすると区間は中点になる
+    bool rpn_get_interval_mode(void);
+    void rpn_set_interval_mode(bool on);
+    // スタック level の区間を取得。点値なら false
+    bool rpn_stack_interval(int level, BID_UINT128 *lo, BID_UINT128 *hi);
+    // 区間の中点と半径（半径は切上げで区間を必ず覆う）
+    void rpn_interval_mid_rad(BID_UINT128 lo, BID_UINT128 hi, BID_UINT128 *mid, BID_UINT128 *rad);
     // Undo（スタック全体復帰。Lastキー設定がUndoのとき使用）
     void rpn_undo();
     // 定数入力
     void rpn_input_pi(); // π
     void rpn_input_e();  // e
+    void rpn_input_value(BID_UINT128 v); // 確定値を入力（前の値は必要ならpush）
 
     // 設定アクセス（表示モード）
     void rpn_set_disp_mode(disp_mode_t mode);
     disp_mode_t rpn_get_disp_mode();
+    void rpn_cycle_disp_mode(void); // DISP キー: NORMAL→…→FRACTION→NORMAL
 
     // 設定アクセス（末尾ゼロ表示モード）
     void rpn_set_zero_mode(zero_mode_t mode);
@@ -179,6 +218,7 @@ extern "C"
     // 設定アクセス（角度/双曲線モード）
     void rpn_set_angle_mode(angle_mode_t mode);
     angle_mode_t rpn_get_angle_mode();
+    void rpn_cycle_angle_mode(void); // MODE キー（マクロ記録中）: DEG→RAD→GRAD→DEG
     void rpn_set_hyperbolic_mode(hyperbolic_mode_t mode);
     hyperbolic_mode_t rpn_get_hyperbolic_mode();
 
@@ -192,18 +232,60 @@ extern "C"
     void rpn_undo_clear(void);
     // マクロ開始直前などユーザ境界で明示的にキャプチャ
     void rpn_undo_capture_boundary(void);
+    // ソルバ等が内部でマクロを繰り返し実行する間、Undo記録を止める
+    void rpn_undo_suspend(bool suspend);
+
+    // 演算の取消し: 実行前に状態を退避し、取消されたら演算前の状態に戻す
+    // 対象はスタック/Last X/統計/変数 A..F（虚部を含む）/入力状態。データリストと行列は含まない
+    void rpn_cancel_snapshot(void);
+    void rpn_cancel_restore(void);
 
     // リセット系（Resetサブメニュー用）
     void rpn_reset_stack_only(void); // X,Y,Z,T と Last X、入力状態、Undo クリア
-    void rpn_reset_vars_only(void);  // 変数A..F のみクリア
+    void rpn_reset_vars_only(void);  // 変数A..F と u ベクトルのみクリア
     void rpn_reset_memory(void);     // Stack + Vars をクリア
 
+    // 統計（Σ+/Σ−）
+    // n と平均・偏差平方和・偏差積和を逐次更新する（Welford法、記憶量はデータ数によらず一定）
+    typedef enum
+    {
+        RPN_STAT_N,
+        RPN_STAT_SUM_X,
+        RPN_STAT_SUM_Y,
+        RPN_STAT_SUM_X2,
+        RPN_STAT_SUM_Y2,
+        RPN_STAT_SUM_XY,
+    } rpn_stat_sum_t;
+#define RPN_STAT_REG_COUNT 6
+    void rpn_stat_add(void);      // Σ+: (x,y)=(X,Y) を追加し X←n（次の入力は n を上書き）
+    void rpn_stat_sub(void);      // Σ−: (X,Y) を取り除き X←n
+    void rpn_stat_mean(void);     // X←x̄, Y←ȳ
+    void rpn_stat_sdev(void);     // 標本標準偏差 X←sx, Y←sy
+    void rpn_stat_pdev(void);     // 母標準偏差 X←σx, Y←σy
+    void rpn_stat_linreg(void);   // 回帰直線 y=a·x+b: X←b（切片）, Y←a（傾き）
+    void rpn_stat_estimate(void); // X←ŷ = a·X + b
+    void rpn_stat_corr(void);     // X←r（相関係数）
+    void rpn_stat_recall(rpn_stat_sum_t which); // n, Σx, Σy, Σx², Σy², Σxy をXへ
+    void rpn_reset_stats(void);   // 統計レジスタのみクリア
+    int rpn_stat_count(void);     // 現在のデータ数（表示用）
+
+    // データリスト統計（datalist に標本を保持）
+    void rpn_list_add(void);        // X をリストに追加し X←データ数（次の入力は上書き）
+    void rpn_list_median(void);     // X←中央値
+    void rpn_list_q1(void);         // X←第1四分位
+    void rpn_list_q3(void);         // X←第3四分位
+    void rpn_list_percentile(void); // X(0..100) を百分位の値に置換
+    void rpn_list_sort(void);       // リストを昇順に並べ替え
+
     // レジューム用にRPN状態を取得/設定
     typedef struct
     {
         BID_UINT128 x, y, z, t;
         BID_UINT128 last_x;
         BID_UINT128 vars[6];
+        BID_UINT128 stat[RPN_STAT_REG_COUNT]; // 統計アキュムレータ（n, x̄, ȳ, Sxx, Syy, Sxy）
+        BID_UINT128 im[RPN_IM_REG_COUNT];     // 虚部（実数なら 0）
+        BID_UINT128 vec_u[RPN_VEC_U_COUNT];   // 3D ベクトル演算の u
     } rpn_state_t;
     void rpn_get_state(rpn_state_t *out);
     void rpn_set_state(const rpn_state_t *st);
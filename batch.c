@@ -0,0 +1,348 @@
+// シリアル経由の一括計算（1行 = 1バッチ、空白区切りのRPNトークン）
+// 例: "3 4 + sqrt" → "OK 2.645751311064590590501615753639260"
+// 応答: 行末で "OK <X>\t<Y>\t<所要時間us>"、
+//       解釈できないトークンは "ERR <token>"（その行の残りは捨てる）
+// 表示形式の指定トークン（norm/sci/eng, fix0..fix9/fixall, deg/rad/grad）で
+// 外部の回帰コーパス実行ツールから整形結果を表示モードごとに照合できる
+#include "batch.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "RPN.h"
+#include "compute.h"
+#include "settings.h"
+
+#if RPN35_SERIAL_BATCH
+
+// 1回の呼び出しで読む最大文字数（メインループのキー処理を止めないため）
+#define BATCH_CHARS_PER_POLL 32
+// 1トークンの最大長
+#define BATCH_TOKEN_MAX 48
+
+typedef struct
+{
+    const char *name;
+    compute_op_t op; // core1 で実行する演算
+} batch_op_t;
+
+static const batch_op_t s_ops[] = {
+    {"+", rpn_add},
+    {"-", rpn_sub},
+    {"*", rpn_mul},
+    {"/", rpn_div},
+    {"sqrt", rpn_sqrt},
+    {"sq", rpn_pow2},
+    {"cube", rpn_cube},
+    {"cbrt", rpn_cbrt},
+    {"root", rpn_nth_root},
+    {"pow", rpn_pow},
+    {"^", rpn_pow},
+    {"log", rpn_log},
+    {"ln", rpn_ln},
+    {"logxy", rpn_logxy},
+    {"exp", rpn_exp},
+    {"exp10", rpn_exp10},
+    {"!", rpn_fact},
+    {"fact", rpn_fact},
+    {"inv", rpn_rev},
+    {"sin", rpn_sin},
+    {"cos", rpn_cos},
+    {"tan", rpn_tan},
+    {"asin", rpn_asin},
+    {"acos", rpn_acos},
+    {"atan", rpn_atan},
+    {"sinh", rpn_sinh},
+    {"cosh", rpn_cosh},
+    {"tanh", rpn_tanh},
+    {"asinh", rpn_asinh},
+    {"acosh", rpn_acosh},
+    {"atanh", rpn_atanh},
+    {"s+", rpn_stat_add},
+    {"s-", rpn_stat_sub},
+    {"mean", rpn_stat_mean},
+    {"sdev", rpn_stat_sdev},
+    {"pdev", rpn_stat_pdev},
+    {"lr", rpn_stat_linreg},
+    {"yhat", rpn_stat_estimate},
+    {"corr", rpn_stat_corr},
+    {"l+", rpn_list_add},
+    {"median", rpn_list_median},
+    {"q1", rpn_list_q1},
+    {"q3", rpn_list_q3},
+    {"pctl", rpn_list_percentile},
+    {"cplx", rpn_complex},
+    {"fma", rpn_fma},
+    {"r>p", rpn_to_polar},
+    {"p>r", rpn_to_rect},
+    {"ln1p", rpn_ln1p},
+    {"expm1", rpn_expm1},
+    {"norm2", rpn_vec_norm2},
+    {"norm3", rpn_vec_norm3},
+    {"dot2", rpn_vec_dot2},
+    {"cross2", rpn_vec_cross2},
+    {"u=", rpn_vec_store_u},
+    {"u", rpn_vec_recall_u},
+    {"dot3", rpn_vec_dot3},
+    {"cross3", rpn_vec_cross3},
+};
+
+// core0 側で完結するスタック操作
+typedef struct
+{
+    const char *name;
+    void (*fn)(void);
+} batch_stack_op_t;
+
+static void stack_enter(void) { rpn_enter(); }
+static void stack_swap(void)
+{
+    rpn_commit_input_without_push();
+    rpn_swap();
+}
+static void stack_roll_down(void)
+{
+    rpn_commit_input_without_push();
+    rpn_roll_down();
+}
+static void stack_roll_up(void)
+{
+    rpn_commit_input_without_push();
+    rpn_roll_up();
+}
+
+static void stat_count(void) { rpn_stat_recall(RPN_STAT_N); }
+
+static const batch_stack_op_t s_stack_ops[] = {
+    {"enter", stack_enter},
+    {"swap", stack_swap},
+    {"rdn", stack_roll_down},
+    {"rup", stack_roll_up},
+    {"clx", rpn_clear_x},
+    {"last", rpn_last},
+    {"n", stat_count},
+    {"clst", rpn_reset_stats},
+    {"undo", rpn_undo},
+    {"pi", rpn_input_pi},
+    {"e", rpn_input_e},
+};
+
+// 表示/角度モードの切替（設定メニューと同じく保存対象になる）
+static void mode_norm(void) { rpn_set_disp_mode(DISP_MODE_NORMAL); }
+static void mode_sci(void) { rpn_set_disp_mode(DISP_MODE_SCIENTIFIC); }
+static void mode_eng(void) { rpn_set_disp_mode(DISP_MODE_ENGINEERING); }
+static void mode_frac(void) { rpn_set_disp_mode(DISP_MODE_FRACTION); }
+static void mode_deg(void) { rpn_set_angle_mode(ANGLE_MODE_DEG); }
+static void mode_rad(void) { rpn_set_angle_mode(ANGLE_MODE_RAD); }
+static void mode_grad(void) { rpn_set_angle_mode(ANGLE_MODE_GRAD); }
+static void mode_fix_all(void) { settings_set_digits(-1); }
+static void mode_complex(void) { settings_set_complex_results(true); }
+static void mode_real(void) { settings_set_complex_results(false); }
+static void mode_p34(void) { settings_set_precision(PRECISION_34); }
+static void mode_p16(void) { settings_set_precision(PRECISION_16); }
+static void mode_interval(void) { rpn_set_interval_mode(true); }
+static void mode_point(void) { rpn_set_interval_mode(false); }
+
+static const batch_stack_op_t s_mode_ops[] = {
+    {"norm", mode_norm},
+    {"sci", mode_sci},
+    {"eng", mode_eng},
+    {"frac", mode_frac},
+    {"deg", mode_deg},
+    {"rad", mode_rad},
+    {"grad", mode_grad},
+    {"fixall", mode_fix_all},
+    {"cpx", mode_complex},
+    {"real", mode_real},
+    {"ivl", mode_interval},
+    {"pnt", mode_point},
+    {"p34", mode_p34},
+    {"p16", mode_p16},
+};
+
+static char g_token[BATCH_TOKEN_MAX + 1];
+static int g_token_len = 0;
+static bool g_in_line = false;   // 行の途中（トークンを1つ以上受信済み）
+static bool g_skip_line = false; // エラー後、行末まで読み捨て中
+static bool g_skip_token = false; // 長すぎるトークンを次の区切りまで読み捨て中
+static uint64_t g_line_start_us = 0;
+
+static bool is_number_token(const char *t)
+{
+    const char *p = t;
+    if (*p == '+' || *p == '-')
+        ++p;
+    if (!((*p >= '0' && *p <= '9') || *p == '.'))
+        return false;
+    for (; *p; ++p)
+    {
+        char c = *p;
+        if (!((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-'))
+            return false;
+    }
+    return true;
+}
+
+bool batch_run_token(const char *t)
+{
+    if (is_number_token(t))
+    {
+        BID_UINT128 v;
+        bid128_from_string(&v, (char *)t);
+        int is_nan = 0;
+        __bid128_isNaN(&is_nan, &v);
+        if (is_nan)
+            return false;
+        rpn_input_value(v);
+        return true;
+    }
+    for (size_t i = 0; i < sizeof(s_ops) / sizeof(s_ops[0]); ++i)
+    {
+        if (strcmp(t, s_ops[i].name) == 0)
+        {
+            rpn_cancel_snapshot();
+            if (!compute_run(s_ops[i].op))
+            {
+                rpn_cancel_restore();
+                printf("ERR canceled\n");
+                g_skip_line = true;
+            }
+            return true;
+        }
+    }
+    for (size_t i = 0; i < sizeof(s_stack_ops) / sizeof(s_stack_ops[0]); ++i)
+    {
+        if (strcmp(t, s_stack_ops[i].name) == 0)
+        {
+            s_stack_ops[i].fn();
+            return true;
+        }
+    }
+    for (size_t i = 0; i < sizeof(s_mode_ops) / sizeof(s_mode_ops[0]); ++i)
+    {
+        if (strcmp(t, s_mode_ops[i].name) == 0)
+        {
+            s_mode_ops[i].fn();
+            return true;
+        }
+    }
+    // fix0..fix9: 小数桁数
+    if (strncmp(t, "fix", 3) == 0 && t[3] >= '0' && t[3] <= '9' && t[4] == '\0')
+    {
+        settings_set_digits((int8_t)(t[3] - '0'));
+        return true;
+    }
+    return false;
+}
+
+static void flush_token(void)
+{
+    if (g_token_len == 0)
+        return;
+    g_token[g_token_len] = '\0';
+    g_token_len = 0;
+    if (!g_in_line)
+        g_line_start_us = time_us_64();
+    g_in_line = true;
+    if (g_skip_line)
+        return;
+    if (!batch_run_token(g_token))
+    {
+        printf("ERR %s\n", g_token);
+        g_skip_line = true;
+    }
+}
+
+// 複素数は "3+4i"、区間は "[1.4,1.5]" の形
+void batch_format_level(int level, char *out, size_t size)
+{
+    char r[40], i[40];
+    BID_UINT128 re = (level == 0) ? rpn_stack_x() : rpn_stack_y();
+    BID_UINT128 im;
+    bid128_to_str(re, r, sizeof(r));
+    if (rpn_stack_interval(level, NULL, &im))
+    {
+        bid128_to_str(im, i, sizeof(i));
+        snprintf(out, size, "[%s,%s]", r, i);
+        return;
+    }
+    if (!rpn_stack_im(level, &im))
+    {
+        snprintf(out, size, "%s", r);
+        return;
+    }
+    bid128_to_str(im, i, sizeof(i));
+    snprintf(out, size, "%s%s%si", r, i[0] == '-' ? "" : "+", i);
+}
+
+// 行末: 結果を返す。戻り値: バッチを1つ終えたら true
+static bool end_line(void)
+{
+    flush_token();
+    bool had_line = g_in_line;
+    if (had_line && !g_skip_line)
+    {
+        uint32_t us = (uint32_t)(time_us_64() - g_line_start_us);
+        char x[84], y[84];
+        batch_format_level(0, x, sizeof(x));
+        batch_format_level(1, y, sizeof(y));
+        printf("OK %s\t%s\t%lu\n", x, y, (unsigned long)us);
+    }
+    g_in_line = false;
+    g_skip_line = false;
+    return had_line;
+}
+
+void batch_init(void)
+{
+    stdio_init_all();
+}
+
+bool batch_poll(void)
+{
+    bool done = false;
+    for (int i = 0; i < BATCH_CHARS_PER_POLL; ++i)
+    {
+        int c = getchar_timeout_us(0);
+        if (c == PICO_ERROR_TIMEOUT || c < 0)
+            break;
+        if (c == '\n' || c == '\r')
+        {
+            g_skip_token = false;
+            done = end_line() || done;
+        }
+        else if (c == ' ' || c == '\t')
+        {
+            g_skip_token = false;
+            flush_token();
+        }
+        else if (g_skip_token)
+        {
+            continue;
+        }
+        else if (g_token_len < BATCH_TOKEN_MAX)
+        {
+            g_token[g_token_len++] = (char)c;
+        }
+        else
+        {
+            // 長すぎるトークンはエラー扱い（1回だけ返し、残りは次の区切りまで捨てる）
+            g_token_len = 0;
+            if (!g_skip_line)
+                printf("ERR token too long\n");
+            g_in_line = true;
+            g_skip_line = true;
+            g_skip_token = true;
+        }
+        // 1行の処理を終えたら LCD 更新のため一旦戻る
+        if (done)
+            break;
+    }
+    return done;
+}
+
+#else
+
+void batch_init(void) {}
+bool batch_poll(void) { return false; }
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// シリアル(stdio)から RPN トークン列を受け付ける（0で無効）
+#ifndef RPN35_SERIAL_BATCH
+#define RPN35_SERIAL_BATCH 0
+#endif
+
+    // 受信を開始する（stdio 初期化を含む）
+    void batch_init(void);
+
+    // メインループから毎回呼ぶ。受信済みの文字を少しずつ処理し、
+    // トークンが揃ったものから実行する。LCD には触れない。
+    // 戻り値: 1行（バッチ）の処理を終えたら true（呼び出し側で再描画する）
+    bool batch_poll(void);
+
+#if RPN35_SERIAL_BATCH
+    // 1トークンを実行する（ホスト側の回帰コーパス実行ツール tools/rpn_corpus.c からも使う）
+    // 戻り値: 解釈できたら true
+    bool batch_run_token(const char *token);
+
+    // スタック level（0=X, 1=Y）を応答と同じ形式で文字列化する
+    void batch_format_level(int level, char *out, size_t size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BATCH_H
@@ -0,0 +1,109 @@
+#ifndef BID_OPS_H
+#define BID_OPS_H
+
+// BID128 の値渡しラッパ（反復アルゴリズムを式として書くため）
+// 例外フラグは __bid128_* と同じく _IDEC_glbflags に積まれる
+#include <stdbool.h>
+#include "RPN.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    static inline BID_UINT128 d_from_str(const char *s)
+    {
+        BID_UINT128 r;
+        bid128_from_string(&r, (char *)s);
+        return r;
+    }
+    static inline BID_UINT128 d_from_int(int v)
+    {
+        BID_UINT128 r;
+        __bid128_from_int32(&r, &v);
+        return r;
+    }
+    static inline BID_UINT128 d_add(BID_UINT128 a, BID_UINT128 b)
+    {
+        BID_UINT128 r;
+        __bid128_add(&r, &a, &b);
+        return r;
+    }
+    static inline BID_UINT128 d_sub(BID_UINT128 a, BID_UINT128 b)
+    {
+        BID_UINT128 r;
+        __bid128_sub(&r, &a, &b);
+        return r;
+    }
+    static inline BID_UINT128 d_mul(BID_UINT128 a, BID_UINT128 b)
+    {
+        BID_UINT128 r;
+        __bid128_mul(&r, &a, &b);
+        return r;
+    }
+    static inline BID_UINT128 d_div(BID_UINT128 a, BID_UINT128 b)
+    {
+        BID_UINT128 r;
+        __bid128_div(&r, &a, &b);
+        return r;
+    }
+    static inline BID_UINT128 d_fma(BID_UINT128 a, BID_UINT128 b, BID_UINT128 c)
+    {
+        BID_UINT128 r;
+        __bid128_fma(&r, &a, &b, &c); // a·b + c（丸め1回）
+        return r;
+    }
+    static inline BID_UINT128 d_abs(BID_UINT128 a)
+    {
+        BID_UINT128 r;
+        __bid128_abs(&r, &a);
+        return r;
+    }
+    static inline BID_UINT128 d_neg(BID_UINT128 a)
+    {
+        BID_UINT128 r;
+        __bid128_negate(&r, &a);
+        return r;
+    }
+    static inline bool d_lt(BID_UINT128 a, BID_UINT128 b)
+    {
+        int r = 0;
+        __bid128_quiet_less(&r, &a, &b);
+        return r != 0;
+    }
+    static inline bool d_gt(BID_UINT128 a, BID_UINT128 b)
+    {
+        int r = 0;
+        __bid128_quiet_greater(&r, &a, &b);
+        return r != 0;
+    }
+    static inline bool d_eq(BID_UINT128 a, BID_UINT128 b)
+    {
+        int r = 0;
+        __bid128_quiet_equal(&r, &a, &b);
+        return r != 0;
+    }
+    static inline bool d_is_zero(BID_UINT128 a)
+    {
+        int r = 0;
+        __bid128_isZero(&r, &a);
+        return r != 0;
+    }
+    static inline bool d_is_neg(BID_UINT128 a)
+    {
+        int r = 0;
+        __bid128_isSigned(&r, &a);
+        return r != 0;
+    }
+    static inline bool d_is_finite(BID_UINT128 a)
+    {
+        int r = 0;
+        __bid128_isFinite(&r, &a);
+        return r != 0;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BID_OPS_H
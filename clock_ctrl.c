@@ -2,6 +2,7 @@
 #include "hardware/clocks.h"
 #include "hardware/pll.h"
 #include "clock_ctrl.h"
+#include "energy.h"
 
 // 即時ブースト: 12MHz動作に切替
 void clockctrl_boost_now(void)
@@ -23,6 +24,7 @@ void clockctrl_boost_now(void)
 
     pll_deinit(pll_usb);
     pll_deinit(pll_sys);
+    energy_set_clock(ENERGY_CLK_BOOST);
 }
 
 // 低速クロックへ
@@ -41,6 +43,7 @@ void clockctrl_enter_low_power(void)
 
     pll_deinit(pll_usb);
     pll_deinit(pll_sys);
+    energy_set_clock(ENERGY_CLK_1MHZ);
 }
 
 // 高速クロックへ
@@ -58,4 +61,5 @@ void clockctrl_enter_high_speed_12mhz(void)
 
     pll_deinit(pll_usb);
     pll_deinit(pll_sys);
+    energy_set_clock(ENERGY_CLK_12MHZ);
 }
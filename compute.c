@@ -0,0 +1,184 @@
+// 演算コア(core1)への処理委譲
+// core0: キー走査/表示/フラッシュ保存、core1: 十進演算（__bid128_*）
+#include "compute.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+#include "LCD.h"
+#include "key.h"
+#include "profile.h"
+#include "trace.h"
+#include "RPN.h"
+#include "macro.h"
+#include "settings.h"
+
+// BID128 の超越関数はスタック消費が大きいので既定(2KB)より大きく確保する
+#define COMPUTE_STACK_WORDS (8u * 1024u / 4u)
+// 完了通知（FIFO に返す値）
+#define COMPUTE_DONE_TOKEN 0xC0DE0001u
+// この時間を超えたらビジー表示を出す
+#define BUSY_INDICATOR_DELAY_US 100000u
+#define BUSY_INDICATOR_PERIOD_US 150000u
+// ビジー表示位置（下段右端、マクロインジケータと同じ位置）
+#define BUSY_INDICATOR_ROW 1
+#define BUSY_INDICATOR_COL 15
+
+static uint32_t s_core1_stack[COMPUTE_STACK_WORDS];
+static bool g_started = false;
+static volatile bool g_busy = false;
+static volatile bool g_cancel = false;
+static volatile uint32_t g_last_cycles = 0;
+// 進捗（core1 が書き、core0 の待機ループが表示する）
+static const char *volatile g_progress_label = NULL;
+static volatile uint32_t g_progress_value = 0;
+
+// core1: FIFO から演算を受け取って実行し、完了を返す
+static void core1_main(void)
+{
+    // フラッシュ書込み中は core0 から停止させられるようにする
+    // （RP2350 のロックアウトはドアベルを使うので FIFO はメールボックス専用にできる）
+    multicore_lockout_victim_init();
+    profile_init();
+    while (1)
+    {
+        compute_op_t op = (compute_op_t)(uintptr_t)multicore_fifo_pop_blocking();
+        // 演算中に core0 は十進演算を呼ばないので、_IDEC_glbflags 等の
+        // グローバル状態（after_operation の前提）は core1 だけが触る
+        uint32_t t0 = profile_cycles();
+        if (op)
+            op();
+        g_last_cycles = profile_cycles() - t0;
+        // 結果（スタック等）を書き終えてから完了を通知する
+        __dmb();
+        multicore_fifo_push_blocking(COMPUTE_DONE_TOKEN);
+    }
+}
+
+void compute_init(void)
+{
+    if (g_started)
+        return;
+    multicore_fifo_drain();
+    multicore_launch_core1_with_stack(core1_main, s_core1_stack, sizeof(s_core1_stack));
+    g_started = true;
+}
+
+bool compute_run(compute_op_t op)
+{
+    if (!op)
+        return true;
+    g_cancel = false;
+    if (!g_started)
+    {
+        uint32_t t0 = profile_cycles();
+        op();
+        g_last_cycles = profile_cycles() - t0;
+        return true;
+    }
+
+    g_busy = true;
+    g_progress_label = NULL;
+    // 入力確定などの core0 側の書込みを core1 から見えるようにしてから渡す
+    __dmb();
+    multicore_fifo_push_blocking((uint32_t)(uintptr_t)op);
+
+    // 0x5C は LCD の CGROM では円記号なので '\' は使わない
+    static const char frames[] = {'|', '/', '-', '*'};
+    int frame = 0;
+    uint64_t next_us = time_us_64() + BUSY_INDICATOR_DELAY_US;
+    uint32_t shown_value = 0;
+    const char *shown_label = NULL;
+    while (!multicore_fifo_rvalid())
+    {
+        // 取消しキーは演算側のチェックポイントで検出される
+        if (!g_cancel && key_take_cancel())
+            g_cancel = true;
+        uint64_t now = time_us_64();
+        if (now >= next_us)
+        {
+            lcd_set_cursor(BUSY_INDICATOR_ROW, BUSY_INDICATOR_COL);
+            lcd_write(&frames[frame], 1);
+            // 進捗は表示周期ごとに変化があったときだけ書く
+            const char *label = g_progress_label;
+            uint32_t value = g_progress_value;
+            if (label && (label != shown_label || value != shown_value))
+            {
+                char line[17];
+                snprintf(line, sizeof(line), "%-10s%6lu", label, (unsigned long)value);
+                lcd_set_cursor(0, 0);
+                lcd_write(line, 16);
+                shown_label = label;
+                shown_value = value;
+            }
+            frame = (frame + 1) % (int)sizeof(frames);
+            next_us = now + BUSY_INDICATOR_PERIOD_US;
+        }
+        // core1 の FIFO 書込み(SEV)かキー走査タイマ割込みで起床する
+        __wfe();
+    }
+    (void)multicore_fifo_pop_blocking();
+    __dmb();
+    g_busy = false;
+    return !g_cancel;
+}
+
+// 完了した演算のサイクル数とトレースを残す
+static void record_op(const char *name)
+{
+    // 作業精度ごとに分けて集計（16桁の速度差を比較できるように）
+    profile_record_tagged(name, settings_get_precision() == PRECISION_16 ? "16" : NULL, compute_last_cycles());
+    trace_log(TRACE_OP, 0, (uint16_t)rpn_get_last_exceptions());
+}
+
+bool compute_run_op(compute_op_t op, const char *name)
+{
+    rpn_cancel_snapshot();
+    if (compute_run(op))
+    {
+        record_op(name);
+        return true;
+    }
+    trace_log(TRACE_OP, 1, 0);
+    rpn_cancel_restore();
+    // マクロ再生中なら残りの手順も打ち切る
+    macro_cancel_play();
+    lcd_write_line(0, "");
+    lcd_write_line(1, "    Canceled    ");
+    sleep_ms(500);
+    return false;
+}
+
+void compute_run_op_committed(compute_op_t op, const char *name)
+{
+    // 取消しのチェックポイントを持たない演算なので、戻り値に関わらず最後まで実行されている
+    bool done = compute_run(op);
+    record_op(name);
+    if (done)
+        return;
+    macro_cancel_play();
+    lcd_write_line(0, "");
+    lcd_write_line(1, "  Can't cancel  ");
+    sleep_ms(500);
+}
+
+uint32_t compute_last_cycles(void)
+{
+    return g_last_cycles;
+}
+
+void compute_set_progress(const char *label, uint32_t value)
+{
+    g_progress_value = value;
+    g_progress_label = label;
+}
+
+bool compute_cancel_requested(void)
+{
+    return g_cancel;
+}
+
+bool compute_is_busy(void)
+{
+    return g_busy;
+}
@@ -0,0 +1,53 @@
+#ifndef COMPUTE_H
+#define COMPUTE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // 演算処理（RPN.c の rpn_* 演算など、引数なしで完結するもの）
+    typedef void (*compute_op_t)(void);
+
+    // core1 を演算専用コアとして起動する（フラッシュ書込みより前に呼ぶこと）
+    void compute_init(void);
+
+    // op を core1 で実行し、完了まで待つ。
+    // 待機中も core0 はキー走査を続け、一定時間を超えたらビジー表示を出す。
+    // core1 未起動時は呼び出し元で直接実行する
+    // 戻り値: DEL/OFF で取消されたら false（状態の復元は呼び出し側で行う）
+    bool compute_run(compute_op_t op);
+
+    // スタック演算を compute_run で実行し、キー/メニュー共通の後処理を行う（core0 から呼ぶ）
+    // 完了: name でサイクル数を記録しトレースに残す
+    // 取消し: 実行前のスタックに戻し、マクロ再生を打ち切って "Canceled" を表示する
+    // 戻り値: 完了したら true
+    bool compute_run_op(compute_op_t op, const char *name);
+
+    // データリストや行列を書き換える演算用（これらは取消し時に戻せない）
+    // 演算は途中で打ち切らずに最後まで実行し、取消しキーが押されていたら結果を残したまま
+    // "Can't cancel" を表示する
+    void compute_run_op_committed(compute_op_t op, const char *name);
+
+    // 反復演算のチェックポイントで呼ぶ。取消し要求があれば true を返すので、
+    // 演算側は結果を書き戻さずに直ちに戻ること
+    bool compute_cancel_requested(void);
+
+    // 長い演算（ソルバ等）の進捗を待機中の表示に渡す（core1 から呼ぶ）
+    // label は静的な文字列。上段に "label value" を表示する
+    void compute_set_progress(const char *label, uint32_t value);
+
+    // 直近に実行した演算のサイクル数（実行したコアのDWTで計測）
+    uint32_t compute_last_cycles(void);
+
+    // 演算実行中なら true
+    bool compute_is_busy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMPUTE_H
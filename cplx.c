@@ -0,0 +1,337 @@
+// 複素数演算（BID128）
+// 実部と虚部を別々の BID128 で持ち、初等関数は実関数の組合せで求める。
+// 実軸上の分岐（実引数で定義域外）は実関数で直接求めて桁落ちと符号の曖昧さを避ける
+#include "cplx.h"
+#include "bid_ops.h"
+
+#define CPLX_PI_2 "1.570796326794896619231321691639751"
+#define CPLX_LN10 "2.302585092994045684017991454684364"
+// 整数乗を二乗法で計算する指数の上限（これを超えると exp/ln 経由）
+#define CPLX_POW_INT_MAX 1024
+
+static BID_UINT128 d_sqrt(BID_UINT128 x)
+{
+    BID_UINT128 r;
+    __bid128_sqrt(&r, &x);
+    return r;
+}
+static BID_UINT128 d_exp(BID_UINT128 x)
+{
+    BID_UINT128 r;
+    __bid128_exp(&r, &x);
+    return r;
+}
+static BID_UINT128 d_ln(BID_UINT128 x)
+{
+    BID_UINT128 r;
+    __bid128_log(&r, &x);
+    return r;
+}
+static BID_UINT128 d_sin(BID_UINT128 x)
+{
+    BID_UINT128 r;
+    __bid128_sin(&r, &x);
+    return r;
+}
+static BID_UINT128 d_cos(BID_UINT128 x)
+{
+    BID_UINT128 r;
+    __bid128_cos(&r, &x);
+    return r;
+}
+static BID_UINT128 d_sinh(BID_UINT128 x)
+{
+    BID_UINT128 r;
+    __bid128_sinh(&r, &x);
+    return r;
+}
+static BID_UINT128 d_cosh(BID_UINT128 x)
+{
+    BID_UINT128 r;
+    __bid128_cosh(&r, &x);
+    return r;
+}
+
+static inline BID_UINT128 d_zero(void) { return d_from_int(0); }
+
+cplx_t cplx_make(BID_UINT128 re, BID_UINT128 im)
+{
+    cplx_t z = {re, im};
+    return z;
+}
+
+bool cplx_is_real(cplx_t z)
+{
+    return d_is_zero(z.im);
+}
+
+static cplx_t real_c(BID_UINT128 re)
+{
+    return cplx_make(re, d_zero());
+}
+
+cplx_t cplx_add(cplx_t a, cplx_t b)
+{
+    return cplx_make(d_add(a.re, b.re), d_add(a.im, b.im));
+}
+
+cplx_t cplx_sub(cplx_t a, cplx_t b)
+{
+    return cplx_make(d_sub(a.re, b.re), d_sub(a.im, b.im));
+}
+
+cplx_t cplx_mul(cplx_t a, cplx_t b)
+{
+    // 交差項は fma で丸めを1回に抑える
+    BID_UINT128 re = d_fma(a.re, b.re, d_neg(d_mul(a.im, b.im)));
+    BID_UINT128 im = d_fma(a.re, b.im, d_mul(a.im, b.re));
+    return cplx_make(re, im);
+}
+
+cplx_t cplx_div(cplx_t a, cplx_t b)
+{
+    // Smith の方法（|c|,|d| の大きい方で割って途中のオーバーフローを避ける）
+    BID_UINT128 c = b.re, d = b.im;
+    if (d_is_zero(c) && d_is_zero(d))
+        return cplx_make(d_div(a.re, c), d_div(a.im, c)); // 0除算のフラグと∞/NaNをそのまま返す
+    if (d_is_zero(d))
+        return cplx_make(d_div(a.re, c), d_div(a.im, c));
+    if (!d_lt(d_abs(c), d_abs(d)))
+    {
+        BID_UINT128 r = d_div(d, c);
+        BID_UINT128 den = d_fma(d, r, c);
+        return cplx_make(d_div(d_fma(a.im, r, a.re), den), d_div(d_sub(a.im, d_mul(a.re, r)), den));
+    }
+    BID_UINT128 r = d_div(c, d);
+    BID_UINT128 den = d_fma(c, r, d);
+    return cplx_make(d_div(d_fma(a.re, r, a.im), den), d_div(d_sub(d_mul(a.im, r), a.re), den));
+}
+
+cplx_t cplx_neg(cplx_t z)
+{
+    return cplx_make(d_neg(z.re), d_neg(z.im));
+}
+
+cplx_t cplx_recip(cplx_t z)
+{
+    return cplx_div(real_c(d_from_int(1)), z);
+}
+
+cplx_t cplx_scale(cplx_t z, BID_UINT128 k)
+{
+    return cplx_make(d_mul(z.re, k), d_mul(z.im, k));
+}
+
+BID_UINT128 cplx_abs(cplx_t z)
+{
+    BID_UINT128 r;
+    __bid128_hypot(&r, &z.re, &z.im);
+    return r;
+}
+
+BID_UINT128 cplx_arg(cplx_t z)
+{
+    // 虚部の -0 は +0 とみなす（負の実数の偏角は +π）
+    BID_UINT128 im = d_is_zero(z.im) ? d_zero() : z.im;
+    BID_UINT128 r;
+    __bid128_atan2(&r, &im, &z.re);
+    return r;
+}
+
+cplx_t cplx_sqrt(cplx_t z)
+{
+    if (d_is_zero(z.re) && d_is_zero(z.im))
+        return real_c(d_zero());
+    BID_UINT128 half = d_from_str("0.5");
+    BID_UINT128 r = cplx_abs(z);
+    if (!d_lt(z.re, d_zero()))
+    {
+        // t = √((|z|+x)/2), 虚部 = y/(2t)
+        BID_UINT128 t = d_sqrt(d_mul(half, d_add(r, z.re)));
+        return cplx_make(t, d_div(d_mul(half, z.im), t));
+    }
+    // x<0 は |z|-x 側で求めて桁落ちを避ける
+    BID_UINT128 t = d_sqrt(d_mul(half, d_sub(r, z.re)));
+    BID_UINT128 re = d_div(d_mul(half, d_abs(z.im)), t);
+    return cplx_make(re, d_lt(z.im, d_zero()) ? d_neg(t) : t);
+}
+
+cplx_t cplx_exp(cplx_t z)
+{
+    BID_UINT128 ea = d_exp(z.re);
+    if (d_is_zero(z.im))
+        return real_c(ea);
+    return cplx_make(d_mul(ea, d_cos(z.im)), d_mul(ea, d_sin(z.im)));
+}
+
+cplx_t cplx_ln(cplx_t z)
+{
+    return cplx_make(d_ln(cplx_abs(z)), cplx_arg(z));
+}
+
+cplx_t cplx_log10(cplx_t z)
+{
+    BID_UINT128 ln10 = d_from_str(CPLX_LN10);
+    cplx_t l = cplx_ln(z);
+    return cplx_make(d_div(l.re, ln10), d_div(l.im, ln10));
+}
+
+cplx_t cplx_exp10(cplx_t z)
+{
+    return cplx_exp(cplx_scale(z, d_from_str(CPLX_LN10)));
+}
+
+// 指数が小さい整数なら *n に入れて true（例外フラグは汚さない）
+static bool small_integer(BID_UINT128 x, int *n)
+{
+    if (!d_is_finite(x))
+        return false;
+    _IDEC_flags saved = _IDEC_glbflags;
+    int v = 0;
+    __bid128_to_int32_int(&v, &x);
+    bool ok = ((_IDEC_glbflags & BID_INVALID_EXCEPTION) == 0) && d_eq(d_from_int(v), x);
+    _IDEC_glbflags = saved;
+    if (!ok || v > CPLX_POW_INT_MAX || v < -CPLX_POW_INT_MAX)
+        return false;
+    *n = v;
+    return true;
+}
+
+cplx_t cplx_pow(cplx_t base, cplx_t expo)
+{
+    int n;
+    if (d_is_zero(expo.im) && small_integer(expo.re, &n))
+    {
+        // 二乗法（(1+i)² = 2i のような値を丸め誤差なしで得る）
+        unsigned k = (unsigned)(n < 0 ? -n : n);
+        cplx_t acc = real_c(d_from_int(1));
+        cplx_t p = base;
+        while (k)
+        {
+            if (k & 1u)
+                acc = cplx_mul(acc, p);
+            k >>= 1;
+            if (k)
+                p = cplx_mul(p, p);
+        }
+        return (n < 0) ? cplx_recip(acc) : acc;
+    }
+    if (d_is_zero(base.re) && d_is_zero(base.im) && d_gt(expo.re, d_zero()))
+        return real_c(d_zero());
+    return cplx_exp(cplx_mul(expo, cplx_ln(base)));
+}
+
+cplx_t cplx_sin(cplx_t z)
+{
+    // sin(a+bi) = sin a·cosh b + i·cos a·sinh b
+    return cplx_make(d_mul(d_sin(z.re), d_cosh(z.im)), d_mul(d_cos(z.re), d_sinh(z.im)));
+}
+
+cplx_t cplx_cos(cplx_t z)
+{
+    // cos(a+bi) = cos a·cosh b - i·sin a·sinh b
+    return cplx_make(d_mul(d_cos(z.re), d_cosh(z.im)), d_neg(d_mul(d_sin(z.re), d_sinh(z.im))));
+}
+
+cplx_t cplx_tan(cplx_t z)
+{
+    // tan(a+bi) = (sin 2a + i·sinh 2b) / (cos 2a + cosh 2b)
+    BID_UINT128 a2 = d_add(z.re, z.re), b2 = d_add(z.im, z.im);
+    BID_UINT128 den = d_add(d_cos(a2), d_cosh(b2));
+    if (!d_is_finite(den))
+        return cplx_make(d_zero(), d_from_int(d_is_neg(z.im) ? -1 : 1)); // |b| が大きいと ±i に収束
+    return cplx_make(d_div(d_sin(a2), den), d_div(d_sinh(b2), den));
+}
+
+cplx_t cplx_sinh(cplx_t z)
+{
+    // sinh(a+bi) = sinh a·cos b + i·cosh a·sin b
+    return cplx_make(d_mul(d_sinh(z.re), d_cos(z.im)), d_mul(d_cosh(z.re), d_sin(z.im)));
+}
+
+cplx_t cplx_cosh(cplx_t z)
+{
+    return cplx_make(d_mul(d_cosh(z.re), d_cos(z.im)), d_mul(d_sinh(z.re), d_sin(z.im)));
+}
+
+cplx_t cplx_tanh(cplx_t z)
+{
+    // tanh(a+bi) = (sinh 2a + i·sin 2b) / (cosh 2a + cos 2b)
+    BID_UINT128 a2 = d_add(z.re, z.re), b2 = d_add(z.im, z.im);
+    BID_UINT128 den = d_add(d_cosh(a2), d_cos(b2));
+    if (!d_is_finite(den))
+        return real_c(d_from_int(d_is_neg(z.re) ? -1 : 1));
+    return cplx_make(d_div(d_sinh(a2), den), d_div(d_sin(b2), den));
+}
+
+// 左半平面（虚軸の下半分を含む）なら奇関数の性質で右側に折り返す
+static bool left_side(cplx_t z)
+{
+    return d_lt(z.re, d_zero()) || (d_is_zero(z.re) && d_lt(z.im, d_zero()));
+}
+
+cplx_t cplx_asin(cplx_t z)
+{
+    if (d_is_zero(z.im) && d_gt(d_abs(z.re), d_from_int(1)))
+    {
+        // 実数 |x|>1: ±π/2 + i·acosh|x|
+        BID_UINT128 ax = d_abs(z.re), im;
+        __bid128_acosh(&im, &ax);
+        BID_UINT128 re = d_from_str(CPLX_PI_2);
+        return cplx_make(d_is_neg(z.re) ? d_neg(re) : re, im);
+    }
+    if (left_side(z))
+        return cplx_neg(cplx_asin(cplx_neg(z)));
+    // asin z = -i·ln(iz + √(1-z²))
+    cplx_t one = real_c(d_from_int(1));
+    cplx_t iz = cplx_make(d_neg(z.im), z.re);
+    cplx_t l = cplx_ln(cplx_add(iz, cplx_sqrt(cplx_sub(one, cplx_mul(z, z)))));
+    return cplx_make(l.im, d_neg(l.re));
+}
+
+cplx_t cplx_acos(cplx_t z)
+{
+    // acos z = π/2 - asin z
+    cplx_t s = cplx_asin(z);
+    return cplx_make(d_sub(d_from_str(CPLX_PI_2), s.re), d_neg(s.im));
+}
+
+cplx_t cplx_atan(cplx_t z)
+{
+    // atan z = (i/2)·[ln(1 - iz) - ln(1 + iz)]
+    BID_UINT128 one = d_from_int(1), half = d_from_str("0.5");
+    cplx_t l = cplx_sub(cplx_ln(cplx_make(d_add(one, z.im), d_neg(z.re))),
+                        cplx_ln(cplx_make(d_sub(one, z.im), z.re)));
+    return cplx_make(d_neg(d_mul(half, l.im)), d_mul(half, l.re));
+}
+
+cplx_t cplx_asinh(cplx_t z)
+{
+    if (left_side(z))
+        return cplx_neg(cplx_asinh(cplx_neg(z)));
+    // asinh z = ln(z + √(z²+1))
+    cplx_t one = real_c(d_from_int(1));
+    return cplx_ln(cplx_add(z, cplx_sqrt(cplx_add(cplx_mul(z, z), one))));
+}
+
+cplx_t cplx_acosh(cplx_t z)
+{
+    // acosh z = ln(z + √(z+1)·√(z-1))（√ を分けて主値の分岐を保つ）
+    cplx_t one = real_c(d_from_int(1));
+    return cplx_ln(cplx_add(z, cplx_mul(cplx_sqrt(cplx_add(z, one)), cplx_sqrt(cplx_sub(z, one)))));
+}
+
+cplx_t cplx_atanh(cplx_t z)
+{
+    if (d_is_zero(z.im) && d_gt(d_abs(z.re), d_from_int(1)))
+    {
+        // 実数 |x|>1: atanh(1/x) + i·π/2
+        BID_UINT128 inv = d_div(d_from_int(1), z.re), re;
+        __bid128_atanh(&re, &inv);
+        return cplx_make(re, d_from_str(CPLX_PI_2));
+    }
+    // atanh z = ½·[ln(1+z) - ln(1-z)]
+    cplx_t one = real_c(d_from_int(1));
+    cplx_t l = cplx_sub(cplx_ln(cplx_add(one, z)), cplx_ln(cplx_sub(one, z)));
+    return cplx_scale(l, d_from_str("0.5"));
+}
@@ -0,0 +1,57 @@
+#ifndef CPLX_H
+#define CPLX_H
+
+// BID128 の複素数演算（複素数モード用）
+// 主値で返す。負の実軸上の値（虚部が ±0）は上側からの極限として扱う
+#include <stdbool.h>
+#include "RPN.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        BID_UINT128 re, im;
+    } cplx_t;
+
+    cplx_t cplx_make(BID_UINT128 re, BID_UINT128 im);
+    bool cplx_is_real(cplx_t z); // 虚部が0
+
+    cplx_t cplx_add(cplx_t a, cplx_t b);
+    cplx_t cplx_sub(cplx_t a, cplx_t b); // a - b
+    cplx_t cplx_mul(cplx_t a, cplx_t b);
+    cplx_t cplx_div(cplx_t a, cplx_t b); // a / b
+    cplx_t cplx_neg(cplx_t z);
+    cplx_t cplx_recip(cplx_t z);
+    cplx_t cplx_scale(cplx_t z, BID_UINT128 k); // 実数倍（角度換算用）
+    BID_UINT128 cplx_abs(cplx_t z);
+    BID_UINT128 cplx_arg(cplx_t z); // ラジアン（-π, π]
+
+    cplx_t cplx_sqrt(cplx_t z);
+    cplx_t cplx_exp(cplx_t z);
+    cplx_t cplx_ln(cplx_t z);
+    cplx_t cplx_log10(cplx_t z);
+    cplx_t cplx_exp10(cplx_t z);
+    cplx_t cplx_pow(cplx_t base, cplx_t expo); // 整数乗は二乗法、それ以外は exp(expo·ln base)
+
+    // 三角/双曲線（引数・結果ともラジアン）
+    cplx_t cplx_sin(cplx_t z);
+    cplx_t cplx_cos(cplx_t z);
+    cplx_t cplx_tan(cplx_t z);
+    cplx_t cplx_asin(cplx_t z);
+    cplx_t cplx_acos(cplx_t z);
+    cplx_t cplx_atan(cplx_t z);
+    cplx_t cplx_sinh(cplx_t z);
+    cplx_t cplx_cosh(cplx_t z);
+    cplx_t cplx_tanh(cplx_t z);
+    cplx_t cplx_asinh(cplx_t z);
+    cplx_t cplx_acosh(cplx_t z);
+    cplx_t cplx_atanh(cplx_t z);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CPLX_H
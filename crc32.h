@@ -0,0 +1,28 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // CRC32（Poly 0xEDB88320, 初期値/最終XOR 0xFFFFFFFF）
+    // 長いデータはDMAスニファ、短いデータは256エントリのテーブルで計算する
+    uint32_t crc32_calc(const void *data, size_t len);
+    // テーブル版（DMAを使わない）
+    uint32_t crc32_calc_table(const void *data, size_t len);
+
+    // 全経路（ビット単位/テーブル/DMA）の一致を確認する。
+    // DMA経路が不一致ならDMAを無効化してテーブル版に切り替える。
+    // 戻り値: テーブル版が正しければtrue
+    bool crc32_self_test(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRC32_H
@@ -0,0 +1,307 @@
+// データリスト統計（標本を保持して並べ替え、中央値/四分位/百分位を求める）
+#include "datalist.h"
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "crc32.h"
+#include "settings.h"
+
+// settings: 最終, macros: 2番目, resume: 3,4番目, trace: 5番目、本モジュール: 末尾から6番目
+#define DATALIST_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - 6 * FLASH_SECTOR_SIZE)
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;  // 'DLS1'
+    uint32_t crc;    // count 以降（values の有効分まで）のCRC32
+    uint32_t count;  // 有効データ数
+    uint32_t sorted; // 並べ替え済みなら 1
+    BID_UINT128 values[DATALIST_MAX];
+} datalist_blob_t;
+_Static_assert(sizeof(datalist_blob_t) <= FLASH_SECTOR_SIZE, "datalist must fit in one sector");
+
+static const uint32_t DATALIST_MAGIC = 0x31534C44u; // 'DLS1'
+
+static BID_UINT128 g_values[DATALIST_MAX];
+static int g_count = 0;
+static bool g_sorted = true;
+static bool g_dirty = false;
+
+// 並べ替え用キー: BID128 を (分類, 指数, 34桁に正規化した係数) に分解したもの
+// 比較は整数比較だけで済み、bid128_quiet_less を繰り返し呼ぶより大幅に速い
+typedef enum
+{
+    KEY_NEG_INF,
+    KEY_NEG,
+    KEY_ZERO,
+    KEY_POS,
+    KEY_POS_INF,
+    KEY_NAN,
+} key_class_t;
+
+typedef struct
+{
+    uint64_t hi, lo; // 係数（最上位桁が 10^33 の位になるよう正規化）
+    int16_t exp;     // 正規化後の指数（バイアス付き）
+    uint8_t cls;     // key_class_t
+    uint8_t idx;     // 元の位置
+} sort_key_t;
+_Static_assert(DATALIST_MAX <= 256, "idx is 8 bits");
+
+static sort_key_t g_keys[DATALIST_MAX];
+
+// 10^33（34桁の下限）
+#define COEF_MIN_HI 0x0000314DC6448D93ull
+#define COEF_MIN_LO 0x38C15B0A00000000ull
+// 10^34 - 1（正規な係数の上限）
+#define COEF_MAX_HI 0x0001ED09BEAD87C0ull
+#define COEF_MAX_LO 0x378D8E63FFFFFFFFull
+
+static inline bool u128_less(uint64_t ah, uint64_t al, uint64_t bh, uint64_t bl)
+{
+    return ah < bh || (ah == bh && al < bl);
+}
+
+static void decode_key(const BID_UINT128 *v, uint8_t idx, sort_key_t *k)
+{
+    uint64_t hi = v->w[BID_HIGH_128W];
+    uint64_t lo = v->w[BID_LOW_128W];
+    bool neg = (hi >> 63) != 0;
+    k->idx = idx;
+    k->hi = 0;
+    k->lo = 0;
+    k->exp = 0;
+    if ((hi & 0x7C00000000000000ull) == 0x7C00000000000000ull)
+    {
+        k->cls = KEY_NAN;
+        return;
+    }
+    if ((hi & 0x7800000000000000ull) == 0x7800000000000000ull)
+    {
+        k->cls = neg ? KEY_NEG_INF : KEY_POS_INF;
+        return;
+    }
+    // 上位2ビットが 11 の形式は係数が 10^34 を超えるため非正規（値は0として扱う）
+    if ((hi & 0x6000000000000000ull) == 0x6000000000000000ull)
+    {
+        k->cls = KEY_ZERO;
+        return;
+    }
+    int exp = (int)((hi >> 49) & 0x3FFFu);
+    uint64_t ch = hi & 0x0001FFFFFFFFFFFFull;
+    uint64_t cl = lo;
+    if ((ch == 0 && cl == 0) || u128_less(COEF_MAX_HI, COEF_MAX_LO, ch, cl))
+    {
+        k->cls = KEY_ZERO;
+        return;
+    }
+    // 係数を34桁にそろえる（×10 = ×8 + ×2）
+    while (u128_less(ch, cl, COEF_MIN_HI, COEF_MIN_LO))
+    {
+        uint64_t h8 = (ch << 3) | (cl >> 61), l8 = cl << 3;
+        uint64_t h2 = (ch << 1) | (cl >> 63), l2 = cl << 1;
+        cl = l8 + l2;
+        ch = h8 + h2 + (cl < l8 ? 1u : 0u);
+        exp--;
+    }
+    k->hi = ch;
+    k->lo = cl;
+    k->exp = (int16_t)exp;
+    k->cls = neg ? KEY_NEG : KEY_POS;
+}
+
+static int key_cmp(const sort_key_t *a, const sort_key_t *b)
+{
+    if (a->cls != b->cls)
+        return a->cls < b->cls ? -1 : 1;
+    if (a->cls != KEY_NEG && a->cls != KEY_POS)
+        return 0;
+    int m;
+    if (a->exp != b->exp)
+        m = a->exp < b->exp ? -1 : 1;
+    else if (a->hi != b->hi || a->lo != b->lo)
+        m = u128_less(a->hi, a->lo, b->hi, b->lo) ? -1 : 1;
+    else
+        m = 0;
+    // 負数は絶対値が大きいほど小さい
+    return a->cls == KEY_NEG ? -m : m;
+}
+
+static void sift_down(sort_key_t *keys, int root, int n)
+{
+    while (2 * root + 1 < n)
+    {
+        int child = 2 * root + 1;
+        if (child + 1 < n && key_cmp(&keys[child], &keys[child + 1]) < 0)
+            child++;
+        if (key_cmp(&keys[root], &keys[child]) >= 0)
+            return;
+        sort_key_t t = keys[root];
+        keys[root] = keys[child];
+        keys[child] = t;
+        root = child;
+    }
+}
+
+void datalist_sort(void)
+{
+    if (g_sorted)
+        return;
+    int n = g_count;
+    for (int i = 0; i < n; ++i)
+        decode_key(&g_values[i], (uint8_t)i, &g_keys[i]);
+    // ヒープソート（追加メモリ不要、最悪でも O(n log n)）
+    for (int i = n / 2 - 1; i >= 0; --i)
+        sift_down(g_keys, i, n);
+    for (int end = n - 1; end > 0; --end)
+    {
+        sort_key_t t = g_keys[0];
+        g_keys[0] = g_keys[end];
+        g_keys[end] = t;
+        sift_down(g_keys, 0, end);
+    }
+    // 並び順どおりに値を巡回置換で入れ替える（位置 i には元の idx の値が入る）
+    for (int i = 0; i < n; ++i)
+    {
+        if (g_keys[i].idx == i)
+            continue;
+        BID_UINT128 tmp = g_values[i];
+        int j = i;
+        while (g_keys[j].idx != i)
+        {
+            int src = g_keys[j].idx;
+            g_values[j] = g_values[src];
+            g_keys[j].idx = (uint8_t)j;
+            j = src;
+        }
+        g_values[j] = tmp;
+        g_keys[j].idx = (uint8_t)j;
+    }
+    g_sorted = true;
+    g_dirty = true;
+}
+
+bool datalist_quantile(BID_UINT128 p, BID_UINT128 *out)
+{
+    if (g_count == 0 || !out)
+        return false;
+    datalist_sort();
+    // h = (n-1)·p、x[⌊h⌋] と x[⌊h⌋+1] の間を線形補間（表計算ソフトの PERCENTILE.INC と同じ）
+    int nm1_i = g_count - 1;
+    BID_UINT128 nm1, h, fl, frac, d;
+    __bid128_from_int32(&nm1, &nm1_i);
+    __bid128_mul(&h, &nm1, &p);
+    __bid128_round_integral_negative(&fl, &h);
+    int lo = 0;
+    __bid128_to_int32_int(&lo, &fl);
+    if (lo < 0)
+        lo = 0;
+    if (lo >= nm1_i)
+    {
+        *out = g_values[nm1_i];
+        return true;
+    }
+    __bid128_sub(&frac, &h, &fl);
+    __bid128_sub(&d, &g_values[lo + 1], &g_values[lo]);
+    __bid128_fma(out, &frac, &d, &g_values[lo]);
+    return true;
+}
+
+int datalist_count(void) { return g_count; }
+
+bool datalist_append(BID_UINT128 v)
+{
+    if (g_count >= DATALIST_MAX)
+        return false;
+    g_values[g_count++] = v;
+    g_sorted = (g_count == 1);
+    g_dirty = true;
+    return true;
+}
+
+bool datalist_get(int index, BID_UINT128 *out)
+{
+    if (index < 0 || index >= g_count || !out)
+        return false;
+    *out = g_values[index];
+    return true;
+}
+
+bool datalist_set(int index, BID_UINT128 v)
+{
+    if (index < 0 || index >= g_count)
+        return false;
+    g_values[index] = v;
+    g_sorted = (g_count == 1);
+    g_dirty = true;
+    return true;
+}
+
+bool datalist_remove(int index)
+{
+    if (index < 0 || index >= g_count)
+        return false;
+    // 並びを保ったまま詰める（並べ替え済みならそのまま）
+    memmove(&g_values[index], &g_values[index + 1], (size_t)(g_count - index - 1) * sizeof(g_values[0]));
+    g_count--;
+    g_dirty = true;
+    return true;
+}
+
+void datalist_clear(void)
+{
+    g_count = 0;
+    g_sorted = true;
+    g_dirty = true;
+}
+
+// CRC の対象（count から有効な values の末尾まで）
+static size_t blob_crc_len(uint32_t count)
+{
+    return offsetof(datalist_blob_t, values) - offsetof(datalist_blob_t, count) + count * sizeof(BID_UINT128);
+}
+
+void datalist_init(void)
+{
+    g_count = 0;
+    g_sorted = true;
+    g_dirty = false;
+    if (!settings_get_resume_enabled())
+        return;
+    const datalist_blob_t *rom = (const datalist_blob_t *)(XIP_BASE + DATALIST_FLASH_OFFSET);
+    if (rom->magic != DATALIST_MAGIC || rom->count > DATALIST_MAX)
+        return;
+    if (crc32_calc(&rom->count, blob_crc_len(rom->count)) != rom->crc)
+        return;
+    g_count = (int)rom->count;
+    memcpy(g_values, (const void *)rom->values, (size_t)g_count * sizeof(BID_UINT128));
+    g_sorted = (rom->sorted != 0);
+}
+
+bool datalist_prepare_save(persist_block_t *out)
+{
+    if (!out || !g_dirty || !settings_get_resume_enabled())
+        return false;
+    // 有効分だけをページ単位に切り上げて書く（未使用領域は 0xFF）
+    static uint8_t pad_buf[(sizeof(datalist_blob_t) + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1)];
+    size_t used = offsetof(datalist_blob_t, values) + (size_t)g_count * sizeof(BID_UINT128);
+    size_t len = (used + FLASH_PAGE_SIZE - 1) & ~(size_t)(FLASH_PAGE_SIZE - 1);
+    memset(pad_buf, 0xFF, len);
+    datalist_blob_t *blob = (datalist_blob_t *)pad_buf; // packed なので整列の制約なし
+    blob->magic = DATALIST_MAGIC;
+    blob->count = (uint32_t)g_count;
+    blob->sorted = g_sorted ? 1u : 0u;
+    memcpy(blob->values, g_values, (size_t)g_count * sizeof(BID_UINT128));
+    blob->crc = crc32_calc(&blob->count, blob_crc_len(blob->count));
+
+    out->flash_offset = DATALIST_FLASH_OFFSET;
+    out->data = pad_buf;
+    out->len = len;
+    out->append = false;
+    return true;
+}
+
+void datalist_mark_saved(void)
+{
+    g_dirty = false;
+}
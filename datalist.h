@@ -0,0 +1,42 @@
+#ifndef DATALIST_H
+#define DATALIST_H
+
+#include <stdbool.h>
+#include "RPN.h"
+#include "persist.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 保持できるデータ数（保存ブロブが1セクタに収まる数）
+#define DATALIST_MAX 254
+
+    // 起動時: Resume=ON ならフラッシュからリストを復元
+    void datalist_init(void);
+
+    int datalist_count(void);
+    // 末尾に追加（満杯なら false）
+    bool datalist_append(BID_UINT128 v);
+    // 個別の参照/置換/削除（範囲外は false）
+    bool datalist_get(int index, BID_UINT128 *out);
+    bool datalist_set(int index, BID_UINT128 v);
+    bool datalist_remove(int index);
+    void datalist_clear(void);
+
+    // 昇順に並べ替える（-Inf < 負 < 0 < 正 < +Inf < NaN）
+    void datalist_sort(void);
+    // 分位点（p は 0..1、(n-1)·p の位置を線形補間。並べ替え済みでなければ並べ替える）
+    // データが無い場合は false
+    bool datalist_quantile(BID_UINT128 p, BID_UINT128 *out);
+
+    // 一括保存用: Resume=ON かつ変更があれば保存ブロブを組み立てて true
+    bool datalist_prepare_save(persist_block_t *out);
+    void datalist_mark_saved(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DATALIST_H
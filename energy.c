@@ -0,0 +1,124 @@
+// 状態別の滞在時間と消費電力量の見積り
+#include "energy.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+static uint64_t g_total_us[ENERGY_STATE_COUNT];
+static uint64_t g_since_us[ENERGY_STATE_COUNT]; // 現在の区間の開始時刻（0=非アクティブ）
+static energy_state_t g_clock = ENERGY_CLK_12MHZ;
+static uint64_t g_session_start_us = 0;
+
+static uint32_t g_current_ua[ENERGY_STATE_COUNT] = {
+    ENERGY_UA_1MHZ,
+    ENERGY_UA_12MHZ,
+    ENERGY_UA_BOOST,
+    ENERGY_UA_I2C,
+    ENERGY_UA_FLASH,
+};
+
+static inline bool is_clock_state(energy_state_t s)
+{
+    return s <= ENERGY_CLK_BOOST;
+}
+
+void energy_init(void)
+{
+    uint64_t now = time_us_64();
+    for (int i = 0; i < ENERGY_STATE_COUNT; ++i)
+    {
+        g_total_us[i] = 0;
+        g_since_us[i] = 0;
+    }
+    g_session_start_us = now;
+    g_clock = ENERGY_CLK_12MHZ;
+    g_since_us[g_clock] = now;
+}
+
+void energy_set_clock(energy_state_t clock_state)
+{
+    if (!is_clock_state(clock_state))
+        return;
+    uint32_t irq = save_and_disable_interrupts();
+    if (clock_state != g_clock)
+    {
+        uint64_t now = time_us_64();
+        if (g_since_us[g_clock])
+            g_total_us[g_clock] += now - g_since_us[g_clock];
+        g_since_us[g_clock] = 0;
+        g_clock = clock_state;
+        g_since_us[g_clock] = now;
+    }
+    restore_interrupts(irq);
+}
+
+void energy_activity_begin(energy_state_t activity)
+{
+    if (is_clock_state(activity) || activity >= ENERGY_STATE_COUNT)
+        return;
+    uint32_t irq = save_and_disable_interrupts();
+    if (!g_since_us[activity])
+        g_since_us[activity] = time_us_64();
+    restore_interrupts(irq);
+}
+
+void energy_activity_end(energy_state_t activity)
+{
+    if (is_clock_state(activity) || activity >= ENERGY_STATE_COUNT)
+        return;
+    uint32_t irq = save_and_disable_interrupts();
+    if (g_since_us[activity])
+    {
+        g_total_us[activity] += time_us_64() - g_since_us[activity];
+        g_since_us[activity] = 0;
+    }
+    restore_interrupts(irq);
+}
+
+static uint64_t residency_us(energy_state_t state)
+{
+    if (state >= ENERGY_STATE_COUNT)
+        return 0;
+    uint32_t irq = save_and_disable_interrupts();
+    uint64_t t = g_total_us[state];
+    if (g_since_us[state])
+        t += time_us_64() - g_since_us[state];
+    restore_interrupts(irq);
+    return t;
+}
+
+uint32_t energy_residency_ms(energy_state_t state)
+{
+    return (uint32_t)(residency_us(state) / 1000u);
+}
+
+uint32_t energy_session_ms(void)
+{
+    return (uint32_t)((time_us_64() - g_session_start_us) / 1000u);
+}
+
+uint32_t energy_state_uah(energy_state_t state)
+{
+    if (state >= ENERGY_STATE_COUNT)
+        return 0;
+    // uA * us / 3.6e9 = uAh
+    return (uint32_t)((residency_us(state) * g_current_ua[state]) / 3600000000ull);
+}
+
+uint32_t energy_session_uah(void)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < ENERGY_STATE_COUNT; ++i)
+        sum += energy_state_uah((energy_state_t)i);
+    return sum;
+}
+
+uint32_t energy_get_current_ua(energy_state_t state)
+{
+    return (state < ENERGY_STATE_COUNT) ? g_current_ua[state] : 0;
+}
+
+void energy_set_current_ua(energy_state_t state, uint32_t ua)
+{
+    if (state < ENERGY_STATE_COUNT)
+        g_current_ua[state] = ua;
+}
@@ -0,0 +1,65 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // 計測する状態
+    // クロック状態（1MHz/12MHz/ブースト）は排他、I2C/フラッシュはクロック状態に上乗せ
+    typedef enum
+    {
+        ENERGY_CLK_1MHZ = 0, // 低電力（無操作時）
+        ENERGY_CLK_12MHZ,    // 通常動作
+        ENERGY_CLK_BOOST,    // キー押下で割込みから即時12MHz化（メインループの切替前）
+        ENERGY_I2C,          // LCD への I2C 送信中
+        ENERGY_FLASH,        // フラッシュ消去/書込み中
+        ENERGY_STATE_COUNT
+    } energy_state_t;
+
+// 状態ごとの消費電流の見積り[uA]（クロック状態は全体、I2C/フラッシュは増分）
+#ifndef ENERGY_UA_1MHZ
+#define ENERGY_UA_1MHZ 1500u
+#endif
+#ifndef ENERGY_UA_12MHZ
+#define ENERGY_UA_12MHZ 6000u
+#endif
+#ifndef ENERGY_UA_BOOST
+#define ENERGY_UA_BOOST ENERGY_UA_12MHZ
+#endif
+#ifndef ENERGY_UA_I2C
+#define ENERGY_UA_I2C 1000u
+#endif
+#ifndef ENERGY_UA_FLASH
+#define ENERGY_UA_FLASH 10000u
+#endif
+
+    // 計測開始（起動時、12MHz 状態から）
+    void energy_init(void);
+
+    // クロック状態の切替（割込みからも呼べる）
+    void energy_set_clock(energy_state_t clock_state);
+    // I2C/フラッシュ動作の開始/終了
+    void energy_activity_begin(energy_state_t activity);
+    void energy_activity_end(energy_state_t activity);
+
+    // 状態ごとの滞在時間[ms]（現在の状態は呼出し時点までを含む）
+    uint32_t energy_residency_ms(energy_state_t state);
+    // 起動からの経過時間[ms]
+    uint32_t energy_session_ms(void);
+    // 状態ごとの消費見積り[uAh]、合計
+    uint32_t energy_state_uah(energy_state_t state);
+    uint32_t energy_session_uah(void);
+
+    // 電流見積りの取得/変更[uA]
+    uint32_t energy_get_current_ua(energy_state_t state);
+    void energy_set_current_ua(energy_state_t state, uint32_t ua);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ENERGY_H
@@ -0,0 +1,261 @@
+// 分数モード: 既約分数の四則と、BID128 値からの正確な分数/最良近似分数の復元
+// 分数どうしの演算は64ビット整数の乗算と gcd だけで済み、BID128 の除算より大幅に軽い。
+// スタックには BID128 の値も置く必要があるので、結果の BID128 化は分母が 1 以外のときだけ除算1回
+#include "fraction.h"
+#include <stdio.h>
+#include <string.h>
+#include "bid_ops.h"
+
+// BID128 の指数バイアス
+#define BID128_EXP_BIAS 6176
+// 連分数展開の最大項数（分母 1E15 までなら十分）
+#define FRAC_CF_MAX_TERMS 48
+// 近似の相対許容誤差（34桁の丸め誤差が積み重なっても同じ分数に戻る程度）
+#define FRAC_APPROX_TOL "1E-30"
+// 覚えておく演算結果の数
+#define FRAC_CACHE_SIZE 8
+
+typedef struct
+{
+    BID_UINT128 value; // 演算結果として置いた BID128（ビット列で照合）
+    frac_t f;
+} frac_cache_t;
+
+static frac_cache_t g_cache[FRAC_CACHE_SIZE];
+static int g_cache_count = 0;
+static int g_cache_next = 0;
+
+static uint64_t gcd_u64(uint64_t a, uint64_t b)
+{
+    while (b != 0)
+    {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static inline uint64_t abs_u64(int64_t v)
+{
+    return v < 0 ? 0u - (uint64_t)v : (uint64_t)v;
+}
+
+// 既約化して out に置く（分母の符号を分子へ）。INT64_MIN は扱わない
+static bool make_frac(int64_t num, int64_t den, frac_t *out)
+{
+    if (den == 0 || num == INT64_MIN || den == INT64_MIN)
+        return false;
+    if (den < 0)
+    {
+        num = -num;
+        den = -den;
+    }
+    uint64_t g = gcd_u64(abs_u64(num), (uint64_t)den);
+    if (g > 1)
+    {
+        num /= (int64_t)g;
+        den /= (int64_t)g;
+    }
+    out->num = num;
+    out->den = den;
+    return true;
+}
+
+bool frac_mul(frac_t a, frac_t b, frac_t *out)
+{
+    // 先に交差約分してから掛ける（結果は既約のまま）
+    int64_t g1 = (int64_t)gcd_u64(abs_u64(a.num), (uint64_t)b.den);
+    int64_t g2 = (int64_t)gcd_u64(abs_u64(b.num), (uint64_t)a.den);
+    if (g1 == 0 || g2 == 0)
+        return make_frac(0, 1, out); // どちらかが 0
+    int64_t num, den;
+    if (__builtin_mul_overflow(a.num / g1, b.num / g2, &num) ||
+        __builtin_mul_overflow(a.den / g2, b.den / g1, &den))
+        return false;
+    return make_frac(num, den, out);
+}
+
+bool frac_recip(frac_t a, frac_t *out)
+{
+    if (a.num == 0)
+        return false;
+    return make_frac(a.den, a.num, out);
+}
+
+bool frac_div(frac_t a, frac_t b, frac_t *out)
+{
+    frac_t r;
+    return frac_recip(b, &r) && frac_mul(a, r, out);
+}
+
+bool frac_add(frac_t a, frac_t b, frac_t *out)
+{
+    // 分母の最小公倍数で通分する
+    int64_t g = (int64_t)gcd_u64((uint64_t)a.den, (uint64_t)b.den);
+    int64_t ta, tb, num, den;
+    if (__builtin_mul_overflow(a.num, b.den / g, &ta) ||
+        __builtin_mul_overflow(b.num, a.den / g, &tb) ||
+        __builtin_add_overflow(ta, tb, &num) ||
+        __builtin_mul_overflow(a.den, b.den / g, &den))
+        return false;
+    return make_frac(num, den, out);
+}
+
+bool frac_sub(frac_t a, frac_t b, frac_t *out)
+{
+    b.num = -b.num; // 既約分数の num は INT64_MIN にならない
+    return frac_add(a, b, out);
+}
+
+BID_UINT128 frac_to_bid(frac_t f)
+{
+    BID_SINT64 n = f.num, d = f.den;
+    BID_UINT128 bn, bd;
+    __bid128_from_int64(&bn, &n);
+    if (f.den == 1)
+        return bn;
+    __bid128_from_int64(&bd, &d);
+    return d_div(bn, bd);
+}
+
+// 有限小数（係数 × 10^指数）をそのまま分数にする
+static bool frac_from_decimal(BID_UINT128 v, frac_t *out)
+{
+    uint64_t hi = v.w[BID_HIGH_128W];
+    uint64_t lo = v.w[BID_LOW_128W];
+    bool neg = (hi >> 63) != 0;
+    // 無限大/NaN と、上位2ビットが 11 の形式（係数が 10^34 超で非正規）は対象外
+    if ((hi & 0x7800000000000000ull) == 0x7800000000000000ull)
+        return false;
+    if ((hi & 0x6000000000000000ull) == 0x6000000000000000ull)
+        return false;
+    int exp = (int)((hi >> 49) & 0x3FFFu) - BID128_EXP_BIAS;
+    // 係数が63ビットを超えるもの（34桁に丸めた商など）は有限小数として扱わない
+    if ((hi & 0x0001FFFFFFFFFFFFull) != 0 || (lo >> 63) != 0)
+        return false;
+    uint64_t c = lo;
+    if (c == 0)
+        return make_frac(0, 1, out);
+    while (exp < 0 && c % 10u == 0)
+    {
+        c /= 10u;
+        exp++;
+    }
+    int64_t num = neg ? -(int64_t)c : (int64_t)c;
+    int64_t den = 1;
+    for (; exp > 0; --exp)
+    {
+        if (__builtin_mul_overflow(num, (int64_t)10, &num))
+            return false;
+    }
+    for (; exp < 0; ++exp)
+    {
+        if (__builtin_mul_overflow(den, (int64_t)10, &den))
+            return false;
+    }
+    return make_frac(num, den, out);
+}
+
+static bool cache_lookup(BID_UINT128 v, frac_t *out)
+{
+    for (int i = 0; i < g_cache_count; ++i)
+    {
+        if (memcmp(&g_cache[i].value, &v, sizeof(v)) == 0)
+        {
+            *out = g_cache[i].f;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool frac_exact(BID_UINT128 v, frac_t *out)
+{
+    if (cache_lookup(v, out))
+        return true;
+    // 符号反転しただけの値も同じ分数として扱う
+    if (cache_lookup(d_neg(v), out))
+    {
+        out->num = -out->num;
+        return true;
+    }
+    return frac_from_decimal(v, out);
+}
+
+void frac_remember(BID_UINT128 v, frac_t f)
+{
+    for (int i = 0; i < g_cache_count; ++i)
+    {
+        if (memcmp(&g_cache[i].value, &v, sizeof(v)) == 0)
+        {
+            g_cache[i].f = f;
+            return;
+        }
+    }
+    g_cache[g_cache_next].value = v;
+    g_cache[g_cache_next].f = f;
+    g_cache_next = (g_cache_next + 1) % FRAC_CACHE_SIZE;
+    if (g_cache_count < FRAC_CACHE_SIZE)
+        g_cache_count++;
+}
+
+bool frac_approx(BID_UINT128 v, frac_t *out)
+{
+    if (!d_is_finite(v))
+        return false;
+    if (d_is_zero(v))
+        return make_frac(0, 1, out);
+    _IDEC_flags saved = _IDEC_glbflags;
+    bool neg = d_is_neg(v);
+    BID_UINT128 x = d_abs(v);
+    const BID_UINT128 tol = d_mul(x, d_from_str(FRAC_APPROX_TOL));
+    const BID_UINT128 one = d_from_int(1);
+    // 収束分数 h/k の漸化式: h_n = a_n h_{n-1} + h_{n-2}
+    int64_t h1 = 1, h2 = 0, k1 = 0, k2 = 1;
+    BID_UINT128 r = x;
+    bool found = false;
+    for (int i = 0; i < FRAC_CF_MAX_TERMS; ++i)
+    {
+        BID_UINT128 fl;
+        __bid128_round_integral_negative(&fl, &r);
+        BID_SINT64 a = 0;
+        __bid128_to_int64_int(&a, &fl);
+        int64_t h, k, t;
+        if (a < 0 || __builtin_mul_overflow((int64_t)a, h1, &t) || __builtin_add_overflow(t, h2, &h) ||
+            __builtin_mul_overflow((int64_t)a, k1, &t) || __builtin_add_overflow(t, k2, &k) || k > FRAC_MAX_DEN)
+            break;
+        h2 = h1;
+        h1 = h;
+        k2 = k1;
+        k1 = k;
+        frac_t c = {h, k};
+        if (!d_gt(d_abs(d_sub(x, frac_to_bid(c))), tol))
+        {
+            found = make_frac(neg ? -h : h, k, out);
+            break;
+        }
+        BID_UINT128 f = d_sub(r, fl);
+        if (d_is_zero(f))
+            break;
+        r = d_div(one, f);
+    }
+    _IDEC_glbflags = saved;
+    return found;
+}
+
+bool frac_format_value(BID_UINT128 v, char *buf, int bufsize)
+{
+    frac_t f;
+    if (!frac_exact(v, &f) && !frac_approx(v, &f))
+        return false;
+    // 整数は通常の整形に任せる
+    if (f.den == 1)
+        return false;
+    char tmp[48];
+    int n = snprintf(tmp, sizeof(tmp), "%lld/%lld", (long long)f.num, (long long)f.den);
+    if (n <= 0 || n > bufsize - 1)
+        return false;
+    memcpy(buf, tmp, (size_t)n + 1);
+    return true;
+}
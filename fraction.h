@@ -0,0 +1,50 @@
+#ifndef FRACTION_H
+#define FRACTION_H
+
+// 分数モード: 64ビットの分子/分母による正確な有理数演算と、分数表示
+#include <stdbool.h>
+#include <stdint.h>
+#include "RPN.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 分数表示で使う分母の上限（これを超える近似しか無ければ小数で表示）
+#define FRAC_MAX_DEN 1000000000000000LL
+
+    // 既約分数（den > 0、num は INT64_MIN 以外）
+    typedef struct
+    {
+        int64_t num;
+        int64_t den;
+    } frac_t;
+
+    // 演算（分子/分母が64ビットに収まらなければ false。呼び出し側は BID128 の演算へ戻る）
+    bool frac_add(frac_t a, frac_t b, frac_t *out);
+    bool frac_sub(frac_t a, frac_t b, frac_t *out); // a - b
+    bool frac_mul(frac_t a, frac_t b, frac_t *out);
+    bool frac_div(frac_t a, frac_t b, frac_t *out); // a / b（b = 0 なら false）
+    bool frac_recip(frac_t a, frac_t *out);
+
+    // BID128 への変換（分母が 1 なら正確、それ以外は1回の除算で丸め）
+    BID_UINT128 frac_to_bid(frac_t f);
+
+    // 値 v の正確な分数を求める。演算結果として覚えている分数か、有限小数（係数が64ビット以内）のとき true
+    bool frac_exact(BID_UINT128 v, frac_t *out);
+    // 演算結果 v が正確には f であることを覚えておく（直近の数件のみ）
+    void frac_remember(BID_UINT128 v, frac_t f);
+
+    // 連分数展開で v の最良近似分数を求める（相対誤差 1E-30 以内、分母 FRAC_MAX_DEN 以下）
+    bool frac_approx(BID_UINT128 v, frac_t *out);
+
+    // 分数表示の整形: v を "n/d" で bufsize-1 文字以内に書けたら true
+    // 整数や、幅に収まらない/近似できない値は false（呼び出し側で小数表示）
+    bool frac_format_value(BID_UINT128 v, char *buf, int bufsize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRACTION_H
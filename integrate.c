@@ -0,0 +1,175 @@
+// 数値積分: マクロを被積分関数として tanh-sinh（二重指数型）求積で積分する
+// 刻み h を半分にするごとに奇数番目の点だけを追加評価するので、
+// 前のレベルの評価結果はそのまま和に残り、同じ点でマクロを2回実行することはない。
+// 誤差推定は直前のレベルとの差（収束は二重指数的なので実際の誤差はさらに小さい）
+#include "integrate.h"
+#include "pico/stdlib.h"
+#include "RPN.h"
+#include "bid_ops.h"
+#include "compute.h"
+#include "macro.h"
+#include "macro_exec.h"
+#include "profile.h"
+
+// 相対許容誤差
+#define INTEGRATE_REL_TOL "1E-30"
+// t の範囲（t=3 を超えたら寄与が十分小さくなった時点で打ち切る）
+#define INTEGRATE_T_MAX 6
+#define INTEGRATE_T_TAIL 3
+#define INTEGRATE_TAIL_TOL "1E-36"
+#define INTEGRATE_PI_2 "1.570796326794896619231321691639751"
+
+static int g_slot = 0;
+static volatile integrate_status_t g_status = INTEGRATE_OK;
+static uint32_t g_evals = 0;
+static uint64_t g_deadline_us = 0;
+static bool g_failed = false; // 評価の中断（取消し/未対応キー）
+
+// f(x): スタックを x で満たしてマクロを実行し、X を返す
+static BID_UINT128 eval_f(BID_UINT128 x)
+{
+    if (g_failed)
+        return x;
+    rpn_load_stack(x, x, x, x);
+    if (!macro_exec_headless(g_slot))
+    {
+        g_status = compute_cancel_requested() ? INTEGRATE_CANCELED : INTEGRATE_BAD_MACRO;
+        g_failed = true;
+        return x;
+    }
+    g_evals++;
+    compute_set_progress("INTEG", g_evals);
+    return rpn_stack_x();
+}
+
+static bool over_budget(void)
+{
+    return g_evals >= INTEGRATE_MAX_EVALS || time_us_64() >= g_deadline_us;
+}
+
+// 区間 [a,b]（c=中点, d=半幅）上で t=k·h（k=k0, k0+step, ...）の点を評価して和を返す
+// 変数変換 x = c ± d·tanh(π/2·sinh t)、重み w = π/2·cosh t / cosh²(π/2·sinh t)
+// 端点付近で 1-tanh が桁落ちしないよう、端点からの距離 off = 1-tanh(u) = 2/(e^{2u}+1) を直接求める
+static BID_UINT128 sum_level(BID_UINT128 a, BID_UINT128 b, BID_UINT128 d, BID_UINT128 h, int k0, int step,
+                             BID_UINT128 total)
+{
+    const BID_UINT128 one = d_from_int(1);
+    const BID_UINT128 two = d_from_int(2);
+    const BID_UINT128 half = d_from_str("0.5");
+    const BID_UINT128 pi_2 = d_from_str(INTEGRATE_PI_2);
+    const BID_UINT128 t_max = d_from_int(INTEGRATE_T_MAX);
+    const BID_UINT128 t_tail = d_from_int(INTEGRATE_T_TAIL);
+    const BID_UINT128 tail_tol = d_from_str(INTEGRATE_TAIL_TOL);
+    BID_UINT128 s = d_from_int(0);
+    for (int k = k0; !g_failed; k += step)
+    {
+        BID_UINT128 t = d_mul(d_from_int(k), h);
+        if (d_gt(t, t_max))
+            break;
+        BID_UINT128 et, eu2;
+        __bid128_exp(&et, &t);
+        BID_UINT128 inv_et = d_div(one, et);
+        BID_UINT128 ch = d_mul(half, d_add(et, inv_et));
+        BID_UINT128 u2 = d_mul(pi_2, d_sub(et, inv_et)); // 2u = π/2·(e^t - e^-t)
+        __bid128_exp(&eu2, &u2);
+        BID_UINT128 off = d_div(two, d_add(eu2, one));
+        BID_UINT128 w = d_mul(d_mul(d_mul(pi_2, ch), d_mul(off, off)), eu2);
+        BID_UINT128 doff = d_mul(d, off);
+        BID_UINT128 xp = d_sub(b, doff);
+        BID_UINT128 xm = d_add(a, doff);
+        // 端点に丸まった側は評価しない（端点の特異性を避ける）
+        bool use_p = !d_eq(xp, b);
+        bool use_m = !d_eq(xm, a);
+        if (!use_p && !use_m)
+            break;
+        BID_UINT128 fs = d_from_int(0);
+        if (use_p)
+            fs = d_add(fs, eval_f(xp));
+        if (use_m)
+            fs = d_add(fs, eval_f(xm));
+        BID_UINT128 term = d_mul(w, fs);
+        s = d_add(s, term);
+        if (d_gt(t, t_tail) && !d_gt(d_abs(term), d_mul(tail_tol, d_abs(d_add(total, s)))))
+            break;
+        if (over_budget())
+            break;
+    }
+    return s;
+}
+
+static void integrate_op(void)
+{
+    g_evals = 0;
+    g_failed = false;
+    g_status = INTEGRATE_OK;
+    g_deadline_us = time_us_64() + (uint64_t)INTEGRATE_TIME_LIMIT_MS * 1000u;
+    rpn_undo_suspend(true);
+
+    if (rpn_is_input_active())
+        rpn_commit_input_without_push();
+    BID_UINT128 b = rpn_stack_x();
+    BID_UINT128 a = rpn_stack_y();
+    const BID_UINT128 half = d_from_str("0.5");
+    const BID_UINT128 tol = d_from_str(INTEGRATE_REL_TOL);
+    BID_UINT128 c = d_mul(half, d_add(a, b));
+    BID_UINT128 d = d_mul(half, d_sub(b, a));
+    BID_UINT128 h = d_from_int(1);
+    BID_UINT128 result = d_from_int(0);
+    BID_UINT128 err = d_from_int(0);
+    bool converged = false;
+
+    if (!d_is_zero(d))
+    {
+        // レベル0: t = 0, ±1, ±2, ...（中点の重みは π/2）
+        BID_UINT128 total = d_mul(d_from_str(INTEGRATE_PI_2), eval_f(c));
+        total = d_add(total, sum_level(a, b, d, h, 1, 1, total));
+        result = d_mul(d_mul(d, h), total);
+        for (int level = 1; level <= INTEGRATE_MAX_LEVEL && !g_failed && !over_budget(); ++level)
+        {
+            // 刻みを半分にして、新しい点（奇数番目）だけを加える
+            h = d_mul(half, h);
+            total = d_add(total, sum_level(a, b, d, h, 1, 2, total));
+            BID_UINT128 next = d_mul(d_mul(d, h), total);
+            err = d_abs(d_sub(next, result));
+            result = next;
+            if (level >= 2 && !d_gt(err, d_mul(tol, d_abs(result))))
+            {
+                converged = true;
+                break;
+            }
+        }
+    }
+    else
+    {
+        converged = true;
+    }
+
+    if (!g_failed && !converged)
+        g_status = INTEGRATE_NOT_CONVERGED;
+    rpn_undo_suspend(false);
+    if (g_failed)
+        return; // 状態は呼び出し側で元に戻す
+    rpn_load_stack(result, err, b, a);
+    _IDEC_glbflags = BID_EXACT_STATUS;
+}
+
+integrate_status_t integrate_run(int slot)
+{
+    if (!macro_has(slot))
+        return INTEGRATE_BAD_MACRO;
+    g_slot = slot;
+    rpn_cancel_snapshot();
+    // Undo で積分前のスタックに戻れるよう境界を取る（取消し時はこれも捨てる）
+    rpn_undo_capture_boundary();
+    if (!compute_run(integrate_op))
+        g_status = INTEGRATE_CANCELED;
+    profile_record("integrate", compute_last_cycles());
+    if (g_status == INTEGRATE_CANCELED || g_status == INTEGRATE_BAD_MACRO)
+        rpn_cancel_restore();
+    return g_status;
+}
+
+uint32_t integrate_last_evals(void)
+{
+    return g_evals;
+}
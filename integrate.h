@@ -0,0 +1,44 @@
+#ifndef INTEGRATE_H
+#define INTEGRATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 細分化の最大レベル、関数評価の上限回数、制限時間（ビルド時に上書き可）
+#ifndef INTEGRATE_MAX_LEVEL
+#define INTEGRATE_MAX_LEVEL 8
+#endif
+#ifndef INTEGRATE_MAX_EVALS
+#define INTEGRATE_MAX_EVALS 2500
+#endif
+#ifndef INTEGRATE_TIME_LIMIT_MS
+#define INTEGRATE_TIME_LIMIT_MS 120000u
+#endif
+
+    typedef enum
+    {
+        INTEGRATE_OK,
+        INTEGRATE_NOT_CONVERGED, // 上限に達した（結果と誤差推定は残す）
+        INTEGRATE_BAD_MACRO,     // マクロが空、または評価中に実行できないキーを含む
+        INTEGRATE_CANCELED,      // DEL/OFF で取消し（状態は実行前に戻す）
+    } integrate_status_t;
+
+    // マクロ slot(0..2) を被積分関数として Y（下限）から X（上限）まで積分する。
+    // 評価ごとに X,Y,Z,T を x で満たしてからマクロをヘッドレス実行し、X を f(x) とする。
+    // 結果: X=積分値, Y=誤差推定, Z=上限, T=下限
+    // core0 から呼ぶ（評価は core1 で行い、待機中は評価回数を表示する）
+    integrate_status_t integrate_run(int slot);
+
+    // 直近の積分での関数評価回数
+    uint32_t integrate_last_evals(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INTEGRATE_H
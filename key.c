@@ -27,6 +27,8 @@ static key_state_t gk;
 // リングバッファ操作関数
 static bool enqueue_event(key_event_t event)
 {
+    // 応答遅延計測用に確定時刻を付ける
+    event.time_us = time_us_32();
     uint8_t next_head = (gk.event_head + 1) % 8;
     if (next_head == gk.event_tail)
     {
@@ -42,7 +44,7 @@ static key_event_t dequeue_event(void)
 {
     if (gk.event_head == gk.event_tail)
     {
-        return (key_event_t){KEY_EVENT_NONE, K_NONE};
+        return (key_event_t){.type = KEY_EVENT_NONE, .code = K_NONE, .time_us = 0};
     }
     key_event_t event = gk.events[gk.event_tail];
     gk.event_tail = (gk.event_tail + 1) % 8;
@@ -151,9 +153,9 @@ static key_code_t map_raw_to_key(uint8_t raw)
         switch (col)
         {
         case 0:
-            return K_SUB;
+            return gk.shift_state ? K_SIGMA_MINUS : K_SUB;
         case 1:
-            return K_ADD;
+            return gk.shift_state ? K_SIGMA_PLUS : K_ADD;
         case 2:
             return gk.shift_state ? K_CLR : K_3;
         case 3:
@@ -166,7 +168,7 @@ static key_code_t map_raw_to_key(uint8_t raw)
         switch (col)
         {
         case 0:
-            return K_ENTER;
+            return gk.shift_state ? K_COMPLEX : K_ENTER;
         case 1:
             return K_SHIFT;
         case 2:
@@ -254,7 +256,7 @@ static bool scan_timer_cb(repeating_timer_t *rt)
             if (gk.stable_code != raw)
             {
                 // 状態遷移: up or down
-                key_event_t ev = {0};
+                key_event_t ev = {.type = KEY_EVENT_NONE, .code = K_NONE, .time_us = time_us_32()};
                 if (raw)
                 {
                     ev.type = KEY_EVENT_DOWN;
@@ -289,7 +291,7 @@ static bool scan_timer_cb(repeating_timer_t *rt)
                 if (gk.repeat_ms >= (uint16_t)2500 / TIMER_TICK)
                 {                                               // 500ms後から100ms間隔
                     gk.repeat_ms = (uint16_t)2000 / TIMER_TICK; // 次は100msで発火（500-100=400）
-                    key_event_t ev = {KEY_EVENT_REPEAT, map_raw_to_key(raw)};
+                    key_event_t ev = {.type = KEY_EVENT_REPEAT, .code = map_raw_to_key(raw), .time_us = time_us_32()};
                     enqueue_event(ev);
                 }
             }
@@ -332,6 +334,25 @@ key_event_t key_poll(void)
     return ev;
 }
 
+bool key_take_cancel(void)
+{
+    bool found = false;
+    uint32_t irq = save_and_disable_interrupts();
+    for (uint8_t i = gk.event_tail; i != gk.event_head; i = (i + 1) % 8)
+    {
+        if (!key_is_cancel_event(gk.events[i]))
+            continue;
+        // 後続イベントを1つずつ前に詰める
+        for (uint8_t j = i; (j + 1) % 8 != gk.event_head; j = (j + 1) % 8)
+            gk.events[j] = gk.events[(j + 1) % 8];
+        gk.event_head = (gk.event_head + 7) % 8;
+        found = true;
+        break;
+    }
+    restore_interrupts(irq);
+    return found;
+}
+
 void key_reset(void)
 {
     uint32_t irq = save_and_disable_interrupts();
@@ -88,12 +88,16 @@ extern "C"
         K_SHOW,
         K_PI,
         K_e,
+        K_SIGMA_PLUS,  // Shift + '+'
+        K_SIGMA_MINUS, // Shift + '-'
+        K_COMPLEX,     // Shift + ENTER
     } key_code_t;
 
     typedef struct
     {
         key_event_type_t type;
         key_code_t code;
+        uint32_t time_us; // 検出時刻（time_us_32、マクロ注入イベントは0）
     } key_event_t;
 
     // シフト状態の設定/取得
@@ -106,6 +110,15 @@ extern "C"
     // 全状態クリア
     void key_reset(void);
 
+    // 取消しキー（DEL/OFF）の押下かどうか
+    static inline bool key_is_cancel_event(key_event_t ev)
+    {
+        return ev.type == KEY_EVENT_DOWN && (ev.code == K_DEL || ev.code == K_OFF);
+    }
+    // 未処理イベントから取消しキーの押下を1件取り除く（他のイベントは順序を保って残す）
+    // 戻り値: 取り除いたら true
+    bool key_take_cancel(void);
+
     // スキャンタイマを一時停止/再開（クロック切替前後の安全確保用）
     void key_scan_pause(void);
     void key_scan_resume(void);
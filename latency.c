@@ -0,0 +1,134 @@
+// キー押下から表示までの応答遅延ヒストグラム
+#include "latency.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+static uint32_t g_hist[LATENCY_KIND_COUNT][LATENCY_BUCKETS];
+static uint32_t g_max_us[LATENCY_KIND_COUNT];
+
+// 計測中のキー処理
+static bool g_pending = false;
+static bool g_switched = false;
+static bool g_lcd_written = false;
+static uint32_t g_start_us = 0;
+static uint32_t g_last_lcd_us = 0;
+
+static int bucket_of(uint32_t us)
+{
+    uint32_t ms = us / 1000u;
+    int b = 0;
+    while (ms > 0 && b < LATENCY_BUCKETS - 1)
+    {
+        ms >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void latency_key_begin(const key_event_t *ev)
+{
+    // マクロ注入イベント（時刻なし）とキー離上は対象外
+    g_pending = ev && ev->time_us != 0 && ev->type != KEY_EVENT_UP;
+    if (!g_pending)
+        return;
+    g_start_us = ev->time_us;
+    g_switched = false;
+    g_lcd_written = false;
+}
+
+void latency_note_clock_switch(void)
+{
+    g_switched = true;
+}
+
+void latency_note_lcd_write(void)
+{
+    if (!g_pending)
+        return;
+    g_last_lcd_us = time_us_32();
+    g_lcd_written = true;
+}
+
+void latency_key_end(void)
+{
+    if (!g_pending)
+        return;
+    g_pending = false;
+    // 表示を伴わないキー（シフト単独など）は記録しない
+    if (!g_lcd_written)
+        return;
+    uint32_t us = g_last_lcd_us - g_start_us;
+    latency_kind_t kind = g_switched ? LATENCY_WAKE : LATENCY_FAST;
+    g_hist[kind][bucket_of(us)]++;
+    if (us > g_max_us[kind])
+        g_max_us[kind] = us;
+}
+
+uint32_t latency_bucket(latency_kind_t kind, int bucket)
+{
+    if (kind >= LATENCY_KIND_COUNT || bucket < 0 || bucket >= LATENCY_BUCKETS)
+        return 0;
+    return g_hist[kind][bucket];
+}
+
+uint32_t latency_count(latency_kind_t kind)
+{
+    uint32_t n = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b)
+        n += latency_bucket(kind, b);
+    return n;
+}
+
+uint32_t latency_max_us(latency_kind_t kind)
+{
+    return (kind < LATENCY_KIND_COUNT) ? g_max_us[kind] : 0;
+}
+
+uint32_t latency_bucket_lo_ms(int bucket)
+{
+    return (bucket <= 0) ? 0 : (1u << (bucket - 1));
+}
+
+uint32_t latency_bucket_hi_ms(int bucket)
+{
+    return (bucket >= LATENCY_BUCKETS - 1) ? 0 : (1u << bucket);
+}
+
+uint32_t latency_percentile_ms(latency_kind_t kind, int percent)
+{
+    uint32_t n = latency_count(kind);
+    if (n == 0)
+        return 0;
+    uint32_t target = (uint32_t)(((uint64_t)n * (uint32_t)percent + 99u) / 100u);
+    uint32_t acc = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b)
+    {
+        acc += g_hist[kind][b];
+        if (acc >= target)
+            return (b == LATENCY_BUCKETS - 1) ? latency_bucket_lo_ms(b) : latency_bucket_hi_ms(b);
+    }
+    return 0;
+}
+
+void latency_reset(void)
+{
+    memset(g_hist, 0, sizeof(g_hist));
+    memset(g_max_us, 0, sizeof(g_max_us));
+    g_pending = false;
+}
+
+void latency_dump(void)
+{
+    static const char *const kind_names[LATENCY_KIND_COUNT] = {"fast", "wake"};
+    printf("kind,lo_ms,hi_ms,count\n");
+    for (int k = 0; k < LATENCY_KIND_COUNT; ++k)
+    {
+        for (int b = 0; b < LATENCY_BUCKETS; ++b)
+        {
+            printf("%s,%lu,%lu,%lu\n", kind_names[k], (unsigned long)latency_bucket_lo_ms(b),
+                   (unsigned long)latency_bucket_hi_ms(b), (unsigned long)g_hist[k][b]);
+        }
+        printf("%s,max_us,,%lu\n", kind_names[k], (unsigned long)g_max_us[k]);
+    }
+}
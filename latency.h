@@ -0,0 +1,51 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "key.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// ヒストグラムの区間数: [0]<1ms, [1]1-2ms, [2]2-4ms, ... [10]>=512ms
+#define LATENCY_BUCKETS 11
+
+    // 集計の区分（低電力→高速クロック切替を伴ったかどうか）
+    typedef enum
+    {
+        LATENCY_FAST = 0, // 高速クロックのまま処理
+        LATENCY_WAKE,     // 低電力から復帰して処理
+        LATENCY_KIND_COUNT
+    } latency_kind_t;
+
+    // キー処理の開始（キーリングから取り出したイベントで呼ぶ）
+    void latency_key_begin(const key_event_t *ev);
+    // 低電力→高速クロックへの切替が起きた
+    void latency_note_clock_switch(void);
+    // LCDへの書込みが完了した（LCD.c から呼ぶ）
+    void latency_note_lcd_write(void);
+    // キー処理の終了（最後のLCD書込みまでを1件として記録）
+    void latency_key_end(void);
+
+    // 集計の参照/クリア
+    uint32_t latency_bucket(latency_kind_t kind, int bucket);
+    uint32_t latency_count(latency_kind_t kind);
+    uint32_t latency_max_us(latency_kind_t kind);
+    // 累積が percent[%] に達する区間の上限[ms]（該当なしは0）
+    uint32_t latency_percentile_ms(latency_kind_t kind, int percent);
+    // 区間 bucket の下限/上限[ms]（最終区間の上限は0）
+    uint32_t latency_bucket_lo_ms(int bucket);
+    uint32_t latency_bucket_hi_ms(int bucket);
+    void latency_reset(void);
+
+    // ヒストグラムをCSVでシリアル（stdio）へ出力する
+    void latency_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LATENCY_H
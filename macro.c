@@ -4,7 +4,7 @@
 #include <stdint.h>
 #include "pico/stdlib.h"
 #include "hardware/flash.h"
-#include "hardware/sync.h"
+#include "crc32.h"
 
 #define MACRO_SLOT_COUNT 3
 #define MACRO_MAX_LEN 1024
@@ -42,20 +42,6 @@ typedef struct __attribute__((packed))
 static const uint32_t MACRO_MAGIC = 0x4D414331; // 'MAC1'
 static const uint32_t MACRO_VERSION = 1;
 
-// 簡易CRC32（Poly 0xEDB88320）
-static uint32_t crc32_calc(const void *data, size_t len)
-{
-    uint32_t crc = 0xFFFFFFFFu;
-    const uint8_t *p = (const uint8_t *)data;
-    while (len--)
-    {
-        crc ^= *p++;
-        for (int i = 0; i < 8; i++)
-            crc = (crc >> 1) ^ (0xEDB88320u & (-(int)(crc & 1u)));
-    }
-    return ~crc;
-}
-
 static void macro_load_from_flash(void)
 {
     const macro_blob_t *rom = (const macro_blob_t *)(XIP_BASE + MACRO_FLASH_OFFSET);
@@ -90,11 +76,16 @@ static void macro_load_from_flash(void)
     g_dirty_since_boot = false;
 }
 
-static void macro_save_to_flash(void)
+// 保存ブロブをRAM上に組み立てる（ページ境界までパディング）
+static void macro_build_blob(persist_block_t *out)
 {
-    macro_blob_t blob;
-    blob.magic = MACRO_MAGIC;
-    blob.version = MACRO_VERSION;
+    // フラッシュ書込みは 256 バイト(FLASH_PAGE_SIZE)単位。長さを丸めてパディングする。
+    // パディング用バッファ（RAM上）に直接組み立てる。未使用領域は 0xFF で埋める。
+    static uint8_t pad_buf[(sizeof(macro_blob_t) + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1)];
+    memset(pad_buf, 0xFF, sizeof(pad_buf));
+    macro_blob_t *blob = (macro_blob_t *)pad_buf; // packed なので整列の制約なし
+    blob->magic = MACRO_MAGIC;
+    blob->version = MACRO_VERSION;
     // copy
     for (int i = 0; i < MACRO_SLOT_COUNT; i++)
     {
@@ -103,33 +94,25 @@ static void macro_save_to_flash(void)
             n = 0;
         if (n > MACRO_MAX_LEN)
             n = MACRO_MAX_LEN;
-        blob.slots[i].len = (uint32_t)n;
+        blob->slots[i].len = (uint32_t)n;
         // key_code_t を1バイトに
-        memset(blob.slots[i].seq, 0, MACRO_MAX_LEN);
+        memset(blob->slots[i].seq, 0, MACRO_MAX_LEN);
         for (int j = 0; j < n; j++)
-            blob.slots[i].seq[j] = (uint8_t)g_slots[i].seq[j];
+            blob->slots[i].seq[j] = (uint8_t)g_slots[i].seq[j];
     }
-    blob.crc = crc32_calc(&blob.slots, sizeof(blob.slots));
+    blob->crc = crc32_calc(&blob->slots, sizeof(blob->slots));
 
-    // フラッシュ書込みは 256 バイト(FLASH_PAGE_SIZE)単位。長さを丸めてパディングする。
-    const size_t raw_len = sizeof(blob);
-    const size_t page = FLASH_PAGE_SIZE; // 256
-    size_t write_len = (raw_len + (page - 1)) & ~(page - 1);
-    if (write_len > FLASH_SECTOR_SIZE)
-    {
-        // 安全のため1セクタに制限
-        write_len = FLASH_SECTOR_SIZE;
-    }
-
-    // パディング用バッファ（RAM上）。未使用領域は 0xFF で埋める。
-    static uint8_t pad_buf[FLASH_SECTOR_SIZE];
-    memset(pad_buf, 0xFF, write_len);
-    memcpy(pad_buf, &blob, raw_len);
+    out->flash_offset = MACRO_FLASH_OFFSET;
+    out->data = pad_buf;
+    out->len = sizeof(pad_buf);
+    out->append = false;
+}
 
-    uint32_t ints = save_and_disable_interrupts();
-    flash_range_erase(MACRO_FLASH_OFFSET, FLASH_SECTOR_SIZE);
-    flash_range_program(MACRO_FLASH_OFFSET, pad_buf, write_len);
-    restore_interrupts(ints);
+static bool macro_save_to_flash(void)
+{
+    persist_block_t blk;
+    macro_build_blob(&blk);
+    return persist_write_blocks(&blk, 1);
 }
 
 void macro_init(void)
@@ -174,6 +157,17 @@ bool macro_has(int slot)
     return g_slots[slot].len > 0;
 }
 
+const key_code_t *macro_sequence(int slot, int *len)
+{
+    if (len)
+        *len = 0;
+    if (slot < 0 || slot >= MACRO_SLOT_COUNT || g_slots[slot].len <= 0)
+        return NULL;
+    if (len)
+        *len = g_slots[slot].len;
+    return g_slots[slot].seq;
+}
+
 bool macro_play(int slot)
 {
     if (slot < 0 || slot >= MACRO_SLOT_COUNT)
@@ -206,8 +200,8 @@ void macro_capture_event(key_event_t ev)
         return;
     // 記録対象外キー
     // マクロ専用キーは除外（PR開始/停止、P1/P2/P3再生）
-    // K_MODE はメニュー操作のため除外（UI内での選択は別UIのハンドラが処理）
-    if (ev.code == K_PR || ev.code == K_P1 || ev.code == K_P2 || ev.code == K_P3 || ev.code == K_MODE || ev.code == K_OFF)
+    // K_MODE は記録中はメニューを開かず角度モードの切替になるので、再生で同じ結果になるよう記録する
+    if (ev.code == K_PR || ev.code == K_P1 || ev.code == K_P2 || ev.code == K_P3 || ev.code == K_OFF)
         return;
     if (g_rec_slot < 0 || g_rec_slot >= MACRO_SLOT_COUNT)
         return;
@@ -245,6 +239,7 @@ bool macro_inject_next(key_event_t *out_ev)
     // 1イベント注入（DOWNのみ）
     out_ev->type = KEY_EVENT_DOWN;
     out_ev->code = s->seq[g_play_index++];
+    out_ev->time_us = 0;
     return true;
 }
 
@@ -252,7 +247,20 @@ void macro_save_if_dirty(void)
 {
     if (!g_dirty_since_boot)
         return;
-    macro_save_to_flash();
+    if (macro_save_to_flash())
+        g_dirty_since_boot = false;
+}
+
+bool macro_prepare_save(persist_block_t *out)
+{
+    if (!out || !g_dirty_since_boot)
+        return false;
+    macro_build_blob(out);
+    return true;
+}
+
+void macro_mark_saved(void)
+{
     g_dirty_since_boot = false;
 }
 
@@ -272,6 +280,6 @@ void macro_reset_all(void)
         memset(g_slots[i].seq, 0, sizeof(g_slots[i].seq));
     }
     // 即時保存
-    macro_save_to_flash();
-    g_dirty_since_boot = false;
+    if (macro_save_to_flash())
+        g_dirty_since_boot = false;
 }
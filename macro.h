@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "key.h"
+#include "persist.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -24,6 +25,9 @@ extern "C"
     // スロットにデータがあるか
     bool macro_has(int slot);
 
+    // 記録内容を参照（ヘッドレス実行用、空なら NULL）
+    const key_code_t *macro_sequence(int slot, int *len);
+
     // 再生開始（存在しなければfalse）
     bool macro_play(int slot);
     // 再生中断（ユーザー操作割り込み等）
@@ -37,6 +41,10 @@ extern "C"
 
     // 変更があればフラッシュに保存（電源OFF直前などで呼ぶ）
     void macro_save_if_dirty(void);
+    // 一括保存用: 変更があれば保存ブロブをRAM上に組み立てて true を返す
+    bool macro_prepare_save(persist_block_t *out);
+    // 一括保存の完了後に呼ぶ（dirty解除）
+    void macro_mark_saved(void);
 
     // すべてのマクロスロットを消去し、フラッシュへ即保存
     void macro_reset_all(void);
@@ -0,0 +1,228 @@
+// マクロのヘッドレス実行（ソルバ/積分の関数評価用）
+// 記録済みのキー列を main.c の handle_key と同じ割り当てで直接 rpn_* に渡す。
+// キー注入・描画・FIFO往復を経由しないので、1回の評価が演算そのものの時間で済む
+#include "macro_exec.h"
+#include <stddef.h>
+#include "macro.h"
+#include "RPN.h"
+#include "compute.h"
+
+typedef struct
+{
+    key_code_t code;
+    compute_op_t op;      // 通常
+    compute_op_t hyp_op;  // Hyperbolic=ON 時（NULL なら通常と同じ）
+} exec_op_t;
+
+static const exec_op_t s_exec_ops[] = {
+    {K_ADD, rpn_add, NULL},
+    {K_SUB, rpn_sub, NULL},
+    {K_MUL, rpn_mul, NULL},
+    {K_DIV, rpn_div, NULL},
+    {K_SQRT, rpn_sqrt, NULL},
+    {K_POW2, rpn_pow2, NULL},
+    {K_POW3, rpn_cube, NULL},
+    {K_CUBE_ROOT, rpn_cbrt, NULL},
+    {K_NTH_ROOT, rpn_nth_root, NULL},
+    {K_POW, rpn_pow, NULL},
+    {K_LOG, rpn_log, NULL},
+    {K_LN, rpn_ln, NULL},
+    {K_LOGXY, rpn_logxy, NULL},
+    {K_EXP, rpn_exp, NULL},
+    {K_POW10, rpn_exp10, NULL},
+    {K_FACT, rpn_fact, NULL},
+    {K_REV, rpn_rev, NULL},
+    {K_SIN, rpn_sin, rpn_sinh},
+    {K_COS, rpn_cos, rpn_cosh},
+    {K_TAN, rpn_tan, rpn_tanh},
+    {K_ASIN, rpn_asin, rpn_asinh},
+    {K_ACOS, rpn_acos, rpn_acosh},
+    {K_ATAN, rpn_atan, rpn_atanh},
+    {K_SIGMA_PLUS, rpn_stat_add, NULL},
+    {K_SIGMA_MINUS, rpn_stat_sub, NULL},
+    {K_COMPLEX, rpn_complex, NULL},
+};
+
+static int var_index(key_code_t code)
+{
+    if (code >= K_VA && code <= K_VF)
+        return (int)(code - K_VA);
+    return -1;
+}
+
+static const compute_op_t *find_op(key_code_t code)
+{
+    for (size_t i = 0; i < sizeof(s_exec_ops) / sizeof(s_exec_ops[0]); ++i)
+    {
+        if (s_exec_ops[i].code != code)
+            continue;
+        if (s_exec_ops[i].hyp_op && rpn_get_hyperbolic_mode() == HYPERBOLIC_MODE_ON)
+            return &s_exec_ops[i].hyp_op;
+        return &s_exec_ops[i].op;
+    }
+    return NULL;
+}
+
+static bool exec_sequence(int slot)
+{
+    int len = 0;
+    const key_code_t *seq = macro_sequence(slot, &len);
+    if (!seq)
+        return false;
+
+    // 科学定数UIの操作（C1/C2 → 選択 → ENTER）は状態だけ追う
+    int const_group = 0;
+    int const_sel = 0;
+    rpn_var_set_pending_op(RPN_VAR_OP_NONE);
+
+    for (int i = 0; i < len; ++i)
+    {
+        if (compute_cancel_requested())
+            return false;
+        key_code_t code = seq[i];
+
+        if (const_group)
+        {
+            if (code >= K_1 && code <= K_9)
+                const_sel = (int)(code - K_1);
+            else if (code == K_0)
+                const_sel = 9;
+            else if (code == K_ROLL)
+                const_sel = (const_sel + 1) % 10;
+            else if (code == K_ROLLUP)
+                const_sel = (const_sel == 0) ? 9 : (const_sel - 1);
+            else if (code == K_C1 || code == K_C2)
+                const_group = (code == K_C1) ? 1 : 2;
+            else if (code == K_ENTER)
+            {
+                rpn_const_apply(const_group, const_sel);
+                const_group = 0;
+            }
+            else if (code == K_DEL || code == K_OFF)
+                const_group = 0;
+            continue;
+        }
+
+        // 変数操作（ST/LD/CLR → VA..VF、単押しはロード）
+        if (code == K_ST || code == K_LD || code == K_CLR)
+        {
+            rpn_var_set_pending_op(code == K_ST ? RPN_VAR_OP_ST : code == K_LD ? RPN_VAR_OP_LD : RPN_VAR_OP_CLR);
+            continue;
+        }
+        int vidx = var_index(code);
+        if (vidx >= 0)
+        {
+            if (rpn_var_get_pending_op() == RPN_VAR_OP_NONE)
+                rpn_var_set_pending_op(RPN_VAR_OP_LD);
+            rpn_var_apply_slot(vidx);
+            continue;
+        }
+        if (rpn_var_get_pending_op() != RPN_VAR_OP_NONE)
+        {
+            // 変数名以外は対話時と同じく無視
+            continue;
+        }
+
+        const compute_op_t *op = find_op(code);
+        if (op)
+        {
+            (*op)();
+            continue;
+        }
+
+        switch (code)
+        {
+        case K_0:
+        case K_1:
+        case K_2:
+        case K_3:
+        case K_4:
+        case K_5:
+        case K_6:
+        case K_7:
+        case K_8:
+        case K_9:
+            rpn_input_append_digit(code == K_0 ? '0' : (char)('1' + (code - K_1)));
+            break;
+        case K_DOT:
+            rpn_input_dot();
+            break;
+        case K_EE:
+            rpn_input_exp();
+            break;
+        case K_SIGN:
+            rpn_input_toggle_sign();
+            break;
+        case K_DEL:
+            if (rpn_is_input_active())
+                rpn_input_backspace();
+            else
+                rpn_clear_x();
+            break;
+        case K_ENTER:
+            rpn_enter();
+            break;
+        case K_SWAP:
+            if (rpn_is_input_active())
+                rpn_commit_input_without_push();
+            rpn_swap();
+            break;
+        case K_ROLL:
+            if (rpn_is_input_active())
+                rpn_commit_input_without_push();
+            rpn_roll_down();
+            break;
+        case K_ROLLUP:
+            if (rpn_is_input_active())
+                rpn_commit_input_without_push();
+            rpn_roll_up();
+            break;
+        case K_PI:
+            rpn_input_pi();
+            break;
+        case K_e:
+            rpn_input_e();
+            break;
+        case K_LAST:
+            // Undo は評価の途中状態を壊すので、ヘッドレス実行では常に LAST X とする
+            rpn_last();
+            break;
+        case K_C1:
+        case K_C2:
+            const_group = (code == K_C1) ? 1 : 2;
+            const_sel = 0;
+            break;
+        case K_DISP:
+            // 分数モードでは四則の結果が変わるので handle_key と同じく切り替える
+            rpn_cycle_disp_mode();
+            break;
+        case K_MODE:
+            rpn_cycle_angle_mode();
+            break;
+        case K_SHIFT:
+        case K_SHOW:
+            // 値に影響しない
+            break;
+        default:
+            // 評価中に実行できないキー（マクロ再生/記録、メニュー、電源など）
+            return false;
+        }
+    }
+    // 入力途中で終わった場合は確定して X を結果とする
+    if (rpn_is_input_active())
+        rpn_commit_input_without_push();
+    return true;
+}
+
+bool macro_exec_headless(int slot)
+{
+    // DISP/MODE で切り替えたモードは評価ごとに元へ戻す（反復評価のたびに切替が累積しないように）
+    disp_mode_t disp = rpn_get_disp_mode();
+    angle_mode_t angle = rpn_get_angle_mode();
+    bool ok = exec_sequence(slot);
+    if (rpn_get_disp_mode() != disp)
+        rpn_set_disp_mode(disp);
+    if (rpn_get_angle_mode() != angle)
+        rpn_set_angle_mode(angle);
+    return ok;
+}
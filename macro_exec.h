@@ -0,0 +1,21 @@
+#ifndef MACRO_EXEC_H
+#define MACRO_EXEC_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // マクロをヘッドレスで実行する（LCD更新・キー注入・Undo記録なし）
+    // ソルバ/積分の関数評価用。core1 の演算内から呼ぶ
+    // DISP/MODE キーは対話時と同じくモードを切り替えて評価し、終了時に元のモードへ戻す
+    // 戻り値: 最後まで実行できたら true（未対応キー・取消し・空スロットは false）
+    bool macro_exec_headless(int slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MACRO_EXEC_H
@@ -16,19 +16,55 @@
 #include "macro.h"
 #include "ui_const.h"
 #include "ui_macro.h"
+#include "ui_matrix.h"
+#include "progmode.h"
 #include "resume.h"
+#include "persist.h"
+#include "compute.h"
+#include "profile.h"
+#include "latency.h"
+#include "trace.h"
+#include "energy.h"
+#include "batch.h"
+#include "datalist.h"
+#include "matrix.h"
+
+// "See you!" の最低表示時間（フラッシュ保存と並行して経過させる）
+#define OFF_MESSAGE_MIN_MS 300u
 
 void power_down_seq(void)
 {
+    // OFF押下から電源断までの所要時間の計測起点
+    uint64_t t_off_us = time_us_64();
+    trace_log(TRACE_POWER_OFF, 0, 0);
     key_scan_pause();
     clockctrl_enter_high_speed_12mhz();
-    lcd_clear();
-    lcd_set_cursor(1, 0);
-    lcd_write_str("    See you!    ");
-    settings_save_if_dirty();
-    macro_save_if_dirty();
-    resume_save_if_enabled();
-    sleep_ms(500);
+    uint32_t c0 = profile_cycles(); // サイクル計測はクロック切替後から
+    // プログラマモード中の整数スタックは BID128 に戻してから保存する
+    prog_mode_exit();
+    // クリア命令の待ちを省き、2行とも上書きする
+    lcd_write_line(0, "");
+    lcd_write_line(1, "    See you!    ");
+    // 保存が必要なブロブをすべて組み立ててから1回の消去/書込み区間で保存
+    persist_save_all();
+    // OFF→保存完了の所要時間を常に記録する（USB給電で電源が残る場合は Diag の Profile/Trace Dump で確認できる）
+    uint32_t off_ms = (uint32_t)((time_us_64() - t_off_us) / 1000u);
+    profile_stop("off", c0);
+    trace_log(TRACE_POWER_OFF, 1, (uint16_t)(off_ms > 0xFFFFu ? 0xFFFFu : off_ms));
+#ifdef RPN35_REPORT_OFF_TIME
+    // 計測用ビルド: OFF→電源断の所要時間を上段に表示して少し保持
+    {
+        char line[17];
+        snprintf(line, sizeof(line), "Off:%lums F:%lums", (unsigned long)off_ms,
+                 (unsigned long)(persist_last_flash_us() / 1000u));
+        lcd_write_line(0, line);
+        sleep_ms(1500);
+    }
+#endif
+    // 固定待ちではなく、表示開始からの残り時間だけ待つ
+    uint64_t deadline_us = t_off_us + (uint64_t)OFF_MESSAGE_MIN_MS * 1000u;
+    while (time_us_64() < deadline_us)
+        tight_loop_contents();
     POWER_DOWN;
 }
 
@@ -114,6 +150,7 @@ static bool handle_var_sequence(key_event_t ev)
 // クロックを低速モードに切り替え
 static void enter_low_power_clock(void)
 {
+    trace_log(TRACE_CLOCK, 0, 0);
     key_scan_pause();
     clockctrl_enter_low_power();
     g_last_activity_ms = (uint32_t)to_ms_since_boot(get_absolute_time());
@@ -124,6 +161,8 @@ static void enter_low_power_clock(void)
 // クロックを高速モードに切り替え
 static void enter_high_speed_clock(void)
 {
+    latency_note_clock_switch();
+    trace_log(TRACE_CLOCK, 1, 0);
     key_scan_pause();
     clockctrl_enter_high_speed_12mhz();
     g_last_activity_ms = (uint32_t)to_ms_since_boot(get_absolute_time());
@@ -131,13 +170,58 @@ static void enter_high_speed_clock(void)
     g_low_power = false;
 }
 
-// 表示更新
-static void refresh_display(void)
+// 表示更新（本体）
+// 16桁の行を空白で埋め、v を width 桁に丸めて左寄せで書き込む
+static void format_field(char *line, BID_UINT128 v, int width)
+{
+    char buf16[17];
+    for (int i = 0; i < 16; ++i)
+        line[i] = ' ';
+    bid128_to_str(v, buf16, width + 1);
+    for (int i = 0; i < width && buf16[i] != '\0'; ++i)
+        line[i] = buf16[i];
+}
+
+static void draw_display(void)
 {
     char line[17];
     char buf[40];
+    BID_UINT128 x_im;
+    bool x_complex = rpn_stack_im(0, &x_im);
+    BID_UINT128 x_lo, x_hi;
+    bool x_interval = rpn_stack_interval(0, &x_lo, &x_hi);
+
+    // プログラマモードは整数スタックを専用の形式で表示
+    if (prog_mode_is_active())
+    {
+        prog_mode_render();
+        return;
+    }
 
     // SHOWモード中はXを32桁（2行）に丸めて表示（入力中でも確定値を表示）
+    // 複素数なら上段に実部、下段に虚部を16桁ずつ表示
+    if (g_show_mode && x_complex)
+    {
+        format_field(line, rpn_stack_x(), 16);
+        lcd_set_cursor(0, 0);
+        lcd_write(line, 16);
+        format_field(line, x_im, 15);
+        line[15] = 'i';
+        lcd_set_cursor(1, 0);
+        lcd_write(line, 16);
+        return;
+    }
+    // 区間なら上段に下端、下段に上端
+    if (g_show_mode && x_interval)
+    {
+        format_field(line, x_lo, 16);
+        lcd_set_cursor(0, 0);
+        lcd_write(line, 16);
+        format_field(line, x_hi, 16);
+        lcd_set_cursor(1, 0);
+        lcd_write(line, 16);
+        return;
+    }
     if (g_show_mode)
     {
         BID_UINT128 x = rpn_stack_x();
@@ -185,14 +269,17 @@ static void refresh_display(void)
             }
         }
     }
+    else if (x_interval)
+    {
+        // 区間は中点を表示（半径は上段）
+        BID_UINT128 mid;
+        rpn_interval_mid_rad(x_lo, x_hi, &mid, NULL);
+        format_field(line, mid, 16);
+    }
     else
     {
         // 非入力時は表示幅(16桁)に収まるように丸めた文字列を生成
-        BID_UINT128 x = rpn_stack_x();
-        char buf16[17];
-        bid128_to_str(x, buf16, sizeof(buf16));
-        for (int i = 0; i < 16 && buf16[i] != '\0'; ++i)
-            line[i] = buf16[i];
+        format_field(line, rpn_stack_x(), 16);
     }
     // 下段（X）右端にマクロ状態インジケータを表示
     if (macro_is_recording())
@@ -207,13 +294,39 @@ static void refresh_display(void)
     lcd_write(line, 16);
 
     // 2行目: Y（右端にインジケータ: Shift='s' と 変数オペレータ）
-    BID_UINT128 y = rpn_stack_y();
-    char ybuf16[17];
-    bid128_to_str(y, ybuf16, sizeof(ybuf16));
-    for (int i = 0; i < 16; ++i)
-        line[i] = ' ';
-    for (int i = 0; i < 16 && ybuf16[i] != '\0'; ++i)
-        line[i] = ybuf16[i];
+    // X が複素数なら Y の代わりに X の虚部を、Y だけが複素数なら実部と 'c' を表示
+    // X が区間なら Y の代わりに "+-半径" を、Y だけが区間なら中点と 'r' を表示
+    BID_UINT128 y_lo, y_hi;
+    if (x_complex && !rpn_is_input_active())
+    {
+        format_field(line, x_im, 14);
+        line[14] = 'i';
+    }
+    else if (x_interval && !rpn_is_input_active())
+    {
+        BID_UINT128 rad;
+        rpn_interval_mid_rad(x_lo, x_hi, NULL, &rad);
+        format_field(line, rad, 13);
+        memmove(line + 2, line, 13);
+        line[0] = '+';
+        line[1] = '-';
+    }
+    else if (rpn_stack_interval(1, &y_lo, &y_hi))
+    {
+        BID_UINT128 mid;
+        rpn_interval_mid_rad(y_lo, y_hi, &mid, NULL);
+        format_field(line, mid, 14);
+        line[14] = 'r';
+    }
+    else if (rpn_stack_im(1, NULL))
+    {
+        format_field(line, rpn_stack_y(), 14);
+        line[14] = 'c';
+    }
+    else
+    {
+        format_field(line, rpn_stack_y(), 16);
+    }
     // 右端にインジケータ
     char opch = rpn_var_indicator_char();
     if (opch != '\0')
@@ -228,6 +341,22 @@ static void refresh_display(void)
     lcd_write(line, 16);
 }
 
+// 表示更新（所要時間を計測）
+static void refresh_display(void)
+{
+    uint32_t t0 = profile_cycles();
+    draw_display();
+    profile_stop("refresh", t0);
+}
+
+// 演算を core1 で実行（true: 画面更新要）
+// DEL/OFF で取消されたら演算前の状態に戻し、"Canceled" を表示する
+static bool run_op(compute_op_t op, const char *name)
+{
+    compute_run_op(op, name);
+    return true; // 取消し時も "Canceled" を消すため再描画する
+}
+
 // キー動作割り当て（true: 画面更新要）
 static bool handle_key(key_event_t ev)
 {
@@ -335,17 +464,23 @@ static bool handle_key(key_event_t ev)
 
     // 四則
     case K_ADD:
-        rpn_add();
-        return true;
+        return run_op(rpn_add, "add");
     case K_SUB:
-        rpn_sub();
-        return true;
+        return run_op(rpn_sub, "sub");
     case K_MUL:
-        rpn_mul();
-        return true;
+        return run_op(rpn_mul, "mul");
     case K_DIV:
-        rpn_div();
-        return true;
+        return run_op(rpn_div, "div");
+
+    // 統計（Shift + '+' / '-'）
+    case K_SIGMA_PLUS:
+        return run_op(rpn_stat_add, "stat_add");
+    case K_SIGMA_MINUS:
+        return run_op(rpn_stat_sub, "stat_sub");
+
+    // 複素数（Shift + ENTER）
+    case K_COMPLEX:
+        return run_op(rpn_complex, "complex");
 
     // スタック操作
     case K_SWAP:
@@ -372,82 +507,63 @@ static bool handle_key(key_event_t ev)
 
     // 単項/二項関数
     case K_SQRT:
-        rpn_sqrt();
-        return true;
+        return run_op(rpn_sqrt, "sqrt");
     case K_POW2:
-        rpn_pow2();
-        return true;
+        return run_op(rpn_pow2, "pow2");
     case K_POW3:
-        rpn_cube();
-        return true;
+        return run_op(rpn_cube, "cube");
     case K_CUBE_ROOT:
-        rpn_cbrt();
-        return true;
+        return run_op(rpn_cbrt, "cbrt");
     case K_NTH_ROOT:
-        rpn_nth_root();
-        return true;
+        return run_op(rpn_nth_root, "nth_root");
     case K_POW:
-        rpn_pow();
-        return true;
+        return run_op(rpn_pow, "pow");
     case K_LOG:
-        rpn_log();
-        return true;
+        return run_op(rpn_log, "log");
     case K_LN:
-        rpn_ln();
-        return true;
+        return run_op(rpn_ln, "ln");
     case K_LOGXY:
-        rpn_logxy();
-        return true;
+        return run_op(rpn_logxy, "logxy");
     case K_EXP:
-        rpn_exp();
-        return true;
+        return run_op(rpn_exp, "exp");
     case K_POW10:
-        rpn_exp10();
-        return true;
+        return run_op(rpn_exp10, "exp10");
     case K_FACT:
-        rpn_fact();
-        return true;
+        return run_op(rpn_fact, "fact");
     case K_REV:
-        rpn_rev();
-        return true;
+        return run_op(rpn_rev, "rev");
 
     // 三角関数（HyperbolicモードがONなら双曲線関数に切替）
     case K_SIN:
         if (rpn_get_hyperbolic_mode() == HYPERBOLIC_MODE_ON)
-            rpn_sinh();
+            return run_op(rpn_sinh, "sinh");
         else
-            rpn_sin();
-        return true;
+            return run_op(rpn_sin, "sin");
     case K_COS:
         if (rpn_get_hyperbolic_mode() == HYPERBOLIC_MODE_ON)
-            rpn_cosh();
+            return run_op(rpn_cosh, "cosh");
         else
-            rpn_cos();
-        return true;
+            return run_op(rpn_cos, "cos");
     case K_TAN:
         if (rpn_get_hyperbolic_mode() == HYPERBOLIC_MODE_ON)
-            rpn_tanh();
+            return run_op(rpn_tanh, "tanh");
         else
-            rpn_tan();
-        return true;
+            return run_op(rpn_tan, "tan");
     case K_ASIN:
         if (rpn_get_hyperbolic_mode() == HYPERBOLIC_MODE_ON)
-            rpn_asinh();
+            return run_op(rpn_asinh, "asinh");
         else
-            rpn_asin();
-        return true;
+            return run_op(rpn_asin, "asin");
     case K_ACOS:
         if (rpn_get_hyperbolic_mode() == HYPERBOLIC_MODE_ON)
-            rpn_acosh();
+            return run_op(rpn_acosh, "acosh");
         else
-            rpn_acos();
-        return true;
+            return run_op(rpn_acos, "acos");
     case K_ATAN:
         if (rpn_get_hyperbolic_mode() == HYPERBOLIC_MODE_ON)
-            rpn_atanh();
+            return run_op(rpn_atanh, "atanh");
         else
-            rpn_atan();
-        return true;
+            return run_op(rpn_atan, "atan");
 
     // 定数
     case K_PI:
@@ -524,19 +640,12 @@ static bool handle_key(key_event_t ev)
 
     // 表示/モード
     case K_DISP:
-    {
-        disp_mode_t m = rpn_get_disp_mode();
-        m = (m == DISP_MODE_ENGINEERING) ? DISP_MODE_NORMAL : (disp_mode_t)(m + 1);
-        rpn_set_disp_mode(m);
+        rpn_cycle_disp_mode();
         return true;
-    }
     case K_MODE:
-    {
-        angle_mode_t a = rpn_get_angle_mode();
-        a = (a == ANGLE_MODE_GRAD) ? ANGLE_MODE_DEG : (angle_mode_t)(a + 1);
-        rpn_set_angle_mode(a);
+        // メニューを開かないとき（マクロ記録中/再生中）は角度モードの切替
+        rpn_cycle_angle_mode();
         return true;
-    }
     case K_SHOW:
     {
         // SHOW表示をトグル
@@ -596,11 +705,19 @@ int main(void)
     pll_deinit(pll_usb);
     pll_deinit(pll_sys);
 
+#if RPN35_SERIAL_BATCH
+    // UART のボーレートが低電力時のクロック切替に影響されないよう XOSC から直接供給
+    clock_configure_undivided(clk_peri,
+                              0,
+                              CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_XOSC_CLKSRC,
+                              12 * MHZ);
+#else
     // PLLは無効なのでクロックは供給されない
     clock_configure_undivided(clk_peri,
                               CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
                               0,
                               0);
+#endif
     clock_configure_undivided(clk_adc,
                               CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
                               0,
@@ -614,6 +731,14 @@ int main(void)
                               0,
                               0);
 
+    // サイクルカウンタ有効化（core1 側は compute_init で有効化）
+    profile_init();
+
+    // イベントトレース開始
+    trace_init();
+    // 状態別の滞在時間の計測開始（12MHz 動作から）
+    energy_init();
+
     // 電源ラッチ
     gpio_init(POWER_EN);
     gpio_set_dir(POWER_EN, GPIO_OUT);
@@ -644,10 +769,17 @@ int main(void)
     key_init();
     // 計算エンジン初期化
     init_rpn();
+    // 演算コア(core1)起動
+    compute_init();
+    // シリアル一括計算の受付開始（無効ビルドでは何もしない）
+    batch_init();
     // マクロ初期化
     macro_init();
     // レジューム復帰（有効時・正常時のみ）
     resume_try_restore_on_boot();
+    // データリスト復帰（Resume=ON の場合のみ）
+    datalist_init();
+    matrix_init();
     // LCDクリア
     lcd_clear();
     // 初期画面表示
@@ -673,10 +805,13 @@ int main(void)
         else
         {
             ev = key_poll();
+            // 応答遅延の計測開始（検出時刻から最後のLCD書込みまで）
+            latency_key_begin(&ev);
         }
         bool need_refresh = false;
         if (ev.type != KEY_EVENT_NONE)
         {
+            trace_log(TRACE_KEY, (uint8_t)ev.code, (uint16_t)(ev.type | (injected ? 0x100 : 0)));
             // 低電力中にキーが来たら高速クロックへ切り替え
             if (g_low_power)
                 enter_high_speed_clock();
@@ -719,6 +854,18 @@ int main(void)
                     bool handled = macro_ui_handle_key(ev);
                     need_refresh = handled || need_refresh;
                 }
+                // 行列エディタ（メニューから開く。メニュー操作と同じく記録しない）
+                else if (matrix_ui_is_open())
+                {
+                    bool handled = matrix_ui_handle_key(ev);
+                    need_refresh = handled || need_refresh;
+                }
+                // プログラマモード（OFF だけは通常処理で電源を切る）
+                else if (prog_mode_is_active() && ev.code != K_OFF)
+                {
+                    bool handled = prog_mode_handle_key(ev);
+                    need_refresh = handled || need_refresh;
+                }
                 else
                 {
                     // 記録フック（注入/メニュー/マクロUI/定数UI中は除外）
@@ -727,8 +874,8 @@ int main(void)
                         macro_capture_event(ev);
                     }
 
-                    // メニュー開閉トグル（定数UI中はブロック）
-                    if (ev.type != KEY_EVENT_UP && ev.code == K_MODE && !menu_is_open() && !macro_is_recording())
+                    // メニュー開閉トグル（定数UI中はブロック。記録中と再生中は角度切替として handle_key へ）
+                    if (ev.type != KEY_EVENT_UP && ev.code == K_MODE && !menu_is_open() && !macro_is_recording() && !injected)
                     {
                         menu_open();
                         menu_render();
@@ -737,10 +884,10 @@ int main(void)
                     {
                         // メニュー表示中のキー処理
                         bool handled = menu_handle_key(ev);
-                        // メニューが閉じられた場合は通常画面を再描画
+                        // メニューが閉じられた場合は通常画面を再描画（行列エディタへ移った場合は描画済み）
                         if (!menu_is_open())
                         {
-                            need_refresh = true;
+                            need_refresh = !matrix_ui_is_open();
                         }
                         else if (handled)
                         {
@@ -755,8 +902,23 @@ int main(void)
                 }
             }
         }
+        // シリアルからの一括計算（通常画面のときのみ。LCD は1行処理し終えてから更新）
+        if (!g_show_mode && !menu_is_open() && !macro_ui_is_open() && !const_ui_is_open() && !matrix_ui_is_open() &&
+            !prog_mode_is_active() && !macro_is_playing() && !macro_is_recording())
+        {
+            if (batch_poll())
+            {
+                if (g_low_power)
+                    enter_high_speed_clock();
+                g_last_activity_ms = (uint32_t)to_ms_since_boot(get_absolute_time());
+                need_refresh = true;
+            }
+        }
+
         if (need_refresh)
             refresh_display();
+        if (!injected)
+            latency_key_end();
 
         // マクロ再生/記録の状態変化でインジケータを更新
         bool now_playing = macro_is_playing();
@@ -764,7 +926,7 @@ int main(void)
         if ((s_prev_macro_playing && !now_playing) || (s_prev_macro_recording && !now_recording))
         {
             // 他のUI表示中は通常画面を上書きしない
-            if (!menu_is_open() && !macro_ui_is_open() && !const_ui_is_open())
+            if (!menu_is_open() && !macro_ui_is_open() && !const_ui_is_open() && !matrix_ui_is_open())
             {
                 refresh_display();
             }
@@ -788,6 +950,8 @@ int main(void)
             now_ms = (uint32_t)to_ms_since_boot(get_absolute_time());
             if ((uint32_t)(now_ms - g_last_activity_ms) >= idle_to_low_ms)
             {
+                // 低速化の直前（高速クロックのうち）にレジューム用チェックポイントを追記
+                resume_checkpoint_idle();
                 enter_low_power_clock();
             }
         }
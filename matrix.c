@@ -0,0 +1,359 @@
+// 小さな行列（最大 6x6）の変数と演算
+// 要素は行優先で詰めて持つ（stride = 列数）。LU 分解は部分ピボット選択で、
+// 消去の内側ループが1行分の連続した要素を順に読み書きするようにしている。
+// 6x6 の連立方程式は 乗加算 約85回 + 除算 21回程度なので 12MHz でも数十ms で終わる
+#include "matrix.h"
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "bid_ops.h"
+#include "crc32.h"
+#include "settings.h"
+
+// settings: 最終, macros: 2番目, resume: 3,4番目, trace: 5番目, datalist: 6番目、本モジュール: 末尾から7番目
+#define MATRIX_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - 7 * FLASH_SECTOR_SIZE)
+#define MATRIX_ELEMS (MATRIX_MAX_DIM * MATRIX_MAX_DIM)
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic; // 'MAT1'
+    uint32_t crc;   // rows 以降のCRC32
+    uint8_t rows[MATRIX_COUNT];
+    uint8_t cols[MATRIX_COUNT];
+    uint8_t reserved[2];
+    BID_UINT128 elems[MATRIX_COUNT][MATRIX_ELEMS];
+} matrix_blob_t;
+_Static_assert(sizeof(matrix_blob_t) <= FLASH_SECTOR_SIZE, "matrices must fit in one sector");
+
+static const uint32_t MATRIX_MAGIC = 0x3154414Du; // 'MAT1'
+
+// 行列変数の領域
+static BID_UINT128 g_elems[MATRIX_COUNT][MATRIX_ELEMS];
+static uint8_t g_rows[MATRIX_COUNT];
+static uint8_t g_cols[MATRIX_COUNT];
+static bool g_dirty = false;
+static matrix_status_t g_status = MATRIX_OK;
+
+// LU 分解の作業領域（L は対角より下、U は対角を含む上。L の対角 1 は持たない）
+static BID_UINT128 g_lu[MATRIX_ELEMS];
+static uint8_t g_perm[MATRIX_MAX_DIM];
+static BID_UINT128 g_rhs[MATRIX_ELEMS];
+
+static inline bool valid_id(matrix_id_t m)
+{
+    return (unsigned)m < MATRIX_COUNT;
+}
+
+static void fill_zero(BID_UINT128 *p, int n)
+{
+    const BID_UINT128 zero = d_from_int(0);
+    for (int i = 0; i < n; ++i)
+        p[i] = zero;
+}
+
+void matrix_clear_all(void)
+{
+    for (int m = 0; m < MATRIX_COUNT; ++m)
+    {
+        g_rows[m] = 2;
+        g_cols[m] = 2;
+        fill_zero(g_elems[m], MATRIX_ELEMS);
+    }
+    g_dirty = true;
+}
+
+int matrix_rows(matrix_id_t m) { return valid_id(m) ? g_rows[m] : 0; }
+int matrix_cols(matrix_id_t m) { return valid_id(m) ? g_cols[m] : 0; }
+
+bool matrix_set_dims(matrix_id_t m, int rows, int cols)
+{
+    if (!valid_id(m) || rows < 1 || rows > MATRIX_MAX_DIM || cols < 1 || cols > MATRIX_MAX_DIM)
+        return false;
+    if (rows == g_rows[m] && cols == g_cols[m])
+        return true;
+    // 詰め直し（重なる部分は位置 (r,c) を保つ）
+    BID_UINT128 tmp[MATRIX_ELEMS];
+    fill_zero(tmp, rows * cols);
+    int keep_r = rows < g_rows[m] ? rows : g_rows[m];
+    int keep_c = cols < g_cols[m] ? cols : g_cols[m];
+    for (int r = 0; r < keep_r; ++r)
+        memcpy(&tmp[r * cols], &g_elems[m][r * g_cols[m]], (size_t)keep_c * sizeof(BID_UINT128));
+    memcpy(g_elems[m], tmp, (size_t)(rows * cols) * sizeof(BID_UINT128));
+    g_rows[m] = (uint8_t)rows;
+    g_cols[m] = (uint8_t)cols;
+    g_dirty = true;
+    return true;
+}
+
+bool matrix_get(matrix_id_t m, int row, int col, BID_UINT128 *out)
+{
+    if (!valid_id(m) || row < 0 || row >= g_rows[m] || col < 0 || col >= g_cols[m] || !out)
+        return false;
+    *out = g_elems[m][row * g_cols[m] + col];
+    return true;
+}
+
+bool matrix_set(matrix_id_t m, int row, int col, BID_UINT128 v)
+{
+    if (!valid_id(m) || row < 0 || row >= g_rows[m] || col < 0 || col >= g_cols[m])
+        return false;
+    g_elems[m][row * g_cols[m] + col] = v;
+    g_dirty = true;
+    return true;
+}
+
+void matrix_copy(matrix_id_t dst, matrix_id_t src)
+{
+    if (!valid_id(dst) || !valid_id(src) || dst == src)
+        return;
+    g_rows[dst] = g_rows[src];
+    g_cols[dst] = g_cols[src];
+    memcpy(g_elems[dst], g_elems[src], sizeof(g_elems[0]));
+    g_dirty = true;
+}
+
+// A（n x n）を g_lu に写して LU 分解する。特異なら false
+// 行を入れ替えた回数が奇数なら *odd = true（行列式の符号）
+static bool lu_decompose(int n, bool *odd)
+{
+    memcpy(g_lu, g_elems[MATRIX_A], (size_t)(n * n) * sizeof(BID_UINT128));
+    *odd = false;
+    for (int i = 0; i < n; ++i)
+        g_perm[i] = (uint8_t)i;
+    for (int k = 0; k < n; ++k)
+    {
+        // 部分ピボット選択: k 列で絶対値が最大の行を選ぶ
+        int p = k;
+        BID_UINT128 best = d_abs(g_lu[k * n + k]);
+        for (int i = k + 1; i < n; ++i)
+        {
+            BID_UINT128 a = d_abs(g_lu[i * n + k]);
+            if (d_gt(a, best))
+            {
+                best = a;
+                p = i;
+            }
+        }
+        if (d_is_zero(best))
+            return false;
+        if (p != k)
+        {
+            BID_UINT128 row[MATRIX_MAX_DIM];
+            memcpy(row, &g_lu[k * n], (size_t)n * sizeof(BID_UINT128));
+            memcpy(&g_lu[k * n], &g_lu[p * n], (size_t)n * sizeof(BID_UINT128));
+            memcpy(&g_lu[p * n], row, (size_t)n * sizeof(BID_UINT128));
+            uint8_t t = g_perm[k];
+            g_perm[k] = g_perm[p];
+            g_perm[p] = t;
+            *odd = !*odd;
+        }
+        const BID_UINT128 *rk = &g_lu[k * n];
+        for (int i = k + 1; i < n; ++i)
+        {
+            BID_UINT128 *ri = &g_lu[i * n];
+            if (d_is_zero(ri[k]))
+                continue;
+            BID_UINT128 l = d_div(ri[k], rk[k]);
+            ri[k] = l;
+            // ri[j] -= l·rk[j]（乗加算は1回の丸め）
+            BID_UINT128 nl = d_neg(l);
+            for (int j = k + 1; j < n; ++j)
+                ri[j] = d_fma(nl, rk[j], ri[j]);
+        }
+    }
+    return true;
+}
+
+// 分解済みの g_lu で A·X = B（B は n x k、行優先）を解き、out（n x k）に書く
+static void lu_solve(int n, const BID_UINT128 *b, int k, BID_UINT128 *out)
+{
+    BID_UINT128 y[MATRIX_MAX_DIM];
+    for (int c = 0; c < k; ++c)
+    {
+        // 前進代入（L の対角は 1）
+        for (int i = 0; i < n; ++i)
+        {
+            const BID_UINT128 *ri = &g_lu[i * n];
+            BID_UINT128 s = b[g_perm[i] * k + c];
+            for (int j = 0; j < i; ++j)
+                s = d_fma(d_neg(ri[j]), y[j], s);
+            y[i] = s;
+        }
+        // 後退代入
+        for (int i = n - 1; i >= 0; --i)
+        {
+            const BID_UINT128 *ri = &g_lu[i * n];
+            BID_UINT128 s = y[i];
+            for (int j = i + 1; j < n; ++j)
+                s = d_fma(d_neg(ri[j]), y[j], s);
+            y[i] = d_div(s, ri[i]);
+        }
+        for (int i = 0; i < n; ++i)
+            out[i * k + c] = y[i];
+    }
+}
+
+// 結果を C に置く（大きさを変え、書き込み先を返す）
+static BID_UINT128 *result_c(int rows, int cols)
+{
+    g_rows[MATRIX_C] = (uint8_t)rows;
+    g_cols[MATRIX_C] = (uint8_t)cols;
+    g_dirty = true;
+    return g_elems[MATRIX_C];
+}
+
+void matrix_op_det(void)
+{
+    int n = g_rows[MATRIX_A];
+    if (n != g_cols[MATRIX_A])
+    {
+        g_status = MATRIX_BAD_DIM;
+        return;
+    }
+    g_status = MATRIX_OK;
+    bool odd = false;
+    BID_UINT128 det = d_from_int(0);
+    if (lu_decompose(n, &odd))
+    {
+        det = d_from_int(odd ? -1 : 1);
+        for (int k = 0; k < n; ++k)
+            det = d_mul(det, g_lu[k * n + k]);
+    }
+    rpn_input_value(det);
+}
+
+void matrix_op_inverse(void)
+{
+    int n = g_rows[MATRIX_A];
+    if (n != g_cols[MATRIX_A])
+    {
+        g_status = MATRIX_BAD_DIM;
+        return;
+    }
+    bool odd;
+    if (!lu_decompose(n, &odd))
+    {
+        g_status = MATRIX_SINGULAR;
+        return;
+    }
+    // 単位行列を右辺にして解く
+    const BID_UINT128 one = d_from_int(1);
+    fill_zero(g_rhs, n * n);
+    for (int i = 0; i < n; ++i)
+        g_rhs[i * n + i] = one;
+    lu_solve(n, g_rhs, n, result_c(n, n));
+    g_status = MATRIX_OK;
+}
+
+void matrix_op_transpose(void)
+{
+    int rows = g_rows[MATRIX_A];
+    int cols = g_cols[MATRIX_A];
+    const BID_UINT128 *a = g_elems[MATRIX_A];
+    BID_UINT128 *c = result_c(cols, rows);
+    for (int r = 0; r < rows; ++r)
+        for (int k = 0; k < cols; ++k)
+            c[k * rows + r] = a[r * cols + k];
+    g_status = MATRIX_OK;
+}
+
+void matrix_op_multiply(void)
+{
+    int n = g_rows[MATRIX_A];
+    int inner = g_cols[MATRIX_A];
+    int k = g_cols[MATRIX_B];
+    if (inner != g_rows[MATRIX_B])
+    {
+        g_status = MATRIX_BAD_DIM;
+        return;
+    }
+    const BID_UINT128 *a = g_elems[MATRIX_A];
+    const BID_UINT128 *b = g_elems[MATRIX_B];
+    BID_UINT128 *c = result_c(n, k);
+    // 行優先で C の1行ずつ、A の行 × B の行を積み上げる（どちらも連続アクセス）
+    fill_zero(c, n * k);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < inner; ++j)
+        {
+            BID_UINT128 aij = a[i * inner + j];
+            if (d_is_zero(aij))
+                continue;
+            for (int col = 0; col < k; ++col)
+                c[i * k + col] = d_fma(aij, b[j * k + col], c[i * k + col]);
+        }
+    }
+    g_status = MATRIX_OK;
+}
+
+void matrix_op_solve(void)
+{
+    int n = g_rows[MATRIX_A];
+    int k = g_cols[MATRIX_B];
+    if (n != g_cols[MATRIX_A] || g_rows[MATRIX_B] != n)
+    {
+        g_status = MATRIX_BAD_DIM;
+        return;
+    }
+    bool odd;
+    if (!lu_decompose(n, &odd))
+    {
+        g_status = MATRIX_SINGULAR;
+        return;
+    }
+    lu_solve(n, g_elems[MATRIX_B], k, result_c(n, k));
+    g_status = MATRIX_OK;
+}
+
+matrix_status_t matrix_last_status(void)
+{
+    return g_status;
+}
+
+void matrix_init(void)
+{
+    matrix_clear_all();
+    g_dirty = false;
+    if (!settings_get_resume_enabled())
+        return;
+    const matrix_blob_t *rom = (const matrix_blob_t *)(XIP_BASE + MATRIX_FLASH_OFFSET);
+    if (rom->magic != MATRIX_MAGIC)
+        return;
+    if (crc32_calc(rom->rows, sizeof(matrix_blob_t) - offsetof(matrix_blob_t, rows)) != rom->crc)
+        return;
+    for (int m = 0; m < MATRIX_COUNT; ++m)
+    {
+        if (rom->rows[m] < 1 || rom->rows[m] > MATRIX_MAX_DIM || rom->cols[m] < 1 || rom->cols[m] > MATRIX_MAX_DIM)
+            return;
+    }
+    memcpy(g_rows, (const void *)rom->rows, sizeof(g_rows));
+    memcpy(g_cols, (const void *)rom->cols, sizeof(g_cols));
+    memcpy(g_elems, (const void *)rom->elems, sizeof(g_elems));
+}
+
+bool matrix_prepare_save(persist_block_t *out)
+{
+    if (!out || !g_dirty || !settings_get_resume_enabled())
+        return false;
+    static uint8_t pad_buf[(sizeof(matrix_blob_t) + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1)];
+    memset(pad_buf, 0xFF, sizeof(pad_buf));
+    matrix_blob_t *blob = (matrix_blob_t *)pad_buf; // packed なので整列の制約なし
+    blob->magic = MATRIX_MAGIC;
+    memcpy(blob->rows, g_rows, sizeof(g_rows));
+    memcpy(blob->cols, g_cols, sizeof(g_cols));
+    memset(blob->reserved, 0, sizeof(blob->reserved));
+    memcpy(blob->elems, g_elems, sizeof(g_elems));
+    blob->crc = crc32_calc(blob->rows, sizeof(matrix_blob_t) - offsetof(matrix_blob_t, rows));
+
+    out->flash_offset = MATRIX_FLASH_OFFSET;
+    out->data = pad_buf;
+    out->len = sizeof(pad_buf);
+    out->append = false;
+    return true;
+}
+
+void matrix_mark_saved(void)
+{
+    g_dirty = false;
+}
@@ -0,0 +1,62 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <stdbool.h>
+#include "RPN.h"
+#include "persist.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 行列変数の数（A, B, C）と最大サイズ
+#define MATRIX_COUNT 3
+#define MATRIX_MAX_DIM 6
+
+    typedef enum
+    {
+        MATRIX_A = 0,
+        MATRIX_B,
+        MATRIX_C, // 演算結果の格納先
+    } matrix_id_t;
+
+    typedef enum
+    {
+        MATRIX_OK,
+        MATRIX_BAD_DIM,  // 正方行列でない、または A と B の大きさが合わない
+        MATRIX_SINGULAR, // 特異（ピボットが 0）
+    } matrix_status_t;
+
+    // 起動時: Resume=ON ならフラッシュから行列を復元
+    void matrix_init(void);
+
+    // 大きさ（1..MATRIX_MAX_DIM）。変更時は重なる部分の要素を残し、増えた部分は 0
+    int matrix_rows(matrix_id_t m);
+    int matrix_cols(matrix_id_t m);
+    bool matrix_set_dims(matrix_id_t m, int rows, int cols);
+    // 要素の参照/設定（row, col は 0 始まり、範囲外は false）
+    bool matrix_get(matrix_id_t m, int row, int col, BID_UINT128 *out);
+    bool matrix_set(matrix_id_t m, int row, int col, BID_UINT128 v);
+    // C を A または B に複写する
+    void matrix_copy(matrix_id_t dst, matrix_id_t src);
+    // すべて 2x2 の零行列に戻す
+    void matrix_clear_all(void);
+
+    // 行列演算（core1 で compute_run から実行する）。結果は matrix_last_status() で確認
+    void matrix_op_det(void);       // X に det A を置く（前の値は push）
+    void matrix_op_inverse(void);   // C ← A⁻¹
+    void matrix_op_transpose(void); // C ← Aᵀ
+    void matrix_op_multiply(void);  // C ← A·B
+    void matrix_op_solve(void);     // C ← A·C = B の解（B の各列について解く）
+    matrix_status_t matrix_last_status(void);
+
+    // 一括保存用: Resume=ON かつ変更があれば保存ブロブを組み立てて true
+    bool matrix_prepare_save(persist_block_t *out);
+    void matrix_mark_saved(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MATRIX_H
@@ -6,6 +6,18 @@
 #include "RPN.h"
 #include "settings.h"
 #include "macro.h"
+#include "profile.h"
+#include "latency.h"
+#include "trace.h"
+#include "energy.h"
+#include "compute.h"
+#include "datalist.h"
+#include "solver.h"
+#include "integrate.h"
+#include "bid_ops.h"
+#include "matrix.h"
+#include "ui_matrix.h"
+#include "progmode.h"
 #include "pico/stdlib.h"
 #include "settings.h"
 
@@ -95,6 +107,14 @@ static void set_last_key_mode_enum(int v) { settings_set_last_key_mode((last_key
 // Resume toggle
 static int get_resume_enum(void) { return settings_get_resume_enabled() ? 1 : 0; }
 static void set_resume_enum(int v) { settings_set_resume_enabled(v ? true : false); }
+static int get_precision_enum(void) { return (int)settings_get_precision(); }
+static void set_precision_enum(int v) { settings_set_precision((precision_mode_t)v); }
+static const char *const precision_labels[] = {"34", "16"};
+static int get_complex_enum(void) { return settings_get_complex_results() ? 1 : 0; }
+static void set_complex_enum(int v) { settings_set_complex_results(v ? true : false); }
+// 区間演算モード（保存しない）
+static int get_interval_enum(void) { return rpn_get_interval_mode() ? 1 : 0; }
+static void set_interval_enum(int v) { rpn_set_interval_mode(v ? true : false); }
 
 // アクション関数
 static void action_reset_calculator(void)
@@ -117,7 +137,7 @@ static void action_reset_calculator(void)
             {
                 break; // 確定して実行へ
             }
-            if (ev.code == K_DEL || ev.code == K_OFF)
+            if (key_is_cancel_event(ev))
             {
                 // キャンセル：メニューに戻る
                 g_menu.redraw_needed = true;
@@ -134,6 +154,8 @@ static void action_reset_calculator(void)
 
     // RPN 実体の状態も初期化（フラッシュから既定値を再読込）
     init_rpn();
+    datalist_clear();
+    matrix_clear_all();
 
     // 入力/キー状態の残渣をクリアしてから再開
     key_reset();
@@ -327,14 +349,606 @@ static void action_about(void)
     }
 }
 
+// サイクル数を6文字以内に収める（k/M 単位）
+static void format_cycles(char *out, size_t size, uint32_t v)
+{
+    if (v < 1000000u)
+        snprintf(out, size, "%lu", (unsigned long)v);
+    else if (v < 1000000000u)
+        snprintf(out, size, "%luk", (unsigned long)(v / 1000u));
+    else
+        snprintf(out, size, "%luM", (unsigned long)(v / 1000000u));
+}
+
+// プロファイル表示（1項目/画面）
+// page 0: 平均/最大サイクル、page 1: 最小サイクル/直近[us]
+static void render_profile_screen(int index, int page)
+{
+    char line1[17];
+    char line2[17];
+    const profile_entry_t *e = profile_get(index);
+    if (!e)
+    {
+        snprintf(line1, sizeof(line1), "%-16s", "No samples");
+        snprintf(line2, sizeof(line2), "%-16s", "");
+    }
+    else
+    {
+        char a[12], b[12], label[24];
+        // 条件付きの項目は "add/16" のように表示
+        snprintf(label, sizeof(label), e->tag ? "%s/%s" : "%s", e->name, e->tag);
+        snprintf(line1, sizeof(line1), "%-10.10s%6lu", label, (unsigned long)e->count);
+        if (page == 0)
+        {
+            format_cycles(a, sizeof(a), e->count ? (uint32_t)(e->total_cycles / e->count) : 0);
+            format_cycles(b, sizeof(b), e->max_cycles);
+            snprintf(line2, sizeof(line2), "Av%-6.6s Mx%-5.5s", a, b);
+        }
+        else
+        {
+            format_cycles(a, sizeof(a), e->count ? e->min_cycles : 0);
+            snprintf(line2, sizeof(line2), "Mn%-6.6s L%luus", a, (unsigned long)e->last_us);
+        }
+        for (int i = (int)strlen(line2); i < 16; ++i)
+            line2[i] = ' ';
+    }
+    lcd_set_cursor(0, 0);
+    lcd_write(line1, 16);
+    lcd_set_cursor(1, 0);
+    lcd_write(line2, 16);
+}
+
+// 演算/表示/LCD/フラッシュの所要サイクル一覧
+// +/ROLL: 次、-/ROLLUP: 前、.: 表示切替、CLR: 集計クリア、ENTER/DEL/OFF: 戻る
+static void action_diag_profile(void)
+{
+    int index = 0;
+    int page = 0;
+    key_set_shift_state(false);
+    render_profile_screen(index, page);
+    while (1)
+    {
+        key_event_t ev = key_poll();
+        if (ev.type != KEY_EVENT_DOWN && ev.type != KEY_EVENT_REPEAT)
+        {
+            sleep_ms(10);
+            continue;
+        }
+        int n = profile_count();
+        if (ev.code == K_ADD || ev.code == K_ROLL)
+        {
+            if (n > 0)
+                index = (index + 1) % n;
+        }
+        else if (ev.code == K_SUB || ev.code == K_ROLLUP)
+        {
+            if (n > 0)
+                index = (index + n - 1) % n;
+        }
+        else if (ev.code == K_DOT)
+        {
+            page ^= 1;
+        }
+        else if (ev.code == K_CLR)
+        {
+            profile_reset();
+            index = 0;
+        }
+        else if (ev.code == K_ENTER || key_is_cancel_event(ev))
+        {
+            break;
+        }
+        render_profile_screen(index, page);
+    }
+    key_set_shift_state(false);
+    g_menu.redraw_needed = true;
+}
+
+// 応答遅延表示
+// bucket<0: 概要（件数/中央値/最大）、bucket>=0: 区間ごとの件数
+static void render_latency_screen(latency_kind_t kind, int bucket)
+{
+    char line1[17];
+    char line2[17];
+    const char *label = (kind == LATENCY_WAKE) ? "Wake" : "Fast";
+    uint32_t n = latency_count(kind);
+    if (bucket < 0)
+    {
+        snprintf(line1, sizeof(line1), "%s n:%-10lu", label, (unsigned long)n);
+        snprintf(line2, sizeof(line2), "p50<%lums mx%lums", (unsigned long)latency_percentile_ms(kind, 50),
+                 (unsigned long)(latency_max_us(kind) / 1000u));
+    }
+    else
+    {
+        uint32_t lo = latency_bucket_lo_ms(bucket);
+        uint32_t hi = latency_bucket_hi_ms(bucket);
+        if (hi == 0)
+            snprintf(line1, sizeof(line1), "%s >=%lums", label, (unsigned long)lo);
+        else
+            snprintf(line1, sizeof(line1), "%s %lu-%lums", label, (unsigned long)lo, (unsigned long)hi);
+        uint32_t c = latency_bucket(kind, bucket);
+        uint32_t pct = n ? (uint32_t)((uint64_t)c * 100u / n) : 0;
+        snprintf(line2, sizeof(line2), "%lu (%lu%%)", (unsigned long)c, (unsigned long)pct);
+    }
+    for (int i = (int)strlen(line1); i < 16; ++i)
+        line1[i] = ' ';
+    for (int i = (int)strlen(line2); i < 16; ++i)
+        line2[i] = ' ';
+    lcd_set_cursor(0, 0);
+    lcd_write(line1, 16);
+    lcd_set_cursor(1, 0);
+    lcd_write(line2, 16);
+}
+
+// キー押下→表示の応答遅延ヒストグラム
+// +/ROLL: 次区間、-/ROLLUP: 前区間、.: Fast/Wake切替、SHOW: シリアル出力、CLR: クリア
+static void action_diag_latency(void)
+{
+    latency_kind_t kind = LATENCY_FAST;
+    int bucket = -1;
+    key_set_shift_state(false);
+    render_latency_screen(kind, bucket);
+    while (1)
+    {
+        key_event_t ev = key_poll();
+        if (ev.type != KEY_EVENT_DOWN && ev.type != KEY_EVENT_REPEAT)
+        {
+            sleep_ms(10);
+            continue;
+        }
+        if (ev.code == K_ADD || ev.code == K_ROLL)
+        {
+            if (bucket < LATENCY_BUCKETS - 1)
+                bucket++;
+        }
+        else if (ev.code == K_SUB || ev.code == K_ROLLUP)
+        {
+            if (bucket >= 0)
+                bucket--;
+        }
+        else if (ev.code == K_DOT)
+        {
+            kind = (kind == LATENCY_FAST) ? LATENCY_WAKE : LATENCY_FAST;
+        }
+        else if (ev.code == K_SHOW)
+        {
+            latency_dump();
+        }
+        else if (ev.code == K_CLR)
+        {
+            latency_reset();
+        }
+        else if (ev.code == K_ENTER || key_is_cancel_event(ev))
+        {
+            break;
+        }
+        render_latency_screen(kind, bucket);
+    }
+    key_set_shift_state(false);
+    g_menu.redraw_needed = true;
+}
+
+// 経過時間を "12m34s" / "1h02m" 形式にする
+static void format_duration(char *out, size_t size, uint32_t ms)
+{
+    uint32_t s = ms / 1000u;
+    if (s < 3600u)
+        snprintf(out, size, "%lum%02lus", (unsigned long)(s / 60u), (unsigned long)(s % 60u));
+    else
+        snprintf(out, size, "%luh%02lum", (unsigned long)(s / 3600u), (unsigned long)((s / 60u) % 60u));
+}
+
+// 消費見積り表示
+// state<0: セッション合計、state>=0: 状態ごとの滞在時間/割合/消費量
+static void render_energy_screen(int state)
+{
+    static const char *const state_labels[ENERGY_STATE_COUNT] = {"1MHz", "12MHz", "Boost", "I2C", "Flash"};
+    char line1[17];
+    char line2[17];
+    char dur[12];
+    uint32_t session_ms = energy_session_ms();
+    if (state < 0)
+    {
+        uint32_t uah = energy_session_uah();
+        uint32_t avg_ua = session_ms ? (uint32_t)((uint64_t)uah * 3600000u / session_ms) : 0;
+        format_duration(dur, sizeof(dur), session_ms);
+        snprintf(line1, sizeof(line1), "Sess %s", dur);
+        snprintf(line2, sizeof(line2), "%lu.%03lumAh %lumA", (unsigned long)(uah / 1000u), (unsigned long)(uah % 1000u),
+                 (unsigned long)((avg_ua + 500u) / 1000u));
+    }
+    else
+    {
+        uint32_t ms = energy_residency_ms((energy_state_t)state);
+        uint32_t pct = session_ms ? (uint32_t)((uint64_t)ms * 100u / session_ms) : 0;
+        format_duration(dur, sizeof(dur), ms);
+        snprintf(line1, sizeof(line1), "%-6s%s", state_labels[state], dur);
+        snprintf(line2, sizeof(line2), "%3lu%% %luuAh", (unsigned long)pct,
+                 (unsigned long)energy_state_uah((energy_state_t)state));
+    }
+    for (int i = (int)strlen(line1); i < 16; ++i)
+        line1[i] = ' ';
+    for (int i = (int)strlen(line2); i < 16; ++i)
+        line2[i] = ' ';
+    lcd_set_cursor(0, 0);
+    lcd_write(line1, 16);
+    lcd_set_cursor(1, 0);
+    lcd_write(line2, 16);
+}
+
+// 状態別の滞在時間と消費電力量の見積り（起動からの累計）
+// +/ROLL: 次、-/ROLLUP: 前、ENTER/DEL/OFF: 戻る
+static void action_diag_energy(void)
+{
+    int state = -1;
+    key_set_shift_state(false);
+    render_energy_screen(state);
+    while (1)
+    {
+        key_event_t ev = key_poll();
+        if (ev.type != KEY_EVENT_DOWN && ev.type != KEY_EVENT_REPEAT)
+        {
+            sleep_ms(10);
+            continue;
+        }
+        if (ev.code == K_ADD || ev.code == K_ROLL)
+        {
+            if (state < ENERGY_STATE_COUNT - 1)
+                state++;
+        }
+        else if (ev.code == K_SUB || ev.code == K_ROLLUP)
+        {
+            if (state >= 0)
+                state--;
+        }
+        else if (ev.code == K_ENTER || key_is_cancel_event(ev))
+        {
+            break;
+        }
+        render_energy_screen(state);
+    }
+    key_set_shift_state(false);
+    g_menu.redraw_needed = true;
+}
+
+// トレースをシリアルへ出力（stdio 有効ビルド用）
+static void action_diag_trace_dump(void)
+{
+    trace_dump();
+    lcd_set_cursor(0, 0);
+    lcd_write_str("Trace sent      ");
+    lcd_set_cursor(1, 0);
+    lcd_write_str("                ");
+    sleep_ms(500);
+    g_menu.redraw_needed = true;
+}
+
 static void action_exit_menu(void)
 {
     menu_close();
 }
 
+// メニューから演算を実行して結果を通常画面で見せる（取消し時の扱いはキー操作と同じ）
+static void run_menu_op(compute_op_t op, const char *name)
+{
+    compute_run_op(op, name);
+    menu_close();
+}
+static void action_stat_add(void) { run_menu_op(rpn_stat_add, "stat_add"); }
+static void action_stat_sub(void) { run_menu_op(rpn_stat_sub, "stat_sub"); }
+static void action_stat_mean(void) { run_menu_op(rpn_stat_mean, "stat_mean"); }
+static void action_stat_sdev(void) { run_menu_op(rpn_stat_sdev, "stat_sdev"); }
+static void action_stat_pdev(void) { run_menu_op(rpn_stat_pdev, "stat_pdev"); }
+static void action_stat_linreg(void) { run_menu_op(rpn_stat_linreg, "stat_linreg"); }
+static void action_stat_estimate(void) { run_menu_op(rpn_stat_estimate, "stat_estimate"); }
+static void action_stat_corr(void) { run_menu_op(rpn_stat_corr, "stat_corr"); }
+static void recall_stat(rpn_stat_sum_t which)
+{
+    rpn_stat_recall(which);
+    menu_close();
+}
+static void action_stat_n(void) { recall_stat(RPN_STAT_N); }
+static void action_stat_sum_x(void) { recall_stat(RPN_STAT_SUM_X); }
+static void action_stat_sum_y(void) { recall_stat(RPN_STAT_SUM_Y); }
+static void action_stat_sum_x2(void) { recall_stat(RPN_STAT_SUM_X2); }
+static void action_stat_sum_y2(void) { recall_stat(RPN_STAT_SUM_Y2); }
+static void action_stat_sum_xy(void) { recall_stat(RPN_STAT_SUM_XY); }
+static void action_stat_clear(void)
+{
+    rpn_reset_stats();
+    menu_close();
+}
+
+// SOLVE: マクロ P1..P3 を f(x) として Y,X を初期推定値に根を求める
+static void solve_with(int slot)
+{
+    key_set_shift_state(false);
+    lcd_write_line(0, "");
+    lcd_write_line(1, "SOLVE");
+    solver_status_t st = solver_solve(slot);
+    const char *msg = NULL;
+    switch (st)
+    {
+    case SOLVER_NO_ROOT:
+        msg = "No root found";
+        break;
+    case SOLVER_TIMEOUT:
+        msg = "Time limit";
+        break;
+    case SOLVER_BAD_MACRO:
+        msg = "Macro not usable";
+        break;
+    case SOLVER_CANCELED:
+        msg = "    Canceled    ";
+        break;
+    default:
+        break;
+    }
+    if (msg)
+    {
+        lcd_write_line(0, "");
+        lcd_write_line(1, msg);
+        sleep_ms(1000);
+    }
+    menu_close();
+}
+static void action_solve_p1(void) { solve_with(0); }
+static void action_solve_p2(void) { solve_with(1); }
+static void action_solve_p3(void) { solve_with(2); }
+
+// 積分: マクロ P1..P3 を被積分関数として Y（下限）から X（上限）まで
+static void integrate_with(int slot)
+{
+    key_set_shift_state(false);
+    lcd_write_line(0, "");
+    lcd_write_line(1, "INTEGRATE");
+    integrate_status_t st = integrate_run(slot);
+    char line[17];
+    const char *msg = NULL;
+    switch (st)
+    {
+    case INTEGRATE_OK:
+        snprintf(line, sizeof(line), "Evals %lu", (unsigned long)integrate_last_evals());
+        msg = line;
+        break;
+    case INTEGRATE_NOT_CONVERGED:
+        msg = "Not converged";
+        break;
+    case INTEGRATE_BAD_MACRO:
+        msg = "Macro not usable";
+        break;
+    case INTEGRATE_CANCELED:
+        msg = "    Canceled    ";
+        break;
+    default:
+        break;
+    }
+    if (msg)
+    {
+        lcd_write_line(0, "");
+        lcd_write_line(1, msg);
+        sleep_ms(1000);
+    }
+    menu_close();
+}
+static void action_integrate_p1(void) { integrate_with(0); }
+static void action_integrate_p2(void) { integrate_with(1); }
+static void action_integrate_p3(void) { integrate_with(2); }
+
+// データリスト（リストは取消しで戻せないので、取消しキーが押されても結果を残す）
+static void run_list_op(compute_op_t op, const char *name)
+{
+    compute_run_op_committed(op, name);
+    menu_close();
+}
+static void action_list_add(void) { run_list_op(rpn_list_add, "list_add"); }
+static void action_list_median(void) { run_list_op(rpn_list_median, "list_median"); }
+static void action_list_q1(void) { run_list_op(rpn_list_q1, "list_q1"); }
+static void action_list_q3(void) { run_list_op(rpn_list_q3, "list_q3"); }
+static void action_list_percentile(void) { run_list_op(rpn_list_percentile, "list_percentile"); }
+static void action_list_sort(void)
+{
+    compute_run_op_committed(rpn_list_sort, "list_sort");
+    lcd_set_cursor(0, 0);
+    lcd_write_str("List sorted     ");
+    lcd_set_cursor(1, 0);
+    lcd_write_str("                ");
+    sleep_ms(500);
+    g_menu.redraw_needed = true;
+}
+static void action_list_clear(void)
+{
+    datalist_clear();
+    menu_close();
+}
+
+static void render_list_screen(int index)
+{
+    char line1[17];
+    char line2[17];
+    int n = datalist_count();
+    if (n == 0)
+    {
+        snprintf(line1, sizeof(line1), "%-16s", "List empty");
+        snprintf(line2, sizeof(line2), "%-16s", "");
+    }
+    else
+    {
+        BID_UINT128 v;
+        datalist_get(index, &v);
+        snprintf(line1, sizeof(line1), "#%3d/%-3d        ", index + 1, n);
+        char vbuf[17];
+        bid128_to_str(v, vbuf, sizeof(vbuf));
+        snprintf(line2, sizeof(line2), "%-16s", vbuf);
+    }
+    lcd_set_cursor(0, 0);
+    lcd_write(line1, 16);
+    lcd_set_cursor(1, 0);
+    lcd_write(line2, 16);
+}
+
+// 一覧/編集: +/- で移動、SWAP で X に置換、CLR で削除、ENTER で X へ呼出し
+static void action_list_edit(void)
+{
+    int index = 0;
+    key_set_shift_state(false);
+    render_list_screen(index);
+    while (1)
+    {
+        key_event_t ev = key_poll();
+        if (ev.type != KEY_EVENT_DOWN && ev.type != KEY_EVENT_REPEAT)
+        {
+            sleep_ms(10);
+            continue;
+        }
+        int n = datalist_count();
+        if (ev.code == K_ADD || ev.code == K_ROLL)
+        {
+            if (index < n - 1)
+                index++;
+        }
+        else if (ev.code == K_SUB || ev.code == K_ROLLUP)
+        {
+            if (index > 0)
+                index--;
+        }
+        else if (ev.code == K_SWAP)
+        {
+            datalist_set(index, rpn_stack_x());
+        }
+        else if (ev.code == K_CLR)
+        {
+            datalist_remove(index);
+            if (index >= datalist_count() && index > 0)
+                index--;
+            key_set_shift_state(false);
+        }
+        else if (ev.code == K_ENTER)
+        {
+            BID_UINT128 v;
+            if (datalist_get(index, &v))
+            {
+                rpn_input_value(v);
+                key_set_shift_state(false);
+                menu_close();
+                return;
+            }
+            break;
+        }
+        else if (key_is_cancel_event(ev))
+        {
+            break;
+        }
+        render_list_screen(index);
+    }
+    key_set_shift_state(false);
+    g_menu.redraw_needed = true;
+}
+
+// 行列: 演算は core1 で行い、C に結果が入るものはそのままエディタで見せる
+static void show_matrix_error(const char *msg)
+{
+    lcd_write_line(0, "");
+    lcd_write_line(1, msg);
+    sleep_ms(1000);
+}
+
+static void run_matrix_op(compute_op_t op, const char *name, bool show_c)
+{
+    key_set_shift_state(false);
+    // 行列は取消しで戻せないので最後まで実行した結果を残す
+    compute_run_op_committed(op, name);
+    switch (matrix_last_status())
+    {
+    case MATRIX_BAD_DIM:
+        show_matrix_error("Size mismatch");
+        g_menu.redraw_needed = true;
+        return;
+    case MATRIX_SINGULAR:
+        show_matrix_error("Singular matrix");
+        g_menu.redraw_needed = true;
+        return;
+    default:
+        break;
+    }
+    menu_close();
+    if (show_c)
+        matrix_ui_open(MATRIX_C);
+}
+static void action_matrix_det(void) { run_matrix_op(matrix_op_det, "mat_det", false); }
+static void action_matrix_inverse(void) { run_matrix_op(matrix_op_inverse, "mat_inv", true); }
+static void action_matrix_transpose(void) { run_matrix_op(matrix_op_transpose, "mat_trn", true); }
+static void action_matrix_multiply(void) { run_matrix_op(matrix_op_multiply, "mat_mul", true); }
+static void action_matrix_solve(void) { run_matrix_op(matrix_op_solve, "mat_solve", true); }
+
+static void edit_matrix(matrix_id_t m)
+{
+    menu_close();
+    matrix_ui_open(m);
+}
+static void action_matrix_edit_a(void) { edit_matrix(MATRIX_A); }
+static void action_matrix_edit_b(void) { edit_matrix(MATRIX_B); }
+static void action_matrix_edit_c(void) { edit_matrix(MATRIX_C); }
+
+// 大きさ: Y=行数, X=列数（1..6 の整数）
+static bool stack_small_int(BID_UINT128 v, int *out)
+{
+    int n = 0;
+    __bid128_to_int32_int(&n, &v);
+    *out = n;
+    return d_eq(d_from_int(n), v);
+}
+static void size_matrix(matrix_id_t m)
+{
+    if (rpn_is_input_active())
+        rpn_commit_input_without_push();
+    int rows, cols;
+    if (!stack_small_int(rpn_stack_y(), &rows) || !stack_small_int(rpn_stack_x(), &cols) ||
+        !matrix_set_dims(m, rows, cols))
+    {
+        show_matrix_error("Size 1..6 in Y,X");
+        g_menu.redraw_needed = true;
+        return;
+    }
+    edit_matrix(m);
+}
+static void action_matrix_size_a(void) { size_matrix(MATRIX_A); }
+static void action_matrix_size_b(void) { size_matrix(MATRIX_B); }
+static void action_matrix_c_to_a(void)
+{
+    matrix_copy(MATRIX_A, MATRIX_C);
+    edit_matrix(MATRIX_A);
+}
+static void action_matrix_clear(void)
+{
+    matrix_clear_all();
+    menu_close();
+}
+
+// 複合演算（1回丸め）
+static void action_fn_fma(void) { run_menu_op(rpn_fma, "fma"); }
+static void action_fn_to_polar(void) { run_menu_op(rpn_to_polar, "to_polar"); }
+static void action_fn_to_rect(void) { run_menu_op(rpn_to_rect, "to_rect"); }
+static void action_fn_ln1p(void) { run_menu_op(rpn_ln1p, "ln1p"); }
+static void action_fn_expm1(void) { run_menu_op(rpn_expm1, "expm1"); }
+static void action_vec_norm2(void) { run_menu_op(rpn_vec_norm2, "vec_norm2"); }
+static void action_vec_norm3(void) { run_menu_op(rpn_vec_norm3, "vec_norm3"); }
+static void action_vec_dot2(void) { run_menu_op(rpn_vec_dot2, "vec_dot2"); }
+static void action_vec_cross2(void) { run_menu_op(rpn_vec_cross2, "vec_cross2"); }
+static void action_vec_store_u(void) { run_menu_op(rpn_vec_store_u, "vec_store_u"); }
+static void action_vec_recall_u(void) { run_menu_op(rpn_vec_recall_u, "vec_recall_u"); }
+static void action_vec_dot3(void) { run_menu_op(rpn_vec_dot3, "vec_dot3"); }
+static void action_vec_cross3(void) { run_menu_op(rpn_vec_cross3, "vec_cross3"); }
+
+// プログラマモード: スタックを整数に変換して開始（MODE キーで終了）
+static void action_programmer(void)
+{
+    menu_close();
+    prog_mode_enter();
+}
+
 // 列挙値ラベル
 static const char *const angle_labels[] = {"DEG", "RAD", "GRAD"};
-static const char *const disp_labels[] = {"NORM", "SCI", "ENG"};
+static const char *const disp_labels[] = {"NORM", "SCI", "ENG", "FRAC"};
 static const char *const digits_labels[] = {"ALL", "0", "1", "2", "3", "4", "5", "6", "7", "8", "9"};
 static const char *const hyper_labels[] = {"OFF", "ON"};
 static int get_auto_off_mode(void) { return (int)settings_get_auto_off_mode(); }
@@ -350,9 +964,12 @@ static void set_lcd_contrast(int v)
 // サブメニュー定義
 static const menu_item_t settings_items[] = {
     {"Ang. Unit", MI_ENUM, NULL, 0, get_angle_mode, set_angle_mode, angle_labels, 3, 0, 0, NULL, "Angle unit"},
-    {"Display", MI_ENUM, NULL, 0, get_disp_mode, set_disp_mode, disp_labels, 3, 0, 0, NULL, "Display format"},
+    {"Display", MI_ENUM, NULL, 0, get_disp_mode, set_disp_mode, disp_labels, 4, 0, 0, NULL, "Display format"},
     {"Digits", MI_ENUM, NULL, 0, get_digits_enum, set_digits_enum, digits_labels, 11, 0, 0, NULL, "Fraction digits"},
+    {"Precision", MI_ENUM, NULL, 0, get_precision_enum, set_precision_enum, precision_labels, 2, 0, 0, NULL, "Working digits"},
     {"Hyp. Mode", MI_ENUM, NULL, 0, get_hyper_mode, set_hyper_mode, hyper_labels, 2, 0, 0, NULL, "Hyperbolic trig mode"},
+    {"Complex", MI_ENUM, NULL, 0, get_complex_enum, set_complex_enum, hyper_labels, 2, 0, 0, NULL, "Complex results"},
+    {"Interval", MI_ENUM, NULL, 0, get_interval_enum, set_interval_enum, hyper_labels, 2, 0, 0, NULL, "Bounded [lo,hi]"},
 };
 
 // Reset submenu actions
@@ -379,17 +996,112 @@ static const menu_item_t reset_items[] = {
     {"FactoryReset", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_reset_calculator, "Factory reset"},
 };
 
+static const menu_item_t diag_items[] = {
+    {"Profile", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_diag_profile, "Cycles per op"},
+    {"Latency", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_diag_latency, "Key to LCD latency"},
+    {"Energy", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_diag_energy, "Time in state, mAh"},
+    {"Trace Dump", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_diag_trace_dump, "Print event trace"},
+};
+
+static const menu_item_t stat_sum_items[] = {
+    {"n", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_n, "Data count"},
+    {"Sum x", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_sum_x, "Sum of x"},
+    {"Sum y", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_sum_y, "Sum of y"},
+    {"Sum x^2", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_sum_x2, "Sum of x squared"},
+    {"Sum y^2", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_sum_y2, "Sum of y squared"},
+    {"Sum xy", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_sum_xy, "Sum of x*y"},
+};
+
+static const menu_item_t list_items[] = {
+    {"Add X", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_list_add, "Append X to list"},
+    {"Median", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_list_median, "Median of list"},
+    {"Quartile 1", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_list_q1, "Lower quartile"},
+    {"Quartile 3", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_list_q3, "Upper quartile"},
+    {"Percentile", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_list_percentile, "X% point of list"},
+    {"Sort", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_list_sort, "Sort ascending"},
+    {"Edit", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_list_edit, "View/edit samples"},
+    {"Clear", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_list_clear, "Clear list"},
+};
+
+static const menu_item_t stat_items[] = {
+    {"Sigma+", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_add, "Add X,Y (S+ key)"},
+    {"Sigma-", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_sub, "Remove X,Y (S- key)"},
+    {"Mean", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_mean, "X:mean x Y:mean y"},
+    {"Std Dev s", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_sdev, "Sample std dev"},
+    {"Std Dev pop", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_pdev, "Population std dev"},
+    {"Lin Reg", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_linreg, "X:intercept Y:slope"},
+    {"Estimate y", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_estimate, "y for x in X"},
+    {"Corr r", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_corr, "Correlation coef"},
+    {"Data List", MI_SUBMENU, list_items, sizeof(list_items) / sizeof(list_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Median/quartiles"},
+    {"Sums", MI_SUBMENU, stat_sum_items, sizeof(stat_sum_items) / sizeof(stat_sum_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Recall n and sums"},
+    {"Clear", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_stat_clear, "Clear statistics"},
+};
+
+static const menu_item_t solve_items[] = {
+    {"f(x) = P1", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_solve_p1, "Guesses in Y,X"},
+    {"f(x) = P2", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_solve_p2, "Guesses in Y,X"},
+    {"f(x) = P3", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_solve_p3, "Guesses in Y,X"},
+};
+
+static const menu_item_t integrate_items[] = {
+    {"f(x) = P1", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_integrate_p1, "Limits in Y,X"},
+    {"f(x) = P2", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_integrate_p2, "Limits in Y,X"},
+    {"f(x) = P3", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_integrate_p3, "Limits in Y,X"},
+};
+
+static const menu_item_t matrix_items[] = {
+    {"Edit A", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_edit_a, "View/edit A"},
+    {"Edit B", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_edit_b, "View/edit B"},
+    {"Edit C", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_edit_c, "View result C"},
+    {"Size A", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_size_a, "Rows Y, Cols X"},
+    {"Size B", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_size_b, "Rows Y, Cols X"},
+    {"Det A", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_det, "Determinant to X"},
+    {"Inverse A", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_inverse, "C = A^-1"},
+    {"Transpose A", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_transpose, "C = A^T"},
+    {"A x B", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_multiply, "C = A*B"},
+    {"Solve AC=B", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_solve, "C = A^-1*B"},
+    {"C to A", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_c_to_a, "Copy result to A"},
+    {"Clear", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_matrix_clear, "Clear matrices"},
+};
+
+static const menu_item_t vector_items[] = {
+    {"Norm 2D", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_vec_norm2, "|(Y,X)|"},
+    {"Norm 3D", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_vec_norm3, "|(Z,Y,X)|"},
+    {"Dot 2D", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_vec_dot2, "(T,Z).(Y,X)"},
+    {"Cross 2D", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_vec_cross2, "T*X-Z*Y"},
+    {"Store u", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_vec_store_u, "Z,Y,X to u"},
+    {"Recall u", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_vec_recall_u, "u to Z,Y,X"},
+    {"Dot 3D", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_vec_dot3, "u.(Z,Y,X)"},
+    {"Cross 3D", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_vec_cross3, "u x (Z,Y,X)"},
+};
+
+static const menu_item_t function_items[] = {
+    {"FMA", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_fn_fma, "Z+Y*X, one rounding"},
+    {"R->P", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_fn_to_polar, "X:r Y:angle"},
+    {"P->R", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_fn_to_rect, "X:x Y:y"},
+    {"ln(1+x)", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_fn_ln1p, "Accurate near x=0"},
+    {"e^x-1", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_fn_expm1, "Accurate near x=0"},
+    {"Vector", MI_SUBMENU, vector_items, sizeof(vector_items) / sizeof(vector_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Dot, cross, norm"},
+};
+
 static const menu_item_t system_items[] = {
     {"Auto Off", MI_ENUM, NULL, 0, get_auto_off_mode, set_auto_off_mode, auto_off_labels, 4, 0, 0, NULL, "Auto power-off"},
     {"Resume", MI_ENUM, NULL, 0, get_resume_enum, set_resume_enum, hyper_labels, 2, 0, 0, NULL, "Resume on boot"},
     {"Last Key", MI_ENUM, NULL, 0, get_last_key_mode_enum, set_last_key_mode_enum, (const char *const[]){"Last X", "Undo"}, 2, 0, 0, NULL, "Last key behavior"},
     {"LCD Contrast", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_adjust_contrast, "Adjust LCD contrast"},
     {"Reset", MI_SUBMENU, reset_items, sizeof(reset_items) / sizeof(reset_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Reset submenu"},
+    {"Diagnostics", MI_SUBMENU, diag_items, sizeof(diag_items) / sizeof(diag_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Diagnostics"},
     {"About", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_about, "About this calculator"},
 };
 
 static const menu_item_t main_items[] = {
     {"Settings", MI_SUBMENU, settings_items, sizeof(settings_items) / sizeof(settings_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Calculator settings"},
+    {"Statistics", MI_SUBMENU, stat_items, sizeof(stat_items) / sizeof(stat_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Sigma+ statistics"},
+    {"Functions", MI_SUBMENU, function_items, sizeof(function_items) / sizeof(function_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "FMA, polar, ln1p"},
+    {"Solve", MI_SUBMENU, solve_items, sizeof(solve_items) / sizeof(solve_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Root of macro f(x)"},
+    {"Integrate", MI_SUBMENU, integrate_items, sizeof(integrate_items) / sizeof(integrate_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Integral of macro f(x)"},
+    {"Matrix", MI_SUBMENU, matrix_items, sizeof(matrix_items) / sizeof(matrix_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "Matrices A, B, C"},
+    {"Programmer", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_programmer, "HEX/BIN integers"},
     {"System", MI_SUBMENU, system_items, sizeof(system_items) / sizeof(system_items[0]), NULL, NULL, NULL, 0, 0, 0, NULL, "System functions"},
     {"Exit", MI_ACTION, NULL, 0, NULL, NULL, NULL, 0, 0, 0, action_exit_menu, "Exit menu"},
 };
@@ -673,6 +1385,14 @@ bool menu_handle_key(key_event_t ev)
 
     const menu_item_t *menu = frame->menu;
 
+    // シフト中の +/- は Σ+/Σ−、ENTER は COMPLEX になるが、メニュー内では元のキーとして扱う
+    if (ev.code == K_SIGMA_PLUS)
+        ev.code = K_ADD;
+    else if (ev.code == K_SIGMA_MINUS)
+        ev.code = K_SUB;
+    else if (ev.code == K_COMPLEX)
+        ev.code = K_ENTER;
+
     // 戻るキー
     if (ev.code == K_CLR || ev.code == K_DEL || (ev.code == K_OFF && ev.type == KEY_EVENT_DOWN))
     {
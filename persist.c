@@ -0,0 +1,152 @@
+// フラッシュ保存の取りまとめ（設定/マクロ/レジューム/データリスト/トレースを1回の書込み区間で保存）
+#include "persist.h"
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "settings.h"
+#include "macro.h"
+#include "resume.h"
+#include "datalist.h"
+#include "matrix.h"
+#include "profile.h"
+#include "trace.h"
+#include "energy.h"
+
+// core1 停止待ちのタイムアウト
+#define PERSIST_LOCKOUT_TIMEOUT_MS 1000u
+
+static uint32_t g_last_build_us = 0;
+static uint32_t g_last_flash_us = 0;
+
+// フラッシュ操作の引数（flash_safe_execute 経由で実行）
+typedef struct
+{
+    const persist_block_t *const *order;
+    int n;
+} write_job_t;
+
+static void do_write_blocks(void *param)
+{
+    const write_job_t *job = (const write_job_t *)param;
+    const persist_block_t *const *order = job->order;
+    int n = job->n;
+    // 隣接セクタは1回の消去にまとめる
+    int i = 0;
+    while (i < n)
+    {
+        if (order[i]->append)
+        {
+            ++i;
+            continue;
+        }
+        uint32_t start = order[i]->flash_offset;
+        uint32_t end = start + FLASH_SECTOR_SIZE;
+        int j = i + 1;
+        while (j < n && !order[j]->append && order[j]->flash_offset == end)
+        {
+            end += FLASH_SECTOR_SIZE;
+            ++j;
+        }
+        flash_range_erase(start, end - start);
+        i = j;
+    }
+    // 書込み（ROM側で完了までBUSYをポーリングする）
+    for (i = 0; i < n; ++i)
+        flash_range_program(order[i]->flash_offset, order[i]->data, order[i]->len);
+}
+
+static void do_erase_sector(void *param)
+{
+    flash_range_erase(*(const uint32_t *)param, FLASH_SECTOR_SIZE);
+}
+
+bool persist_write_blocks(const persist_block_t *blocks, int count)
+{
+    if (!blocks || count <= 0)
+        return false;
+
+    // オフセット昇順に並べる（件数は高々数件なので挿入ソート）
+    const persist_block_t *order[PERSIST_MAX_BLOCKS];
+    int n = 0;
+    for (int i = 0; i < count && n < (int)(sizeof(order) / sizeof(order[0])); ++i)
+    {
+        const persist_block_t *b = &blocks[i];
+        if (!b->data || b->len == 0 || b->len > FLASH_SECTOR_SIZE)
+            continue;
+        int j = n;
+        while (j > 0 && order[j - 1]->flash_offset > b->flash_offset)
+        {
+            order[j] = order[j - 1];
+            --j;
+        }
+        order[j] = b;
+        ++n;
+    }
+    if (n == 0)
+        return false;
+
+    // 割込み禁止に加え、演算コア(core1)がXIPから命令を読まないよう停止させてから書込む
+    uint64_t t0 = time_us_64();
+    uint32_t c0 = profile_cycles();
+    write_job_t job = {order, n};
+    energy_activity_begin(ENERGY_FLASH);
+    bool ok = (flash_safe_execute(do_write_blocks, &job, PERSIST_LOCKOUT_TIMEOUT_MS) == PICO_OK);
+    energy_activity_end(ENERGY_FLASH);
+    profile_stop("flash", c0);
+    g_last_flash_us = (uint32_t)(time_us_64() - t0);
+    uint32_t ms = g_last_flash_us / 1000u;
+    trace_log(TRACE_FLASH, (uint8_t)n, (uint16_t)(ms > 0xFFFFu ? 0xFFFFu : ms));
+    return ok;
+}
+
+bool persist_erase_sector(uint32_t flash_offset)
+{
+    energy_activity_begin(ENERGY_FLASH);
+    bool ok = (flash_safe_execute(do_erase_sector, &flash_offset, PERSIST_LOCKOUT_TIMEOUT_MS) == PICO_OK);
+    energy_activity_end(ENERGY_FLASH);
+    return ok;
+}
+
+void persist_save_all(void)
+{
+    uint64_t t0 = time_us_64();
+    persist_block_t blocks[PERSIST_MAX_BLOCKS];
+    int n = 0;
+    // 先にRAM上ですべてのブロブを組み立てる
+    bool save_settings = settings_prepare_save(&blocks[n]);
+    if (save_settings)
+        n++;
+    bool save_macro = macro_prepare_save(&blocks[n]);
+    if (save_macro)
+        n++;
+    bool save_resume = resume_prepare_save(&blocks[n]);
+    if (save_resume)
+        n++;
+    bool save_list = datalist_prepare_save(&blocks[n]);
+    if (save_list)
+        n++;
+    bool save_matrix = matrix_prepare_save(&blocks[n]);
+    if (save_matrix)
+        n++;
+    // トレースは保存有効時のみ（保存済みフラグは持たない）
+    if (trace_prepare_save(&blocks[n]))
+        n++;
+    g_last_build_us = (uint32_t)(time_us_64() - t0);
+
+    if (n == 0 || !persist_write_blocks(blocks, n))
+        return;
+
+    if (save_settings)
+        settings_mark_saved();
+    if (save_macro)
+        macro_mark_saved();
+    if (save_resume)
+        resume_mark_saved();
+    if (save_list)
+        datalist_mark_saved();
+    if (save_matrix)
+        matrix_mark_saved();
+}
+
+uint32_t persist_last_build_us(void) { return g_last_build_us; }
+uint32_t persist_last_flash_us(void) { return g_last_flash_us; }
@@ -0,0 +1,43 @@
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // フラッシュ書込み1件分（各モジュールがRAM上に組み立てる）
+    typedef struct
+    {
+        uint32_t flash_offset; // 書込み先（通常はセクタ境界、追記時はページ境界）
+        const uint8_t *data;   // FLASH_PAGE_SIZE 単位でパディング済みのデータ
+        size_t len;            // data の長さ（FLASH_PAGE_SIZE の倍数、1セクタ以下）
+        bool append;           // true: 消去せずに追記（書込み先は消去済みであること）
+    } persist_block_t;
+
+    // 一括保存で扱う最大ブロック数
+#define PERSIST_MAX_BLOCKS 6
+
+    // 複数ブロックを1回の割込み禁止区間で消去→書込みする。
+    // 隣接セクタはまとめて消去する。core1 が動作中でも安全に書込む（停止させる）
+    // 戻り値: 書込みを実行できたら true
+    bool persist_write_blocks(const persist_block_t *blocks, int count);
+    // 1セクタを消去する（事前消去用）
+    bool persist_erase_sector(uint32_t flash_offset);
+
+    // 設定/マクロ/レジューム/データリスト/行列のうち保存が必要なものを一括保存する（電源OFF時）
+    void persist_save_all(void);
+
+    // 直近の一括保存の所要時間[us]（ブロブ組み立て、フラッシュ書込み）
+    uint32_t persist_last_build_us(void);
+    uint32_t persist_last_flash_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PERSIST_H
@@ -0,0 +1,117 @@
+// 処理時間プロファイラ（Cortex-M33 DWT サイクルカウンタ）
+#include "profile.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#if PICO_ON_DEVICE
+#include "hardware/clocks.h"
+#include "hardware/structs/m33.h"
+#endif
+
+static profile_entry_t g_entries[PROFILE_MAX_ENTRIES];
+static int g_count = 0;
+
+void profile_init(void)
+{
+#if PICO_ON_DEVICE
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    m33_hw->dwt_cyccnt = 0;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+#endif
+}
+
+uint32_t profile_cycles(void)
+{
+#if PICO_ON_DEVICE
+    return m33_hw->dwt_cyccnt;
+#else
+    return (uint32_t)time_us_64();
+#endif
+}
+
+static bool same_str(const char *a, const char *b)
+{
+    if (a == b)
+        return true;
+    return a && b && strcmp(a, b) == 0;
+}
+
+// 項目を探す（なければ追加）。名前は通常同じリテラルなのでポインタ比較を先に行う
+static profile_entry_t *find_entry(const char *name, const char *tag)
+{
+    for (int i = 0; i < g_count; ++i)
+    {
+        if (same_str(g_entries[i].name, name) && same_str(g_entries[i].tag, tag))
+            return &g_entries[i];
+    }
+    if (g_count >= PROFILE_MAX_ENTRIES)
+        return NULL;
+    profile_entry_t *e = &g_entries[g_count++];
+    memset(e, 0, sizeof(*e));
+    e->name = name;
+    e->tag = tag;
+    e->min_cycles = UINT32_MAX;
+    return e;
+}
+
+void profile_record(const char *name, uint32_t cycles)
+{
+    profile_record_tagged(name, NULL, cycles);
+}
+
+void profile_record_tagged(const char *name, const char *tag, uint32_t cycles)
+{
+    if (!name)
+        return;
+    profile_entry_t *e = find_entry(name, tag);
+    if (!e)
+        return;
+    e->count++;
+    e->total_cycles += cycles;
+    if (cycles < e->min_cycles)
+        e->min_cycles = cycles;
+    if (cycles > e->max_cycles)
+        e->max_cycles = cycles;
+#if PICO_ON_DEVICE
+    // クロックは 1MHz/12MHz で切り替わるので記録時点の周波数で換算する
+    uint32_t hz = clock_get_hz(clk_sys);
+    e->last_us = hz ? (uint32_t)((uint64_t)cycles * 1000000u / hz) : 0;
+#else
+    e->last_us = cycles;
+#endif
+}
+
+void profile_stop(const char *name, uint32_t start_cycles)
+{
+    profile_record(name, profile_cycles() - start_cycles);
+}
+
+int profile_count(void)
+{
+    return g_count;
+}
+
+const profile_entry_t *profile_get(int index)
+{
+    if (index < 0 || index >= g_count)
+        return NULL;
+    return &g_entries[index];
+}
+
+void profile_reset(void)
+{
+    g_count = 0;
+}
+
+void profile_dump(void)
+{
+    printf("name,tag,count,min,max,mean,last_us\n");
+    for (int i = 0; i < g_count; ++i)
+    {
+        const profile_entry_t *e = &g_entries[i];
+        uint32_t mean = e->count ? (uint32_t)(e->total_cycles / e->count) : 0;
+        printf("%s,%s,%lu,%lu,%lu,%lu,%lu\n", e->name, e->tag ? e->tag : "", (unsigned long)e->count,
+               (unsigned long)(e->count ? e->min_cycles : 0), (unsigned long)e->max_cycles,
+               (unsigned long)mean, (unsigned long)e->last_us);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 計測できる項目数の上限（演算ごと＋表示/LCD/フラッシュ）
+#define PROFILE_MAX_ENTRIES 48
+
+    // 1項目分の集計
+    typedef struct
+    {
+        const char *name;    // 項目名（文字列リテラルを渡すこと）
+        const char *tag;     // 計測条件（作業精度など。NULL=なし、文字列リテラル）
+        uint32_t count;      // 計測回数
+        uint32_t min_cycles; // 最小サイクル数
+        uint32_t max_cycles; // 最大サイクル数
+        uint64_t total_cycles;
+        uint32_t last_us; // 直近1回の所要時間[us]（計測時のクロックで換算）
+    } profile_entry_t;
+
+    // サイクルカウンタを有効化する（DWTはコアごとにあるので各コアで呼ぶ）
+    void profile_init(void);
+    // 現在のサイクルカウンタ（ホストビルドでは us）
+    uint32_t profile_cycles(void);
+
+    // 計測結果を記録する（core0 から呼ぶこと）
+    void profile_record(const char *name, uint32_t cycles);
+    // 同じ項目を条件ごとに分けて記録する（name と tag の組で1項目）
+    void profile_record_tagged(const char *name, const char *tag, uint32_t cycles);
+    // profile_cycles() で取った開始値からの差を記録する
+    void profile_stop(const char *name, uint32_t start_cycles);
+
+    // 集計の参照/クリア
+    int profile_count(void);
+    const profile_entry_t *profile_get(int index);
+    void profile_reset(void);
+
+    // 集計を1行1項目で標準出力へ出す（ホストビルド/stdio有効時）
+    void profile_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROFILE_H
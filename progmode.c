@@ -0,0 +1,582 @@
+// プログラマモード: uint64 の4段スタックで整数演算/ビット演算を行う
+// 値は常に語長でマスクした形で持ち、符号付きのときだけ最上位ビットを符号として解釈する。
+// BID128 との変換はモードの開始/終了時だけ
+#include "progmode.h"
+#include <string.h>
+#include "LCD.h"
+#include "RPN.h"
+#include "bid_ops.h"
+
+// 64ビットの2進表記 + 符号 + 終端
+#define PROG_DIGITS_MAX 66
+
+static bool g_active = false;
+static prog_base_t g_base = PROG_BASE_HEX;
+static int g_word_bits = 64;
+static bool g_signed = false;
+
+static uint64_t g_stack[4]; // X, Y, Z, T
+static uint64_t g_last_x = 0;
+static bool g_entry = false; // 数字入力中（X に桁を積み上げている）
+static uint64_t g_entry_mag = 0; // 入力中の桁の値（符号を除く）
+static bool g_entry_neg = false; // 入力中に +/- が押された
+static bool g_lift = true;   // 次の数字入力の前に push する
+static int g_scroll = 0;     // 表示窓の位置（0 = 下位桁側）
+static const char *g_error = NULL;
+
+static const uint8_t s_base_radix[PROG_BASE__COUNT] = {16, 10, 8, 2};
+static const char *const s_base_names[PROG_BASE__COUNT] = {"HEX", "DEC", "OCT", "BIN"};
+
+static inline uint64_t word_mask(void)
+{
+    return g_word_bits >= 64 ? UINT64_MAX : ((UINT64_C(1) << g_word_bits) - 1u);
+}
+
+static inline uint64_t sign_bit(void)
+{
+    return UINT64_C(1) << (g_word_bits - 1);
+}
+
+// 符号付きとして読む（語長の最上位ビットを符号拡張）
+static inline int64_t as_signed(uint64_t v)
+{
+    if (v & sign_bit())
+        return (int64_t)(v | ~word_mask());
+    return (int64_t)v;
+}
+
+// ---- BID128 との変換（モード切替時のみ） ----
+
+// 小数部を切り捨て、語長で表せる範囲に飽和させる（NaN は 0）
+static uint64_t from_bid(BID_UINT128 v)
+{
+    BID_UINT128 t;
+    __bid128_round_integral_zero(&t, &v);
+    int is_nan = 0;
+    __bid128_isNaN(&is_nan, &t);
+    if (is_nan)
+        return 0;
+    if (g_signed)
+    {
+        BID_SINT64 hi = (BID_SINT64)(word_mask() >> 1);
+        BID_SINT64 lo = -hi - 1;
+        BID_UINT128 bhi, blo;
+        __bid128_from_int64(&bhi, &hi);
+        __bid128_from_int64(&blo, &lo);
+        BID_SINT64 i;
+        if (d_gt(t, bhi))
+            i = hi;
+        else if (d_lt(t, blo))
+            i = lo;
+        else
+            __bid128_to_int64_int(&i, &t);
+        return (uint64_t)i & word_mask();
+    }
+    if (d_is_neg(t))
+        return 0;
+    BID_UINT64 hi = word_mask();
+    BID_UINT128 bhi;
+    __bid128_from_uint64(&bhi, &hi);
+    if (d_gt(t, bhi))
+        return hi;
+    BID_UINT64 u;
+    __bid128_to_uint64_int(&u, &t);
+    return u;
+}
+
+static BID_UINT128 to_bid(uint64_t v)
+{
+    BID_UINT128 r;
+    if (g_signed)
+    {
+        BID_SINT64 i = as_signed(v);
+        __bid128_from_int64(&r, &i);
+    }
+    else
+    {
+        BID_UINT64 u = v;
+        __bid128_from_uint64(&r, &u);
+    }
+    return r;
+}
+
+void prog_mode_enter(void)
+{
+    if (g_active)
+        return;
+    if (rpn_is_input_active())
+        rpn_commit_input_without_push();
+    // 変換で立つ inexact 等は通常モードの演算に持ち越さない
+    _IDEC_flags saved = _IDEC_glbflags;
+    g_stack[0] = from_bid(rpn_stack_x());
+    g_stack[1] = from_bid(rpn_stack_y());
+    g_stack[2] = from_bid(rpn_stack_z());
+    g_stack[3] = from_bid(rpn_stack_t());
+    _IDEC_glbflags = saved;
+    // 整数化で失う小数部/虚部/区間幅を Undo で戻せるよう、モード前のスタックを境界として取る
+    rpn_undo_capture_boundary();
+    g_last_x = 0;
+    g_entry = false;
+    g_lift = true;
+    g_scroll = 0;
+    g_error = NULL;
+    g_active = true;
+}
+
+void prog_mode_exit(void)
+{
+    if (!g_active)
+        return;
+    rpn_load_stack(to_bid(g_stack[0]), to_bid(g_stack[1]), to_bid(g_stack[2]), to_bid(g_stack[3]));
+    g_active = false;
+    key_set_shift_state(false);
+}
+
+bool prog_mode_is_active(void) { return g_active; }
+prog_base_t prog_mode_base(void) { return g_base; }
+int prog_mode_word_bits(void) { return g_word_bits; }
+bool prog_mode_is_signed(void) { return g_signed; }
+
+// ---- スタック ----
+
+static void push(uint64_t v)
+{
+    g_stack[3] = g_stack[2];
+    g_stack[2] = g_stack[1];
+    g_stack[1] = g_stack[0];
+    g_stack[0] = v;
+}
+
+// 2項演算の後: Y,Z,T を1段下げる（T は複製）
+static void drop(uint64_t x)
+{
+    g_stack[0] = x;
+    g_stack[1] = g_stack[2];
+    g_stack[2] = g_stack[3];
+}
+
+static void end_entry(void)
+{
+    g_entry = false;
+    g_lift = true;
+}
+
+// 入力中の X = 桁の値（+/- が押されていれば2の補数）
+static void set_entry_x(void)
+{
+    g_stack[0] = g_entry_neg ? (0u - g_entry_mag) & word_mask() : g_entry_mag;
+}
+
+static void input_digit(unsigned d)
+{
+    unsigned radix = s_base_radix[g_base];
+    if (d >= radix)
+        return;
+    if (!g_entry)
+    {
+        if (g_lift)
+            push(g_stack[0]);
+        g_entry_mag = 0;
+        g_entry_neg = false;
+        g_entry = true;
+    }
+    // 語長を超える桁は受け付けない
+    if (g_entry_mag > (word_mask() - d) / radix)
+        return;
+    g_entry_mag = g_entry_mag * radix + d;
+    set_entry_x();
+}
+
+// ---- 演算（語長で折り返す。false: 実行できない） ----
+
+typedef bool (*prog_binary_fn)(uint64_t y, uint64_t x, uint64_t *out);
+typedef uint64_t (*prog_unary_fn)(uint64_t x);
+
+static bool op_add(uint64_t y, uint64_t x, uint64_t *out)
+{
+    *out = (y + x) & word_mask();
+    return true;
+}
+static bool op_sub(uint64_t y, uint64_t x, uint64_t *out)
+{
+    *out = (y - x) & word_mask();
+    return true;
+}
+static bool op_mul(uint64_t y, uint64_t x, uint64_t *out)
+{
+    *out = (y * x) & word_mask();
+    return true;
+}
+static bool op_div(uint64_t y, uint64_t x, uint64_t *out)
+{
+    if (x == 0)
+        return false;
+    if (g_signed)
+    {
+        int64_t a = as_signed(y), b = as_signed(x);
+        // INT64_MIN / -1 は折り返して INT64_MIN
+        *out = (b == -1) ? (0u - y) & word_mask() : (uint64_t)(a / b) & word_mask();
+    }
+    else
+    {
+        *out = y / x;
+    }
+    return true;
+}
+static bool op_rmd(uint64_t y, uint64_t x, uint64_t *out)
+{
+    if (x == 0)
+        return false;
+    if (g_signed)
+    {
+        int64_t a = as_signed(y), b = as_signed(x);
+        *out = (b == -1) ? 0 : (uint64_t)(a % b) & word_mask();
+    }
+    else
+    {
+        *out = y % x;
+    }
+    return true;
+}
+static bool op_and(uint64_t y, uint64_t x, uint64_t *out)
+{
+    *out = y & x;
+    return true;
+}
+static bool op_or(uint64_t y, uint64_t x, uint64_t *out)
+{
+    *out = y | x;
+    return true;
+}
+static bool op_xor(uint64_t y, uint64_t x, uint64_t *out)
+{
+    *out = y ^ x;
+    return true;
+}
+// Y を X ビットシフト/回転（X は符号なしの回数）
+static bool op_sl_n(uint64_t y, uint64_t x, uint64_t *out)
+{
+    *out = x >= (uint64_t)g_word_bits ? 0 : (y << x) & word_mask();
+    return true;
+}
+static bool op_sr_n(uint64_t y, uint64_t x, uint64_t *out)
+{
+    *out = x >= (uint64_t)g_word_bits ? 0 : y >> x;
+    return true;
+}
+static bool op_rl_n(uint64_t y, uint64_t x, uint64_t *out)
+{
+    unsigned n = (unsigned)(x % (uint64_t)g_word_bits);
+    *out = n == 0 ? y : ((y << n) | (y >> (g_word_bits - n))) & word_mask();
+    return true;
+}
+static bool op_rr_n(uint64_t y, uint64_t x, uint64_t *out)
+{
+    unsigned n = (unsigned)(x % (uint64_t)g_word_bits);
+    *out = n == 0 ? y : ((y >> n) | (y << (g_word_bits - n))) & word_mask();
+    return true;
+}
+
+static uint64_t op_not(uint64_t x) { return ~x & word_mask(); }
+static uint64_t op_neg(uint64_t x) { return (0u - x) & word_mask(); }
+static uint64_t op_sl(uint64_t x) { return (x << 1) & word_mask(); }
+static uint64_t op_sr(uint64_t x) { return x >> 1; }
+static uint64_t op_asr(uint64_t x) { return (x >> 1) | (x & sign_bit()); }
+static uint64_t op_rl(uint64_t x) { return ((x << 1) | (x >> (g_word_bits - 1))) & word_mask(); }
+static uint64_t op_rr(uint64_t x) { return (x >> 1) | ((x & 1u) << (g_word_bits - 1)); }
+
+static void run_binary(prog_binary_fn fn, const char *err)
+{
+    end_entry();
+    uint64_t r;
+    if (!fn(g_stack[1], g_stack[0], &r))
+    {
+        g_error = err;
+        return;
+    }
+    g_last_x = g_stack[0];
+    drop(r);
+}
+
+static void run_unary(prog_unary_fn fn)
+{
+    end_entry();
+    g_last_x = g_stack[0];
+    g_stack[0] = fn(g_stack[0]);
+}
+
+// 語長を変えたら全レジスタを新しい語長でマスクする
+static void next_word_size(void)
+{
+    g_word_bits = (g_word_bits >= 64) ? 8 : g_word_bits * 2;
+    for (int i = 0; i < 4; ++i)
+        g_stack[i] &= word_mask();
+    g_last_x &= word_mask();
+    end_entry();
+}
+
+// ---- 表示 ----
+
+// v を現在の基数で文字列化して長さを返す（DEC の符号付きのみ '-' を付ける。他は2の補数のビット列）
+static int format_value(uint64_t v, char *out)
+{
+    char tmp[PROG_DIGITS_MAX];
+    unsigned radix = s_base_radix[g_base];
+    bool neg = false;
+    if (g_base == PROG_BASE_DEC && g_signed && (v & sign_bit()))
+    {
+        neg = true;
+        v = (0u - v) & word_mask();
+    }
+    int n = 0;
+    do
+    {
+        unsigned d = (unsigned)(v % radix);
+        tmp[n++] = (char)(d < 10 ? '0' + d : 'A' + (d - 10));
+        v /= radix;
+    } while (v != 0);
+    int len = 0;
+    if (neg)
+        out[len++] = '-';
+    while (n > 0)
+        out[len++] = tmp[--n];
+    out[len] = '\0';
+    return len;
+}
+
+void prog_mode_render(void)
+{
+    char line[17];
+    char digits[PROG_DIGITS_MAX];
+    int len = format_value(g_stack[0], digits);
+    // 16桁を超える値は16桁ずつの窓で表示する
+    int windows = (len + 15) / 16;
+    if (g_scroll >= windows)
+        g_scroll = windows - 1;
+
+    // 上段: 基数 語長 符号、スクロール可能な方向、シフト
+    memset(line, ' ', 16);
+    line[16] = '\0';
+    if (g_error)
+    {
+        memcpy(line, g_error, strlen(g_error) < 13 ? strlen(g_error) : 13);
+    }
+    else
+    {
+        const char *name = s_base_names[g_base];
+        memcpy(line, name, 3);
+        line[4] = (char)('0' + g_word_bits / 10);
+        line[5] = (char)('0' + g_word_bits % 10);
+        if (line[4] == '0')
+        {
+            line[4] = line[5];
+            line[5] = ' ';
+        }
+        line[g_word_bits >= 10 ? 6 : 5] = g_signed ? 's' : 'u';
+    }
+    if (g_scroll < windows - 1)
+        line[13] = '<';
+    if (g_scroll > 0)
+        line[14] = '>';
+    if (key_get_shift_state())
+        line[15] = 'S';
+    lcd_set_cursor(0, 0);
+    lcd_write(line, 16);
+
+    // 下段: X を右寄せ
+    memset(line, ' ', 16);
+    int end = len - g_scroll * 16;
+    int start = end > 16 ? end - 16 : 0;
+    memcpy(line + 16 - (end - start), digits + start, (size_t)(end - start));
+    lcd_set_cursor(1, 0);
+    lcd_write(line, 16);
+}
+
+// ---- キー処理 ----
+
+bool prog_mode_handle_key(key_event_t ev)
+{
+    if (!g_active)
+        return false;
+    if (ev.type == KEY_EVENT_UP || ev.type == KEY_EVENT_NONE)
+        return false;
+    g_error = NULL;
+    // シフトは次の1キーにだけ効く（キーコードは割り当て済み）
+    if (ev.code != K_SHIFT)
+        key_set_shift_state(false);
+    switch (ev.code)
+    {
+    case K_0:
+    case K_1:
+    case K_2:
+    case K_3:
+    case K_4:
+    case K_5:
+    case K_6:
+    case K_7:
+    case K_8:
+    case K_9:
+        input_digit((unsigned)(ev.code - K_0));
+        break;
+    case K_VA:
+    case K_VB:
+    case K_VC:
+    case K_VD:
+    case K_VE:
+    case K_VF:
+        input_digit(10u + (unsigned)(ev.code - K_VA));
+        break;
+
+    // 四則
+    case K_ADD:
+        run_binary(op_add, NULL);
+        break;
+    case K_SUB:
+        run_binary(op_sub, NULL);
+        break;
+    case K_MUL:
+        run_binary(op_mul, NULL);
+        break;
+    case K_DIV:
+        run_binary(op_div, "Divide by 0");
+        break;
+    case K_REV:
+        run_binary(op_rmd, "Divide by 0");
+        break;
+
+    // ビット演算
+    case K_SIN:
+        run_binary(op_and, NULL);
+        break;
+    case K_COS:
+        run_binary(op_or, NULL);
+        break;
+    case K_TAN:
+        run_binary(op_xor, NULL);
+        break;
+    case K_ASIN:
+        run_unary(op_not);
+        break;
+    case K_LN:
+        run_unary(op_sl);
+        break;
+    case K_LOG:
+        run_unary(op_sr);
+        break;
+    case K_EXP:
+        run_binary(op_sl_n, NULL);
+        break;
+    case K_POW10:
+        run_binary(op_sr_n, NULL);
+        break;
+    case K_POW:
+        run_unary(op_rl);
+        break;
+    case K_POW2:
+        run_unary(op_rr);
+        break;
+    case K_NTH_ROOT:
+        run_binary(op_rl_n, NULL);
+        break;
+    case K_POW3:
+        run_binary(op_rr_n, NULL);
+        break;
+    case K_SQRT:
+        run_unary(op_asr);
+        break;
+    case K_SIGN:
+        if (g_entry)
+        {
+            g_entry_neg = !g_entry_neg; // 入力中は符号だけ変えて入力を続ける
+            set_entry_x();
+        }
+        else
+            run_unary(op_neg);
+        break;
+
+    // スタック操作
+    case K_ENTER:
+        push(g_stack[0]);
+        g_entry = false;
+        g_lift = false;
+        break;
+    case K_SWAP:
+    {
+        uint64_t t = g_stack[0];
+        g_stack[0] = g_stack[1];
+        g_stack[1] = t;
+        end_entry();
+        break;
+    }
+    case K_ROLL:
+    {
+        uint64_t t = g_stack[0];
+        g_stack[0] = g_stack[1];
+        g_stack[1] = g_stack[2];
+        g_stack[2] = g_stack[3];
+        g_stack[3] = t;
+        end_entry();
+        break;
+    }
+    case K_ROLLUP:
+    {
+        uint64_t t = g_stack[3];
+        g_stack[3] = g_stack[2];
+        g_stack[2] = g_stack[1];
+        g_stack[1] = g_stack[0];
+        g_stack[0] = t;
+        end_entry();
+        break;
+    }
+    case K_LAST:
+        if (g_lift || g_entry)
+            push(g_stack[0]);
+        g_stack[0] = g_last_x;
+        end_entry();
+        break;
+    case K_DEL:
+        if (g_entry)
+        {
+            g_entry_mag /= s_base_radix[g_base]; // 最後の桁を消す
+            set_entry_x();
+        }
+        else
+        {
+            g_stack[0] = 0;
+            g_lift = false;
+        }
+        break;
+
+    // 表示/語長の切替
+    case K_C1:
+        g_base = (prog_base_t)((g_base + 1) % PROG_BASE__COUNT);
+        g_scroll = 0;
+        end_entry();
+        break;
+    case K_C2:
+        next_word_size();
+        break;
+    case K_DISP:
+        g_signed = !g_signed;
+        end_entry();
+        break;
+    case K_P2:
+        g_scroll++; // 上位桁側へ（描画時に範囲へ丸める）
+        break;
+    case K_P1:
+        if (g_scroll > 0)
+            g_scroll--;
+        break;
+    case K_SHIFT:
+        break;
+
+    case K_MODE:
+        prog_mode_exit();
+        return true;
+
+    // それ以外（EE、小数点、関数キー等）は整数モードでは無効
+    default:
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef PROGMODE_H
+#define PROGMODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "key.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        PROG_BASE_HEX = 0,
+        PROG_BASE_DEC,
+        PROG_BASE_OCT,
+        PROG_BASE_BIN,
+        PROG_BASE__COUNT
+    } prog_base_t;
+
+    // プログラマモード（整数モード）
+    // 開始時に X,Y,Z,T を整数に変換し（小数部は切捨て、語長の範囲に飽和）、
+    // 終了時に BID128 へ戻す。モード中の演算はすべて uint64 上で行い __bid128_* は使わない。
+    // 語長 8/16/32/64 ビット、符号付き/符号なし、表示は HEX/DEC/OCT/BIN。
+    //
+    // キー割り当て:
+    //   0-9, A-F (Shift+4..9)   数字入力（基数を超える桁は無視）
+    //   + - × ÷, Shift+÷        四則（語長で折り返し）、剰余 RMD
+    //   SIN / COS / TAN          AND / OR / XOR、Shift+SIN で NOT
+    //   LN / LOG                 1ビット左/右シフト（SL / SR）、Shift+LN/LOG で Y を X ビットシフト
+    //   y^x / x²                 1ビット左/右回転（RL / RR）、Shift+y^x / x³ で Y を X ビット回転
+    //   √                        算術右シフト（ASR）
+    //   +/-                      2の補数
+    //   C1 / C2                  基数の切替 / 語長の切替、Shift+C2 で符号付き/なしの切替
+    //   P2 / P1                  表示幅を超える値（BIN 等）を上位/下位側へスクロール
+    //   MODE (Shift+C1)          モード終了
+    //   ENTER, SWAP, R↓, R↑, LAST X, DEL はスタック操作として通常どおり
+
+    // モード開始/終了（開始済み/未開始なら何もしない）
+    void prog_mode_enter(void);
+    void prog_mode_exit(void);
+    bool prog_mode_is_active(void);
+
+    // キー処理。true: 再描画が必要（prog_mode_render を呼ぶ）
+    // OFF はここでは扱わない（電源OFF前に prog_mode_exit で BID128 に戻すこと）
+    bool prog_mode_handle_key(key_event_t ev);
+    // 2行表示: 上段=基数/語長/スクロール位置、下段=X
+    void prog_mode_render(void);
+
+    // 現在の基数/語長/符号の設定（モード外でも保持）
+    prog_base_t prog_mode_base(void);
+    int prog_mode_word_bits(void);
+    bool prog_mode_is_signed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROGMODE_H
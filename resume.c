@@ -1,13 +1,31 @@
 #include "resume.h"
+#include <stddef.h>
 #include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/flash.h"
-#include "hardware/sync.h"
+#include "crc32.h"
 #include "RPN.h"
 #include "settings.h"
 
-// settings: 最終, macros: 末尾から2番目、本モジュール: 末尾から3番目
+// settings: 最終, macros: 末尾から2番目、本モジュール: 末尾から3番目と4番目
+// 2セクタを交互に使うチェックポイントログ。末尾から3番目は旧形式(RSM1)の保存先でもある。
 #define RESUME_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - 3 * FLASH_SECTOR_SIZE)
+#define RESUME_LOG_SECTORS 2
+static const uint32_t s_log_offset[RESUME_LOG_SECTORS] = {
+    RESUME_FLASH_OFFSET,
+    PICO_FLASH_SIZE_BYTES - 4 * FLASH_SECTOR_SIZE,
+};
+
+// 旧形式（電源OFF時に全体を1ブロブで保存していた版）
+// rpn_state_t の拡張に影響されないよう、当時の並びを固定で持つ
+typedef struct
+{
+    BID_UINT128 x, y, z, t;
+    BID_UINT128 last_x;
+    BID_UINT128 vars[6];
+} resume_legacy_rpn_t;
+_Static_assert(offsetof(rpn_state_t, vars) + sizeof(((rpn_state_t *)0)->vars) == sizeof(resume_legacy_rpn_t),
+               "legacy registers must be a prefix of rpn_state_t");
 
 typedef struct __attribute__((packed))
 {
@@ -16,65 +34,345 @@ typedef struct __attribute__((packed))
     uint32_t crc;     // data部のCRC32
     struct __attribute__((packed))
     {
-        rpn_state_t rpn; // スタック/変数/LastX
+        resume_legacy_rpn_t rpn; // スタック/変数/LastX
     } data;
 } resume_blob_t;
 
 static const uint32_t RESUME_MAGIC = 0x52534D31u; // 'RSM1'
 static const uint32_t RESUME_VERSION = 1u;
 
-// 簡易CRC32（Poly 0xEDB88320）
-static uint32_t crc32_calc(const void *data, size_t len)
+// チェックポイントレコード: ヘッダ16B + 変更レジスタ(16B)×n
+// レジスタ番号は rpn_state_t を BID_UINT128 の配列とみなした添字
+typedef struct __attribute__((packed))
+{
+    uint32_t magic; // 'CKP1'
+    uint32_t crc;   // seq 以降（ペイロード含む）のCRC32
+    uint32_t seq;   // 通し番号（大きいほど新しい）
+    uint32_t mask;  // 含まれるレジスタのビット（bit i = レジスタ i）
+} ckpt_hdr_t;
+
+static const uint32_t CKPT_MAGIC = 0x31504B43u; // 'CKP1'
+#define CKPT_ALIGN 16u
+#define RESUME_REG_SIZE sizeof(BID_UINT128)
+#define RESUME_REG_COUNT (sizeof(rpn_state_t) / RESUME_REG_SIZE)
+#define CKPT_MAX_LEN (sizeof(ckpt_hdr_t) + RESUME_REG_COUNT * RESUME_REG_SIZE)
+#define CKPT_BUF_PAGES ((FLASH_PAGE_SIZE - CKPT_ALIGN + CKPT_MAX_LEN + FLASH_PAGE_SIZE - 1u) / FLASH_PAGE_SIZE)
+_Static_assert(RESUME_REG_COUNT <= 32, "mask is 32 bits");
+_Static_assert(sizeof(ckpt_hdr_t) == CKPT_ALIGN, "header must be one slot");
+
+// ログの状態
+static int g_active = -1;           // 追記中のセクタ（-1=なし）
+static uint32_t g_append_off = 0;   // 追記中セクタ内の次の書込み位置
+static bool g_sector_clean[RESUME_LOG_SECTORS]; // セクタ全体が消去済みか
+static bool g_sector_stale[RESUME_LOG_SECTORS]; // 不要になったデータが残っている（要消去）
+static uint32_t g_next_seq = 1;
+// 最後にフラッシュへ書いた状態（差分の基準）
+static rpn_state_t g_saved;
+static bool g_saved_valid = false;
+// 起動時の既定状態（復元はここにレコードを適用するので、同じ値のレジスタは書かなくてよい）
+static rpn_state_t g_boot;
+static bool g_boot_valid = false;
+
+// 準備済み（未確定）の書込み
+static struct
+{
+    bool valid;
+    int sector;
+    uint32_t off;
+    uint32_t len;
+    bool switched;
+    rpn_state_t state;
+} g_pending;
+
+static inline const uint8_t *reg_ptr(const rpn_state_t *st, unsigned i)
 {
-    uint32_t crc = 0xFFFFFFFFu;
-    const uint8_t *p = (const uint8_t *)data;
-    while (len--)
+    return (const uint8_t *)st + i * RESUME_REG_SIZE;
+}
+
+static uint32_t popcount32(uint32_t v)
+{
+    uint32_t c = 0;
+    while (v)
     {
-        crc ^= *p++;
-        for (int i = 0; i < 8; i++)
-            crc = (crc >> 1) ^ (0xEDB88320u & (-(int)(crc & 1u)));
+        v &= v - 1;
+        c++;
     }
-    return ~crc;
+    return c;
 }
 
-void resume_save_if_enabled(void)
+static inline uint32_t record_len(uint32_t mask)
 {
-    if (!settings_get_resume_enabled())
+    uint32_t n = sizeof(ckpt_hdr_t) + popcount32(mask) * RESUME_REG_SIZE;
+    return (n + CKPT_ALIGN - 1) & ~(CKPT_ALIGN - 1);
+}
+
+// p から len バイトがすべて消去状態(0xFF)か（p と len は4バイト境界）
+static bool range_is_erased(const uint8_t *p, uint32_t len)
+{
+    const uint32_t *w = (const uint32_t *)p;
+    for (size_t i = 0; i < len / sizeof(uint32_t); ++i)
+        if (w[i] != 0xFFFFFFFFu)
+            return false;
+    return true;
+}
+
+// セクタ内のレコードを走査。apply!=NULL なら順に適用する。
+// 戻り値: 有効レコード数。*end_off=最後の有効レコードの直後、*clean_tail=以降が未書込みか
+// （ヘッダが 0xFF でもペイロードだけ書かれた途中書込みがあり得るので、末尾までを確認する）
+static int scan_sector(int sector, rpn_state_t *apply, uint32_t *last_seq, uint32_t *end_off, bool *clean_tail)
+{
+    const uint8_t *base = (const uint8_t *)(XIP_BASE + s_log_offset[sector]);
+    uint32_t off = 0;
+    int count = 0;
+    uint32_t prev_seq = 0;
+    *clean_tail = true;
+    while (off + sizeof(ckpt_hdr_t) <= FLASH_SECTOR_SIZE)
+    {
+        ckpt_hdr_t h;
+        memcpy(&h, base + off, sizeof(h));
+        if (h.magic == 0xFFFFFFFFu && h.crc == 0xFFFFFFFFu && h.seq == 0xFFFFFFFFu && h.mask == 0xFFFFFFFFu)
+        {
+            // 未書込み領域のはず。途中まで書かれていれば追記できないので別セクタへ詰め直させる
+            *clean_tail = range_is_erased(base + off, FLASH_SECTOR_SIZE - off);
+            break;
+        }
+        uint32_t len = record_len(h.mask);
+        if (h.magic != CKPT_MAGIC || (h.mask >> RESUME_REG_COUNT) != 0 || off + len > FLASH_SECTOR_SIZE ||
+            (count > 0 && h.seq <= prev_seq))
+        {
+            *clean_tail = false;
+            break;
+        }
+        uint32_t body = sizeof(ckpt_hdr_t) - 8u + popcount32(h.mask) * RESUME_REG_SIZE;
+        if (crc32_calc(base + off + 8u, body) != h.crc)
+        {
+            *clean_tail = false; // 書込み途中で電源断したレコード
+            break;
+        }
+        if (apply)
+        {
+            const uint8_t *src = base + off + sizeof(ckpt_hdr_t);
+            for (unsigned i = 0; i < RESUME_REG_COUNT; ++i)
+            {
+                if (h.mask & (1u << i))
+                {
+                    memcpy((uint8_t *)apply + i * RESUME_REG_SIZE, src, RESUME_REG_SIZE);
+                    src += RESUME_REG_SIZE;
+                }
+            }
+        }
+        prev_seq = h.seq;
+        count++;
+        off += len;
+    }
+    *last_seq = prev_seq;
+    *end_off = off;
+    return count;
+}
+
+bool resume_prepare_save(persist_block_t *out)
+{
+    g_pending.valid = false;
+    if (!out || !settings_get_resume_enabled())
+        return false;
+
+    rpn_state_t now;
+    rpn_get_state(&now);
+    uint32_t mask = 0;
+    for (unsigned i = 0; i < RESUME_REG_COUNT; ++i)
+    {
+        if (!g_saved_valid || memcmp(reg_ptr(&now, i), reg_ptr(&g_saved, i), RESUME_REG_SIZE) != 0)
+            mask |= (1u << i);
+    }
+    if (mask == 0)
+        return false;
+
+    // 追記先の決定: 現セクタに入らなければもう一方へ全レジスタで切り替える
+    int sector = g_active;
+    uint32_t off = g_append_off;
+    bool switched = false;
+    if (sector < 0 || off + record_len(mask) > FLASH_SECTOR_SIZE)
+    {
+        if (g_active < 0)
+            sector = g_sector_clean[1] && !g_sector_clean[0] ? 1 : 0; // 消去済みを優先
+        else
+            sector = (g_active + 1) % RESUME_LOG_SECTORS;
+        off = 0;
+        switched = true;
+        // 新セクタの先頭レコードだけで復元できるよう、既定状態と異なるレジスタをすべて書く
+        // （虚部や統計など、使っていない大半のレジスタは既定値のままなので省ける）
+        mask = 0;
+        for (unsigned i = 0; i < RESUME_REG_COUNT; ++i)
+        {
+            if (!g_boot_valid || memcmp(reg_ptr(&now, i), reg_ptr(&g_boot, i), RESUME_REG_SIZE) != 0)
+                mask |= (1u << i);
+        }
+    }
+    uint32_t len = record_len(mask);
+
+    // レコードを含むページ範囲をRAM上に組み立てる（他の位置は 0xFF = 書込みなし）
+    // レコードは CKPT_ALIGN 境界から始まるので、ページ末尾近くから始まる最大長のレコードが入る分を確保
+    static uint8_t page_buf[CKPT_BUF_PAGES * FLASH_PAGE_SIZE];
+    uint32_t page_start = off & ~(FLASH_PAGE_SIZE - 1u);
+    uint32_t in_page = off - page_start;
+    memset(page_buf, 0xFF, sizeof(page_buf));
+    uint8_t *rec = page_buf + in_page;
+    uint8_t *dst = rec + sizeof(ckpt_hdr_t);
+    for (unsigned i = 0; i < RESUME_REG_COUNT; ++i)
+    {
+        if (mask & (1u << i))
+        {
+            memcpy(dst, reg_ptr(&now, i), RESUME_REG_SIZE);
+            dst += RESUME_REG_SIZE;
+        }
+    }
+    ckpt_hdr_t h;
+    h.magic = CKPT_MAGIC;
+    h.seq = g_next_seq;
+    h.mask = mask;
+    h.crc = 0;
+    memcpy(rec, &h, sizeof(h));
+    h.crc = crc32_calc(rec + 8u, (size_t)(dst - rec) - 8u);
+    memcpy(rec, &h, sizeof(h));
+
+    out->flash_offset = s_log_offset[sector] + page_start;
+    out->data = page_buf;
+    out->len = (in_page + len + FLASH_PAGE_SIZE - 1u) & ~(FLASH_PAGE_SIZE - 1u);
+    // 切替先が消去済みでなければセクタ消去から行う
+    out->append = !(switched && !g_sector_clean[sector]);
+
+    g_pending.valid = true;
+    g_pending.sector = sector;
+    g_pending.off = off;
+    g_pending.len = len;
+    g_pending.switched = switched;
+    g_pending.state = now;
+    return true;
+}
+
+void resume_mark_saved(void)
+{
+    if (!g_pending.valid)
         return;
+    if (g_pending.switched)
+    {
+        // 旧セクタは新セクタの先頭レコードで不要になった（アイドル時に消去）
+        if (g_active >= 0)
+            g_sector_stale[g_active] = true;
+        g_active = g_pending.sector;
+        g_sector_stale[g_active] = false;
+    }
+    g_sector_clean[g_active] = false;
+    g_append_off = g_pending.off + g_pending.len;
+    g_saved = g_pending.state;
+    g_saved_valid = true;
+    g_next_seq++;
+    g_pending.valid = false;
+}
 
-    resume_blob_t blob;
-    memset(&blob, 0, sizeof(blob));
-    blob.magic = RESUME_MAGIC;
-    blob.version = RESUME_VERSION;
-    rpn_get_state(&blob.data.rpn);
-    blob.crc = crc32_calc(&blob.data, sizeof(blob.data));
-
-    // フラッシュ書込みはページ境界に揃える
-    static uint8_t pad_buf[FLASH_SECTOR_SIZE];
-    size_t raw_len = sizeof(blob);
-    size_t page = FLASH_PAGE_SIZE;
-    size_t write_len = (raw_len + (page - 1)) & ~(page - 1);
-    if (write_len > FLASH_SECTOR_SIZE)
-        write_len = FLASH_SECTOR_SIZE;
-    memset(pad_buf, 0xFF, write_len);
-    memcpy(pad_buf, &blob, raw_len);
-
-    uint32_t irq = save_and_disable_interrupts();
-    flash_range_erase(RESUME_FLASH_OFFSET, FLASH_SECTOR_SIZE);
-    flash_range_program(RESUME_FLASH_OFFSET, pad_buf, write_len);
-    restore_interrupts(irq);
+void resume_save_if_enabled(void)
+{
+    persist_block_t blk;
+    if (!resume_prepare_save(&blk))
+        return;
+    if (persist_write_blocks(&blk, 1))
+        resume_mark_saved();
 }
 
-void resume_try_restore_on_boot(void)
+void resume_checkpoint_idle(void)
 {
     if (!settings_get_resume_enabled())
         return;
+    // 差分があれば追記（通常は消去なしのページ書込みのみ）
+    resume_save_if_enabled();
+    // 不要になったセクタを事前消去しておく（次の切替を消去なしにする）
+    for (int i = 0; i < RESUME_LOG_SECTORS; ++i)
+    {
+        if (i != g_active && g_sector_stale[i])
+        {
+            if (persist_erase_sector(s_log_offset[i]))
+            {
+                g_sector_stale[i] = false;
+                g_sector_clean[i] = true;
+            }
+        }
+    }
+}
+
+// 旧形式(RSM1)からの復帰
+static bool restore_legacy(rpn_state_t *st)
+{
     const resume_blob_t *rom = (const resume_blob_t *)(XIP_BASE + RESUME_FLASH_OFFSET);
     if (rom->magic != RESUME_MAGIC || rom->version != RESUME_VERSION)
-        return;
+        return false;
     uint32_t crc = crc32_calc(&rom->data, sizeof(rom->data));
     if (crc != rom->crc)
+        return false;
+    // 旧形式に無いレジスタ（統計など）は既定値のまま
+    memcpy(st, (const void *)&rom->data.rpn, sizeof(rom->data.rpn));
+    return true;
+}
+
+void resume_try_restore_on_boot(void)
+{
+    rpn_get_state(&g_boot);
+    g_boot_valid = true;
+
+    // ログの位置を把握（Resume=OFF でも後で有効化されたときのため）
+    uint32_t best_seq = 0;
+    int best = -1;
+    uint32_t best_end = 0;
+    bool best_clean_tail = true;
+    for (int i = 0; i < RESUME_LOG_SECTORS; ++i)
+    {
+        uint32_t last_seq = 0, end_off = 0;
+        bool clean_tail = true;
+        int n = scan_sector(i, NULL, &last_seq, &end_off, &clean_tail);
+        g_sector_clean[i] = (n == 0 && clean_tail); // clean_tail は先頭から末尾までの消去確認を含む
+        g_sector_stale[i] = !g_sector_clean[i];
+        if (n > 0 && (best < 0 || last_seq > best_seq))
+        {
+            best = i;
+            best_seq = last_seq;
+            best_end = end_off;
+            best_clean_tail = clean_tail;
+        }
+    }
+    if (best >= 0)
+    {
+        g_sector_stale[best] = false;
+        g_next_seq = best_seq + 1;
+        // 末尾が壊れている場合はそれ以降に追記できないので次回は切り替える
+        g_active = best;
+        g_append_off = best_clean_tail ? best_end : FLASH_SECTOR_SIZE;
+    }
+
+    if (!settings_get_resume_enabled())
+        return;
+
+    // 起動時の既定状態に最新チェックポイントまでを順に適用
+    rpn_state_t st;
+    rpn_get_state(&st);
+    bool restored = false;
+    if (best >= 0)
+    {
+        uint32_t last_seq, end_off;
+        bool clean_tail;
+        scan_sector(best, &st, &last_seq, &end_off, &clean_tail);
+        restored = true;
+    }
+    else
+    {
+        restored = restore_legacy(&st);
+    }
+    if (!restored)
         return;
     // 復帰
-    rpn_set_state(&rom->data.rpn);
+    rpn_set_state(&st);
+    // ログから復帰した場合は現在値が差分の基準になる
+    if (best >= 0)
+    {
+        g_saved = st;
+        g_saved_valid = true;
+    }
 }
@@ -1,13 +1,22 @@
 #ifndef RESUME_H
 #define RESUME_H
 
+#include <stdbool.h>
+#include "persist.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// 電源OFF時に状態を保存（Resume=ON の場合のみ動作）
+// 前回のチェックポイントからの差分を追記（Resume=ON の場合のみ動作）
 void resume_save_if_enabled(void);
-// 起動時に復帰試行（Resume=ON かつチェックサム正常時のみ復帰）
+// 一括保存用: Resume=ON かつ差分があれば追記レコードをRAM上に組み立てて true を返す
+bool resume_prepare_save(persist_block_t *out);
+// 一括保存の完了後に呼ぶ（追記位置と差分の基準を更新）
+void resume_mark_saved(void);
+// アイドル時に呼ぶ: 差分を追記し、不要になったログセクタを事前消去する
+void resume_checkpoint_idle(void);
+// 起動時に復帰試行（Resume=ON なら最新の有効なチェックポイントまで再生して復帰）
 void resume_try_restore_on_boot(void);
 
 #ifdef __cplusplus
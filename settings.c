@@ -1,8 +1,9 @@
 #include "settings.h"
 #include <string.h>
+#include <stddef.h>
 #include "pico/stdlib.h"
 #include "hardware/flash.h"
-#include "hardware/sync.h"
+#include "crc32.h"
 
 // 保存領域: 最終ページを1ページ確保（4096B）
 #define FLASH_TARGET_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE) // 末尾から1セクタ
@@ -19,29 +20,22 @@ typedef struct __attribute__((packed))
     uint32_t digits_value;   // 表示桁数: 0..9, 0xFF=ALL
     uint32_t last_key_mode;  // 0=Last X, 1=Undo
     uint32_t resume_enabled; // 0=OFF, 1=ON
+    // v5 追加項目
+    uint32_t complex_results; // 0=OFF, 1=ON
+    // v6 追加項目
+    uint32_t precision; // 0=34桁(BID128), 1=16桁(BID64)
 } settings_blob_t;
 
 static const uint32_t SETTINGS_MAGIC = 0x53544631; // 'STF1'
-static const uint32_t SETTINGS_VERSION = 4;        // v4 で digits/last_key/resume を追加
+static const uint32_t SETTINGS_VERSION = 6;        // v6 で precision を追加
+// v4 の構造は v5 の complex_results の手前まで、v5 は v6 の precision の手前まで
+#define SETTINGS_V4_SIZE offsetof(settings_blob_t, complex_results)
+#define SETTINGS_V5_SIZE offsetof(settings_blob_t, precision)
 
 static settings_blob_t g_loaded;
 static bool g_have_loaded = false;
 static bool g_dirty_since_boot = false;
 
-// 簡易CRC32（Poly 0xEDB88320）
-static uint32_t crc32_calc(const void *data, size_t len)
-{
-    uint32_t crc = 0xFFFFFFFFu;
-    const uint8_t *p = (const uint8_t *)data;
-    while (len--)
-    {
-        crc ^= *p++;
-        for (int i = 0; i < 8; i++)
-            crc = (crc >> 1) ^ (0xEDB88320u & (-(int)(crc & 1u)));
-    }
-    return ~crc;
-}
-
 static void defaults(init_state_t *s)
 {
     s->angle_mode = ANGLE_MODE_DEG;
@@ -54,7 +48,8 @@ void settings_init(void)
 {
     // フラッシュから読み出し
     const settings_blob_t *rom = (const settings_blob_t *)(XIP_BASE + FLASH_TARGET_OFFSET);
-    if (rom->magic == SETTINGS_MAGIC && (rom->version == 1 || rom->version == 2 || rom->version == 3 || rom->version == SETTINGS_VERSION))
+    if (rom->magic == SETTINGS_MAGIC && (rom->version == 1 || rom->version == 2 || rom->version == 3 || rom->version == 4 ||
+                                       rom->version == 5 || rom->version == SETTINGS_VERSION))
     {
         // v1とv2でCRCの取り方を切り分け
         if (rom->version == 1)
@@ -74,6 +69,8 @@ void settings_init(void)
                 g_loaded.digits_value = 0xFFu;         // ALL
                 g_loaded.last_key_mode = 0u;           // Last X
                 g_loaded.resume_enabled = 0u;          // OFF
+                g_loaded.complex_results = 0u;         // v5 追加分
+                g_loaded.precision = 0u;               // v6 追加分
                 // CRCをv2形式で再計算
                 uint32_t new_crc = crc32_calc(&g_loaded.data, sizeof(g_loaded.data));
                 g_loaded.crc = new_crc;
@@ -96,6 +93,8 @@ void settings_init(void)
                 g_loaded.digits_value = 0xFFu;         // ALL
                 g_loaded.last_key_mode = 0u;           // Last X
                 g_loaded.resume_enabled = 0u;          // OFF
+                g_loaded.complex_results = 0u;         // v5 追加分
+                g_loaded.precision = 0u;               // v6 追加分
                 g_loaded.crc = rom->crc;
                 g_have_loaded = true;
             }
@@ -116,17 +115,45 @@ void settings_init(void)
                 g_loaded.digits_value = 0xFFu;
                 g_loaded.last_key_mode = 0u;
                 g_loaded.resume_enabled = 0u;
+                g_loaded.complex_results = 0u;
+                g_loaded.precision = 0u;
                 g_loaded.crc = rom->crc;
                 g_have_loaded = true;
             }
         }
+        else if (rom->version == 4)
+        {
+            // v4: 共通部分をそのまま使い、v5 追加分はデフォルト
+            uint32_t crc = crc32_calc(&rom->data, sizeof(rom->data));
+            if (crc == rom->crc)
+            {
+                memset(&g_loaded, 0, sizeof(g_loaded));
+                memcpy(&g_loaded, rom, SETTINGS_V4_SIZE);
+                g_loaded.version = SETTINGS_VERSION;
+                g_loaded.complex_results = 0u;
+                g_loaded.precision = 0u;
+                g_have_loaded = true;
+            }
+        }
+        else if (rom->version == 5)
+        {
+            // v5: v6 追加分はデフォルト（34桁）
+            uint32_t crc = crc32_calc(&rom->data, sizeof(rom->data));
+            if (crc == rom->crc)
+            {
+                memset(&g_loaded, 0, sizeof(g_loaded));
+                memcpy(&g_loaded, rom, SETTINGS_V5_SIZE);
+                g_loaded.version = SETTINGS_VERSION;
+                g_loaded.precision = 0u;
+                g_have_loaded = true;
+            }
+        }
         else
         {
-            // v3 現行
+            // v6 現行
             uint32_t crc = crc32_calc(&rom->data, sizeof(rom->data));
             if (crc == rom->crc)
             {
-                // v4 現行をそのままロード
                 g_loaded = *rom;
                 g_have_loaded = true;
             }
@@ -143,6 +170,8 @@ void settings_init(void)
         g_loaded.digits_value = 0xFFu;                      // ALL
         g_loaded.last_key_mode = 0u;                        // Last X
         g_loaded.resume_enabled = 0u;                       // OFF
+        g_loaded.complex_results = 0u;                      // OFF
+        g_loaded.precision = 0u;                            // 34桁
         g_loaded.crc = crc32_calc(&g_loaded.data, sizeof(g_loaded.data));
     }
     g_dirty_since_boot = false;
@@ -168,16 +197,34 @@ void settings_on_values_changed(disp_mode_t disp, angle_mode_t angle, hyperbolic
     }
 }
 
+bool settings_prepare_save(persist_block_t *out)
+{
+    if (!out || !g_dirty_since_boot)
+        return false;
+    // フラッシュ書込みはページ単位。未使用領域は 0xFF で埋める。
+    static uint8_t pad_buf[(sizeof(settings_blob_t) + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1)];
+    memset(pad_buf, 0xFF, sizeof(pad_buf));
+    memcpy(pad_buf, &g_loaded, sizeof(g_loaded));
+    out->flash_offset = FLASH_TARGET_OFFSET;
+    out->data = pad_buf;
+    out->len = sizeof(pad_buf);
+    out->append = false;
+    return true;
+}
+
+void settings_mark_saved(void)
+{
+    g_dirty_since_boot = false;
+}
+
 void settings_save_if_dirty(void)
 {
-    if (!g_dirty_since_boot)
+    persist_block_t blk;
+    if (!settings_prepare_save(&blk))
         return;
     // セクタ消去→書込み
-    uint32_t ints = save_and_disable_interrupts();
-    flash_range_erase(FLASH_TARGET_OFFSET, FLASH_SECTOR_SIZE);
-    flash_range_program(FLASH_TARGET_OFFSET, (const uint8_t *)&g_loaded, sizeof(g_loaded));
-    restore_interrupts(ints);
-    g_dirty_since_boot = false;
+    if (persist_write_blocks(&blk, 1))
+        settings_mark_saved();
 }
 
 void settings_reset_to_defaults(void)
@@ -194,6 +241,8 @@ void settings_reset_to_defaults(void)
     g_loaded.digits_value = 0xFFu;
     g_loaded.last_key_mode = 0u;
     g_loaded.resume_enabled = 0u;
+    g_loaded.complex_results = 0u;
+    g_loaded.precision = 0u;
     g_loaded.crc = crc32_calc(&g_loaded.data, sizeof(g_loaded.data));
     g_have_loaded = true;
     g_dirty_since_boot = true;
@@ -348,3 +397,43 @@ void settings_set_resume_enabled(bool enabled)
         g_dirty_since_boot = true;
     }
 }
+
+// ---- 複素数の結果 ON/OFF ----
+bool settings_get_complex_results(void)
+{
+    if (!g_have_loaded)
+        settings_init();
+    return g_loaded.complex_results ? true : false;
+}
+
+void settings_set_complex_results(bool enabled)
+{
+    if (!g_have_loaded)
+        settings_init();
+    uint32_t v = enabled ? 1u : 0u;
+    if (g_loaded.complex_results != v)
+    {
+        g_loaded.complex_results = v;
+        g_dirty_since_boot = true;
+    }
+}
+
+// ---- 作業精度 ----
+precision_mode_t settings_get_precision(void)
+{
+    if (!g_have_loaded)
+        settings_init();
+    return (g_loaded.precision == 1u) ? PRECISION_16 : PRECISION_34;
+}
+
+void settings_set_precision(precision_mode_t mode)
+{
+    if (!g_have_loaded)
+        settings_init();
+    uint32_t v = (mode == PRECISION_16) ? 1u : 0u;
+    if (g_loaded.precision != v)
+    {
+        g_loaded.precision = v;
+        g_dirty_since_boot = true;
+    }
+}
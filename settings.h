@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "RPN.h"
+#include "persist.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -28,6 +29,10 @@ extern "C"
     void settings_on_values_changed(disp_mode_t disp, angle_mode_t angle, hyperbolic_mode_t hyperb, zero_mode_t zero);
     // 電源OFF直前に呼ぶ。電源投入以降に変更がある場合のみ保存する
     void settings_save_if_dirty(void);
+    // 一括保存用: 変更があれば保存ブロブをRAM上に組み立てて true を返す
+    bool settings_prepare_save(persist_block_t *out);
+    // 一括保存の完了後に呼ぶ（dirty解除）
+    void settings_mark_saved(void);
 
     // フラッシュの保存内容をデフォルトにリセットし、即時書き込みする
     void settings_reset_to_defaults(void);
@@ -59,6 +64,19 @@ extern "C"
     bool settings_get_resume_enabled(void);
     void settings_set_resume_enabled(bool enabled);
 
+    // 複素数の結果: ON なら実数で定義域外の演算（√-1 など）を複素数で返す
+    bool settings_get_complex_results(void);
+    void settings_set_complex_results(bool enabled);
+
+    // 作業精度: 34桁は BID128、16桁は主要な演算を BID64 で行う（レジスタと保存は常に BID128）
+    typedef enum
+    {
+        PRECISION_34 = 0,
+        PRECISION_16 = 1,
+    } precision_mode_t;
+    precision_mode_t settings_get_precision(void);
+    void settings_set_precision(precision_mode_t mode);
+
 #ifdef __cplusplus
 }
 #endif
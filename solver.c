@@ -0,0 +1,285 @@
+// 数値求根（SOLVE）: マクロを f(x) として割線法で符号変化を探し、Brent法で収束させる
+#include "solver.h"
+#include "pico/stdlib.h"
+#include "RPN.h"
+#include "bid_ops.h"
+#include "compute.h"
+#include "macro.h"
+#include "macro_exec.h"
+#include "profile.h"
+
+// 相対許容誤差（34桁の末尾付近）と、根が0付近のときの絶対許容誤差
+#define SOLVER_EPS "1E-33"
+#define SOLVER_ABS_TOL "1E-99"
+// 符号変化の探索で |f| がこの回数続けて改善しなければ根なしとする
+#define SOLVER_STALL_LIMIT 20
+
+static int g_slot = 0;
+static volatile solver_status_t g_status = SOLVER_OK;
+static uint32_t g_evals = 0;
+static uint64_t g_deadline_us = 0;
+static bool g_failed = false; // 評価の中断（取消し/未対応キー/時間切れ）
+
+// f(x): スタックを x で満たしてマクロを実行し、X を返す
+static BID_UINT128 eval_f(BID_UINT128 x)
+{
+    if (g_failed)
+        return x;
+    rpn_load_stack(x, x, x, x);
+    if (!macro_exec_headless(g_slot))
+    {
+        g_status = compute_cancel_requested() ? SOLVER_CANCELED : SOLVER_BAD_MACRO;
+        g_failed = true;
+        return x;
+    }
+    g_evals++;
+    compute_set_progress("SOLVE", g_evals);
+    if (time_us_64() >= g_deadline_us)
+    {
+        g_status = SOLVER_TIMEOUT;
+        g_failed = true;
+    }
+    return rpn_stack_x();
+}
+
+static bool same_sign(BID_UINT128 a, BID_UINT128 b)
+{
+    return d_is_neg(a) == d_is_neg(b);
+}
+
+// Brent法（[a,b] で f の符号が異なること）。根を *root、直前の推定値を *prev に返す
+static bool brent(BID_UINT128 a, BID_UINT128 fa, BID_UINT128 b, BID_UINT128 fb, BID_UINT128 *root, BID_UINT128 *prev,
+                  BID_UINT128 *froot)
+{
+    const BID_UINT128 zero = d_from_int(0);
+    const BID_UINT128 one = d_from_int(1);
+    const BID_UINT128 two = d_from_int(2);
+    const BID_UINT128 three = d_from_int(3);
+    const BID_UINT128 half = d_from_str("0.5");
+    const BID_UINT128 eps = d_from_str(SOLVER_EPS);
+    const BID_UINT128 abs_tol = d_from_str(SOLVER_ABS_TOL);
+    BID_UINT128 c = a, fc = fa;
+    BID_UINT128 d = d_sub(b, a), e = d;
+    *prev = a;
+    while (!g_failed && g_evals < SOLVER_MAX_EVALS)
+    {
+        if (same_sign(fb, fc))
+        {
+            c = a;
+            fc = fa;
+            d = e = d_sub(b, a);
+        }
+        if (d_lt(d_abs(fc), d_abs(fb)))
+        {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        BID_UINT128 tol1 = d_add(d_mul(d_mul(two, eps), d_abs(b)), d_mul(half, abs_tol));
+        BID_UINT128 xm = d_mul(half, d_sub(c, b));
+        if (!d_gt(d_abs(xm), tol1) || d_is_zero(fb))
+        {
+            *root = b;
+            *froot = fb;
+            return true;
+        }
+        if (!d_lt(d_abs(e), tol1) && d_gt(d_abs(fa), d_abs(fb)))
+        {
+            // 逆2次補間（a==c なら割線）
+            BID_UINT128 s = d_div(fb, fa), p, q;
+            if (d_eq(a, c))
+            {
+                p = d_mul(d_mul(two, xm), s);
+                q = d_sub(one, s);
+            }
+            else
+            {
+                BID_UINT128 qq = d_div(fa, fc), r = d_div(fb, fc);
+                p = d_mul(s, d_sub(d_mul(d_mul(d_mul(two, xm), qq), d_sub(qq, r)), d_mul(d_sub(b, a), d_sub(r, one))));
+                q = d_mul(d_mul(d_sub(qq, one), d_sub(r, one)), d_sub(s, one));
+            }
+            if (d_gt(p, zero))
+                q = d_neg(q);
+            p = d_abs(p);
+            BID_UINT128 min1 = d_sub(d_mul(d_mul(three, xm), q), d_abs(d_mul(tol1, q)));
+            BID_UINT128 min2 = d_abs(d_mul(e, q));
+            BID_UINT128 lim = d_lt(min1, min2) ? min1 : min2;
+            if (d_lt(d_mul(two, p), lim))
+            {
+                e = d;
+                d = d_div(p, q);
+            }
+            else
+            {
+                // 補間が区間を外れる/収束が遅いので二分法
+                d = xm;
+                e = d;
+            }
+        }
+        else
+        {
+            d = xm;
+            e = d;
+        }
+        a = b;
+        fa = fb;
+        *prev = a;
+        if (d_gt(d_abs(d), tol1))
+            b = d_add(b, d);
+        else
+            b = d_is_neg(xm) ? d_sub(b, tol1) : d_add(b, tol1);
+        fb = eval_f(b);
+    }
+    *root = b;
+    *froot = fb;
+    return false;
+}
+
+static void solve_op(void)
+{
+    g_evals = 0;
+    g_failed = false;
+    g_status = SOLVER_OK;
+    g_deadline_us = time_us_64() + (uint64_t)SOLVER_TIME_LIMIT_MS * 1000u;
+    rpn_undo_suspend(true);
+
+    if (rpn_is_input_active())
+        rpn_commit_input_without_push();
+    BID_UINT128 t = rpn_stack_t();
+    BID_UINT128 b = rpn_stack_x();
+    BID_UINT128 a = rpn_stack_y();
+    // 推定値が同じなら少しずらす
+    if (d_eq(a, b))
+    {
+        BID_UINT128 delta = d_mul(d_abs(b), d_from_str("1E-3"));
+        if (d_is_zero(delta))
+            delta = d_from_str("1E-3");
+        a = d_add(b, delta);
+    }
+
+    BID_UINT128 fa = eval_f(a);
+    BID_UINT128 fb = eval_f(b);
+    BID_UINT128 root = b, prev = a, froot = fb;
+    bool found = false;
+    const BID_UINT128 two = d_from_int(2);
+    const BID_UINT128 ten = d_from_int(10);
+    const BID_UINT128 eps = d_from_str(SOLVER_EPS);
+
+    // 割線法で符号変化を探す（ステップは直前の幅の10倍までに制限）
+    BID_UINT128 best = d_lt(d_abs(fa), d_abs(fb)) ? d_abs(fa) : d_abs(fb);
+    int stall = 0;
+    while (!g_failed && !d_is_zero(fa) && !d_is_zero(fb) && same_sign(fa, fb))
+    {
+        if (g_evals >= SOLVER_MAX_EVALS || stall >= SOLVER_STALL_LIMIT)
+            break;
+        if (d_lt(d_abs(fa), d_abs(fb)))
+        {
+            BID_UINT128 tmp = a;
+            a = b;
+            b = tmp;
+            tmp = fa;
+            fa = fb;
+            fb = tmp;
+        }
+        // b が良い方の推定値
+        BID_UINT128 width = d_sub(b, a);
+        if (!d_gt(d_abs(width), d_mul(eps, d_abs(b))))
+            break; // 幅が縮み切った（極小値付近で根が無い）
+        BID_UINT128 step;
+        BID_UINT128 df = d_sub(fb, fa);
+        if (d_is_zero(df))
+            step = d_mul(width, two);
+        else
+            step = d_neg(d_div(d_mul(fb, width), df));
+        BID_UINT128 max_step = d_mul(d_abs(width), ten);
+        if (!d_is_finite(step) || d_gt(d_abs(step), max_step))
+            step = d_is_neg(step) ? d_neg(max_step) : max_step;
+        BID_UINT128 c = d_add(b, step);
+        BID_UINT128 fc = eval_f(c);
+        // 定義域外（NaN/Inf）なら b 側へ半分ずつ戻す
+        for (int k = 0; k < 8 && !g_failed && !d_is_finite(fc); ++k)
+        {
+            step = d_div(step, two);
+            c = d_add(b, step);
+            fc = eval_f(c);
+        }
+        a = b;
+        fa = fb;
+        b = c;
+        fb = fc;
+        if (d_lt(d_abs(fc), best))
+        {
+            best = d_abs(fc);
+            stall = 0;
+        }
+        else
+        {
+            stall++;
+        }
+    }
+
+    if (g_failed)
+    {
+        root = b;
+        prev = a;
+        froot = fb;
+    }
+    else if (d_is_zero(fb))
+    {
+        root = b;
+        prev = a;
+        froot = fb;
+        found = true;
+    }
+    else if (d_is_zero(fa))
+    {
+        root = a;
+        prev = b;
+        froot = fa;
+        found = true;
+    }
+    else if (!same_sign(fa, fb))
+    {
+        found = brent(a, fa, b, fb, &root, &prev, &froot);
+    }
+    else
+    {
+        // 見つからない場合は |f| の小さい方を残す
+        bool b_better = d_lt(d_abs(fb), d_abs(fa));
+        root = b_better ? b : a;
+        prev = b_better ? a : b;
+        froot = b_better ? fb : fa;
+    }
+
+    if (!g_failed && !found)
+        g_status = SOLVER_NO_ROOT;
+    rpn_undo_suspend(false);
+    if (g_status == SOLVER_CANCELED)
+        return; // 状態は呼び出し側で元に戻す
+    rpn_load_stack(root, prev, froot, t);
+    _IDEC_glbflags = BID_EXACT_STATUS;
+}
+
+solver_status_t solver_solve(int slot)
+{
+    if (!macro_has(slot))
+        return SOLVER_BAD_MACRO;
+    g_slot = slot;
+    rpn_cancel_snapshot();
+    // Undo で求解前のスタックに戻れるよう境界を取る（取消し時はこれも捨てる）
+    rpn_undo_capture_boundary();
+    if (!compute_run(solve_op))
+        g_status = SOLVER_CANCELED;
+    profile_record("solve", compute_last_cycles());
+    if (g_status == SOLVER_CANCELED || g_status == SOLVER_BAD_MACRO)
+        rpn_cancel_restore();
+    return g_status;
+}
+
+uint32_t solver_last_evals(void)
+{
+    return g_evals;
+}
@@ -0,0 +1,42 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 関数評価の上限回数と制限時間（ビルド時に上書き可）
+#ifndef SOLVER_MAX_EVALS
+#define SOLVER_MAX_EVALS 200
+#endif
+#ifndef SOLVER_TIME_LIMIT_MS
+#define SOLVER_TIME_LIMIT_MS 60000u
+#endif
+
+    typedef enum
+    {
+        SOLVER_OK,
+        SOLVER_NO_ROOT,   // 符号変化が見つからない/評価回数の上限
+        SOLVER_TIMEOUT,   // 制限時間を超えた
+        SOLVER_BAD_MACRO, // マクロが空、または評価中に実行できないキーを含む
+        SOLVER_CANCELED,  // DEL/OFF で取消し（状態は実行前に戻す）
+    } solver_status_t;
+
+    // マクロ slot(0..2) を f(x) として f(x)=0 を解く。初期推定値は Y と X。
+    // 評価ごとに X,Y,Z,T を x で満たしてからマクロをヘッドレス実行し、X を f(x) とする。
+    // 結果: X=根, Y=直前の推定値, Z=f(根)（見つからない場合も最良の推定値を残す）
+    // core0 から呼ぶ（評価は core1 で行い、待機中は進捗を表示する）
+    solver_status_t solver_solve(int slot);
+
+    // 直近の求解での関数評価回数
+    uint32_t solver_last_evals(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOLVER_H
@@ -0,0 +1,27 @@
+// ホストビルド用: batch.c が使う pico/stdlib.h の機能だけを標準Cで置き換える
+#ifndef TOOLS_HOST_PICO_STDLIB_H
+#define TOOLS_HOST_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define PICO_ERROR_TIMEOUT (-1)
+
+static inline uint64_t time_us_64(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static inline void stdio_init_all(void) {}
+
+// ホストでは標準入力をブロックして読む（EOF は -1）
+static inline int getchar_timeout_us(uint32_t timeout_us)
+{
+    (void)timeout_us;
+    return getchar();
+}
+
+#endif // TOOLS_HOST_PICO_STDLIB_H
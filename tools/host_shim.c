@@ -0,0 +1,95 @@
+// ホストビルド用のファームウェア側モジュール代替（settings/compute/key/macro/profile/datalist）
+#include "host_shim.h"
+#include <time.h>
+#include "settings.h"
+#include "compute.h"
+#include "key.h"
+#include "macro.h"
+#include "profile.h"
+#include "datalist.h"
+
+static init_state_t g_init;
+static int8_t g_digits;
+static bool g_complex_results;
+static precision_mode_t g_precision;
+static uint32_t g_last_cycles;
+
+static void settings_defaults(void)
+{
+    g_init.angle_mode = ANGLE_MODE_DEG;
+    g_init.disp_mode = DISP_MODE_NORMAL;
+    g_init.hyperbolic_mode = HYPERBOLIC_MODE_OFF;
+    g_init.zero_mode = ZERO_MODE_TRIM;
+    g_digits = -1; // ALL
+    g_complex_results = false;
+    g_precision = PRECISION_34;
+}
+
+void host_reset(void)
+{
+    settings_defaults();
+    rpn_set_interval_mode(false);
+    init_rpn();
+}
+
+// ---- settings ----
+void settings_init(void) {}
+void settings_load_into(init_state_t *out) { *out = g_init; }
+void settings_on_values_changed(disp_mode_t disp, angle_mode_t angle, hyperbolic_mode_t hyperb, zero_mode_t zero)
+{
+    g_init.disp_mode = disp;
+    g_init.angle_mode = angle;
+    g_init.hyperbolic_mode = hyperb;
+    g_init.zero_mode = zero;
+}
+void settings_save_if_dirty(void) {}
+int8_t settings_get_digits(void) { return g_digits; }
+void settings_set_digits(int8_t digits) { g_digits = (digits < 0) ? -1 : (digits > 9 ? 9 : digits); }
+last_key_mode_t settings_get_last_key_mode(void) { return LAST_KEY_LAST_X; }
+bool settings_get_complex_results(void) { return g_complex_results; }
+void settings_set_complex_results(bool enabled) { g_complex_results = enabled; }
+precision_mode_t settings_get_precision(void) { return g_precision; }
+void settings_set_precision(precision_mode_t mode) { g_precision = mode; }
+
+// ---- compute: 取消しは起きない ----
+uint32_t profile_cycles(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000000u + (uint32_t)ts.tv_nsec; // ns を1サイクルとみなす
+}
+void profile_stop(const char *name, uint32_t start_cycles)
+{
+    (void)name;
+    (void)start_cycles;
+}
+bool compute_run(compute_op_t op)
+{
+    uint32_t t0 = profile_cycles();
+    if (op)
+        op();
+    g_last_cycles = profile_cycles() - t0;
+    return true;
+}
+bool compute_cancel_requested(void) { return false; }
+uint32_t compute_last_cycles(void) { return g_last_cycles; }
+
+// ---- key/macro ----
+void key_set_shift_state(bool shift_on) { (void)shift_on; }
+bool macro_is_recording(void) { return false; }
+bool macro_is_playing(void) { return false; }
+
+// ---- datalist: 保持しない ----
+int datalist_count(void) { return 0; }
+bool datalist_append(BID_UINT128 v)
+{
+    (void)v;
+    return false;
+}
+void datalist_sort(void) {}
+bool datalist_quantile(BID_UINT128 p, BID_UINT128 *out)
+{
+    (void)p;
+    (void)out;
+    return false;
+}
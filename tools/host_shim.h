@@ -0,0 +1,12 @@
+// ホストビルド用: RPN.c / batch.c が参照するファームウェア側モジュールの代替
+// 設定はメモリ上だけに持ち、演算は呼び出し元でそのまま実行する（core1・フラッシュ・LCD なし）。
+// データリストは持たない（リスト演算は満杯/空として無効演算になる）
+#ifndef TOOLS_HOST_SHIM_H
+#define TOOLS_HOST_SHIM_H
+
+#include "RPN.h"
+
+// 設定を既定値に戻し、RPN の状態（スタック/変数/統計/区間モード）を起動直後に戻す
+void host_reset(void);
+
+#endif // TOOLS_HOST_SHIM_H
@@ -0,0 +1,181 @@
+// RPN エンジンの回帰コーパスをホストで実行する
+// 使い方: rpn_corpus [-q] [-n 回数] corpus/basic.txt ...
+//   -q: 失敗したケースと集計だけを出す  -n: 各ケースを繰り返して平均時間を出す
+// ビルド（ホスト向けにビルドした Intel BID ライブラリ libbid.a が必要）:
+//   cc -O2 -I.. -Ihost -DRPN35_SERIAL_BATCH=1 -DBID_THREAD= -o rpn_corpus rpn_corpus.c host_shim.c
+//      ../RPN.c ../cplx.c ../fraction.c ../batch.c libbid.a
+//
+// コーパスの書式（1ケース = "> トークン列" の行と、それに続く表示モードごとの期待値の行）:
+//   # コメント
+//   > 12345 1000 *             トークンはシリアル一括計算（batch.c）と同じ
+//   norm 12345000              表示モード（norm/sci/eng/frac）と期待する X [Y]
+//   eng 12.345E6 0             Y を省くか "*" にすると照合しない
+// 期待値の行ごとに状態を起動直後に戻し、表示モードを設定してからトークン列を実行する
+// （分数モードでは四則の結果自体が変わるので、整形し直すだけでなく毎回実行し直す）
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_shim.h"
+#include "batch.h"
+
+#define CORPUS_LINE_MAX 512
+#define CORPUS_TOKENS_MAX 64
+#define RESULT_MAX 84 // batch.c の応答と同じ
+
+typedef struct
+{
+    char line[CORPUS_LINE_MAX];
+    char *tokens[CORPUS_TOKENS_MAX];
+    int count;
+    int line_no;
+} corpus_case_t;
+
+static int g_cases = 0;
+static int g_failed = 0;
+static double g_total_us = 0.0;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static int split_tokens(char *s, char **out, int max)
+{
+    int n = 0;
+    for (char *t = strtok(s, " \t\r\n"); t && n < max; t = strtok(NULL, " \t\r\n"))
+        out[n++] = t;
+    return n;
+}
+
+static bool is_disp_mode(const char *t)
+{
+    return strcmp(t, "norm") == 0 || strcmp(t, "sci") == 0 || strcmp(t, "eng") == 0 || strcmp(t, "frac") == 0;
+}
+
+// 1ケースを mode で実行して X/Y を得る。戻り値: 全トークンを解釈できたら true
+static bool run_case(const corpus_case_t *c, const char *mode, char *x, char *y, const char **bad)
+{
+    host_reset();
+    batch_run_token(mode);
+    for (int i = 0; i < c->count; ++i)
+    {
+        if (!batch_run_token(c->tokens[i]))
+        {
+            *bad = c->tokens[i];
+            return false;
+        }
+    }
+    batch_format_level(0, x, RESULT_MAX);
+    batch_format_level(1, y, RESULT_MAX);
+    return true;
+}
+
+static void check_expectation(const corpus_case_t *c, char **exp, int n, int line_no, int repeat, bool quiet)
+{
+    const char *mode = exp[0];
+    const char *want_x = exp[1];
+    const char *want_y = (n >= 3 && strcmp(exp[2], "*") != 0) ? exp[2] : NULL;
+    char x[RESULT_MAX], y[RESULT_MAX];
+    const char *bad = NULL;
+    bool ok = true;
+    double t0 = now_us();
+    for (int r = 0; r < repeat && ok; ++r)
+        ok = run_case(c, mode, x, y, &bad);
+    double us = (now_us() - t0) / repeat;
+    g_cases++;
+    g_total_us += us;
+    if (!ok)
+    {
+        g_failed++;
+        printf("FAIL %4d %-4s unknown token \"%s\"\n", line_no, mode, bad);
+        return;
+    }
+    bool pass = strcmp(x, want_x) == 0 && (!want_y || strcmp(y, want_y) == 0);
+    if (!pass)
+    {
+        g_failed++;
+        printf("FAIL %4d %-4s %9.2f us  X=%s (want %s)", line_no, mode, us, x, want_x);
+        if (want_y)
+            printf("  Y=%s (want %s)", y, want_y);
+        printf("\n");
+    }
+    else if (!quiet)
+    {
+        printf("PASS %4d %-4s %9.2f us  X=%s\n", line_no, mode, us, x);
+    }
+}
+
+static int run_file(const char *path, int repeat, bool quiet)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        return -1;
+    }
+    static corpus_case_t c;
+    bool have_case = false;
+    char buf[CORPUS_LINE_MAX];
+    int line_no = 0;
+    while (fgets(buf, sizeof(buf), f))
+    {
+        line_no++;
+        char *p = buf;
+        while (*p == ' ' || *p == '\t')
+            ++p;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+            continue;
+        if (*p == '>')
+        {
+            strncpy(c.line, p + 1, sizeof(c.line) - 1);
+            c.line[sizeof(c.line) - 1] = '\0';
+            c.count = split_tokens(c.line, c.tokens, CORPUS_TOKENS_MAX);
+            c.line_no = line_no;
+            have_case = true;
+            continue;
+        }
+        char *exp[3];
+        int n = split_tokens(p, exp, 3);
+        if (!have_case || n < 2 || !is_disp_mode(exp[0]))
+        {
+            fprintf(stderr, "%s:%d: expected \"> tokens\" or \"<norm|sci|eng|frac> X [Y]\"\n", path, line_no);
+            fclose(f);
+            return -1;
+        }
+        check_expectation(&c, exp, n, line_no, repeat, quiet);
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int repeat = 1;
+    bool quiet = false;
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-'; ++first)
+    {
+        if (strcmp(argv[first], "-q") == 0)
+            quiet = true;
+        else if (strcmp(argv[first], "-n") == 0 && first + 1 < argc)
+            repeat = atoi(argv[++first]);
+        else
+            break;
+    }
+    if (first >= argc || repeat < 1)
+    {
+        fprintf(stderr, "usage: %s [-q] [-n repeat] corpus.txt ...\n", argv[0]);
+        return 2;
+    }
+    for (int i = first; i < argc; ++i)
+    {
+        if (run_file(argv[i], repeat, quiet) != 0)
+            return 2;
+    }
+    printf("# %d cases, %d failed, %.1f us total, %.0f cases/s\n", g_cases, g_failed, g_total_us,
+           g_total_us > 0.0 ? g_cases * 1e6 / g_total_us : 0.0);
+    return g_failed ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+// 入力編集と数値整形のホスト向けファズターゲット
+// 先頭1バイトで対象を選ぶ: 偶数 = キー列（rpn_input_* と四則/スタック操作）、奇数 = bid128_to_str
+//   キー列: 1バイト = 1キー。毎キー後に入力文字列の長さ・終端・文字種を検査する
+//   整形:   16バイトのビット列 + バッファ長(1..64)/表示モード/桁数。ちょうどの長さで malloc した
+//           バッファに整形し、はみ出しと終端を検査する。有限値は指数表記・全桁で整形して読み戻し、
+//           同じ値・同じ文字列に戻ることも検査する
+// 違反は abort() で知らせる（ASan/UBSan と併用すると範囲外アクセスもその場で止まる）
+//
+// ビルド（ホスト向けにビルドした Intel BID ライブラリ libbid.a が必要）:
+//   libFuzzer: clang -g -O1 -fsanitize=fuzzer,address,undefined -DRPN_FUZZ_LIBFUZZER -I.. -Ihost
+//              -DBID_THREAD= -o rpn_fuzz rpn_fuzz.c host_shim.c
+//              ../RPN.c ../cplx.c ../fraction.c libbid.a
+//   AFL/単体: 上の -fsanitize=fuzzer と -DRPN_FUZZ_LIBFUZZER を外して cc（または afl-cc）でビルド
+// 使い方: rpn_fuzz fuzz_seeds/*        ファイルを1つずつ実行（引数なしなら標準入力を1件。AFL 用）
+//         rpn_fuzz -n 回数 [-t 回/秒]  乱数入力を回して実行速度を出す（-t 未満なら終了コード 1）
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_shim.h"
+#include "bid_ops.h"
+#include "settings.h"
+
+#define FUZZ_MAX_INPUT 4096
+#define FUZZ_FORMAT_MAX 64
+#define FUZZ_ROUNDTRIP_BUF 64
+#define FUZZ_RANDOM_LEN 64
+
+// 入力中の文字列に現れてよい文字
+static const char k_input_chars[] = "0123456789.E+-";
+
+static void check_input_string(void)
+{
+    char buf[MAX_INPUTVAL_LENGTH + 1];
+    int n = rpn_get_input_string(buf, sizeof(buf));
+    if (n < 0 || n >= MAX_INPUTVAL_LENGTH || (int)strlen(buf) != n)
+        abort();
+    for (int i = 0; i < n; ++i)
+    {
+        if (!strchr(k_input_chars, buf[i]))
+            abort();
+    }
+    // 小さいバッファでも切り詰めて終端する
+    char small[4];
+    memset(small, 'x', sizeof(small));
+    rpn_get_input_string(small, sizeof(small));
+    if (strlen(small) >= sizeof(small))
+        abort();
+}
+
+static void fuzz_keys(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        uint8_t k = data[i] % 24;
+        if (k < 10)
+            rpn_input_append_digit((char)('0' + k));
+        else
+        {
+            switch (k)
+            {
+            case 10: rpn_input_dot(); break;
+            case 11: rpn_input_exp(); break;
+            case 12: rpn_input_toggle_sign(); break;
+            case 13: rpn_input_backspace(); break;
+            case 14: rpn_enter(); break;
+            case 15: rpn_clear_x(); break;
+            case 16: rpn_commit_input_without_push(); break;
+            case 17: rpn_add(); break;
+            case 18: rpn_sub(); break;
+            case 19: rpn_mul(); break;
+            case 20: rpn_div(); break;
+            case 21: rpn_swap(); break;
+            case 22: rpn_last(); break;
+            default: rpn_undo(); break;
+            }
+        }
+        check_input_string();
+    }
+    // 確定後の X も整形できること
+    rpn_commit_input_without_push();
+    char out[FUZZ_ROUNDTRIP_BUF];
+    bid128_to_str(rpn_stack_x(), out, sizeof(out));
+    if (strlen(out) >= sizeof(out))
+        abort();
+}
+
+// size バイトちょうどのバッファに整形する（末尾を越えた書き込みは ASan が検出する）
+static void format_exact(BID_UINT128 v, int size)
+{
+    char *buf = malloc((size_t)size);
+    if (!buf)
+        abort();
+    memset(buf, 'x', (size_t)size);
+    bid128_to_str(v, buf, size);
+    if (strnlen(buf, (size_t)size) >= (size_t)size)
+        abort();
+    free(buf);
+}
+
+static void check_roundtrip(BID_UINT128 v)
+{
+    if (!d_is_finite(v))
+        return;
+    char s1[FUZZ_ROUNDTRIP_BUF], s2[FUZZ_ROUNDTRIP_BUF];
+    rpn_set_disp_mode(DISP_MODE_SCIENTIFIC);
+    settings_set_digits(-1);
+    bid128_to_str(v, s1, sizeof(s1));
+    BID_UINT128 back = d_from_str(s1);
+    if (!d_eq(back, v))
+    {
+        fprintf(stderr, "round trip: \"%s\" does not read back to the same value\n", s1);
+        abort();
+    }
+    bid128_to_str(back, s2, sizeof(s2));
+    if (strcmp(s1, s2) != 0)
+    {
+        fprintf(stderr, "round trip: \"%s\" -> \"%s\"\n", s1, s2);
+        abort();
+    }
+}
+
+static void fuzz_format(const uint8_t *data, size_t size)
+{
+    uint8_t raw[sizeof(BID_UINT128) + 3] = {0};
+    memcpy(raw, data, size < sizeof(raw) ? size : sizeof(raw));
+    BID_UINT128 v;
+    memcpy(&v.w[BID_LOW_128W], raw, 8);
+    memcpy(&v.w[BID_HIGH_128W], raw + 8, 8);
+    int bufsize = 1 + raw[16] % FUZZ_FORMAT_MAX;
+    rpn_set_disp_mode((disp_mode_t)(raw[17] % 4));
+    rpn_set_zero_mode((raw[17] & 0x80) ? ZERO_MODE_PAD : ZERO_MODE_TRIM);
+    settings_set_digits((int8_t)(raw[18] % 11) - 1); // -1(ALL)..9
+    format_exact(v, bufsize);
+    check_roundtrip(v);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size == 0)
+        return 0;
+    host_reset();
+    if ((data[0] & 1) == 0)
+        fuzz_keys(data + 1, size - 1);
+    else
+        fuzz_format(data + 1, size - 1);
+    return 0;
+}
+
+#ifndef RPN_FUZZ_LIBFUZZER
+static int run_stream(FILE *f)
+{
+    static uint8_t buf[FUZZ_MAX_INPUT];
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    return LLVMFuzzerTestOneInput(buf, n);
+}
+
+static int run_random(long count, double min_rate)
+{
+    uint8_t buf[FUZZ_RANDOM_LEN];
+    srand((unsigned)time(NULL));
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < count; ++i)
+    {
+        size_t n = 1 + (size_t)rand() % sizeof(buf);
+        for (size_t j = 0; j < n; ++j)
+            buf[j] = (uint8_t)rand();
+        LLVMFuzzerTestOneInput(buf, n);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double sec = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    double rate = sec > 0.0 ? count / sec : 0.0;
+    printf("# %ld execs, %.3f s, %.0f execs/s\n", count, sec, rate);
+    if (min_rate > 0.0 && rate < min_rate)
+    {
+        printf("# below target %.0f execs/s\n", min_rate);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    long count = 0;
+    double min_rate = 0.0;
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-'; ++first)
+    {
+        if (strcmp(argv[first], "-n") == 0 && first + 1 < argc)
+            count = atol(argv[++first]);
+        else if (strcmp(argv[first], "-t") == 0 && first + 1 < argc)
+            min_rate = atof(argv[++first]);
+        else
+        {
+            fprintf(stderr, "usage: %s [file ...] | -n count [-t execs/s]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (count > 0)
+        return run_random(count, min_rate);
+    if (first >= argc)
+        return run_stream(stdin);
+    for (int i = first; i < argc; ++i)
+    {
+        FILE *f = fopen(argv[i], "rb");
+        if (!f)
+        {
+            perror(argv[i]);
+            return 2;
+        }
+        run_stream(f);
+        fclose(f);
+    }
+    printf("# %d inputs ok\n", argc - first);
+    return 0;
+}
+#endif
@@ -0,0 +1,55 @@
+// トレースのホスト側デコーダ
+// 使い方: picotool save -r <addr> <addr+4096> trace.bin && trace_decode trace.bin
+//   addr = 0x10000000 + フラッシュ容量 - 5 * 4096（TRACE_FLASH_OFFSET）
+// ビルド: cc -I.. -o trace_decode trace_decode.c ../crc32.c -DCRC32_USE_DMA_SNIFFER=0
+#include <stdio.h>
+#include <stddef.h>
+#define TRACE_FORMAT_ONLY
+#include "trace.h"
+#include "crc32.h"
+
+// 種別名（trace.c と同じ並び）
+const char *trace_type_name(uint8_t type)
+{
+    static const char *const names[TRACE_TYPE_COUNT] = {
+        "none", "boot", "key", "op", "clock", "flash", "off"};
+    return (type < TRACE_TYPE_COUNT) ? names[type] : "?";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s trace.bin\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[1], "rb");
+    if (!f)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    static trace_blob_t blob;
+    size_t n = fread(&blob, 1, sizeof(blob), f);
+    fclose(f);
+    if (n < offsetof(trace_blob_t, entries) || blob.magic != TRACE_MAGIC)
+    {
+        fprintf(stderr, "no trace found\n");
+        return 1;
+    }
+    uint32_t crc = crc32_calc_table(&blob.seq, sizeof(blob) - offsetof(trace_blob_t, seq));
+    if (crc != blob.crc)
+        fprintf(stderr, "warning: CRC mismatch (torn write?)\n");
+    if (blob.count > TRACE_ENTRIES)
+        blob.count = TRACE_ENTRIES;
+
+    printf("# %lu events recorded, showing last %lu\n", (unsigned long)blob.seq, (unsigned long)blob.count);
+    uint32_t t0 = blob.count ? blob.entries[0].time_us : 0;
+    for (uint32_t i = 0; i < blob.count; ++i)
+    {
+        const trace_entry_t *e = &blob.entries[i];
+        printf("%10.3f ms  %-5s a=%-3u b=0x%04x\n", (double)(uint32_t)(e->time_us - t0) / 1000.0,
+               trace_type_name(e->type), (unsigned)e->a, (unsigned)e->b);
+    }
+    return 0;
+}
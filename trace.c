@@ -0,0 +1,73 @@
+// キー/演算/クロック/フラッシュのイベントトレース（RAMリング、任意でフラッシュ保存）
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "crc32.h"
+
+// 保存先: レジュームログ(末尾から3,4番目)の手前のセクタ
+#define TRACE_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - 5 * FLASH_SECTOR_SIZE)
+
+trace_entry_t trace_ring[TRACE_ENTRIES];
+uint32_t trace_head = 0;
+
+static const char *const s_type_names[TRACE_TYPE_COUNT] = {
+    "none", "boot", "key", "op", "clock", "flash", "off"};
+
+const char *trace_type_name(uint8_t type)
+{
+    return (type < TRACE_TYPE_COUNT) ? s_type_names[type] : "?";
+}
+
+void trace_init(void)
+{
+    trace_head = 0;
+    memset(trace_ring, 0, sizeof(trace_ring));
+    trace_log(TRACE_BOOT, 0, 0);
+}
+
+// リングを古い順に取り出す。戻り値は件数
+static uint32_t copy_chronological(trace_entry_t *out)
+{
+    uint32_t count = (trace_head < TRACE_ENTRIES) ? trace_head : TRACE_ENTRIES;
+    uint32_t start = trace_head - count;
+    for (uint32_t i = 0; i < count; ++i)
+        out[i] = trace_ring[(start + i) & (TRACE_ENTRIES - 1)];
+    return count;
+}
+
+bool trace_prepare_save(persist_block_t *out)
+{
+#if TRACE_PERSIST
+    if (!out)
+        return false;
+    static uint8_t pad_buf[(sizeof(trace_blob_t) + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1)];
+    memset(pad_buf, 0xFF, sizeof(pad_buf));
+    trace_blob_t *blob = (trace_blob_t *)pad_buf;
+    blob->magic = TRACE_MAGIC;
+    blob->seq = trace_head;
+    blob->count = copy_chronological(blob->entries);
+    blob->crc = crc32_calc(&blob->seq, sizeof(*blob) - offsetof(trace_blob_t, seq));
+    out->flash_offset = TRACE_FLASH_OFFSET;
+    out->data = pad_buf;
+    out->len = sizeof(pad_buf);
+    out->append = false;
+    return true;
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+void trace_dump(void)
+{
+    static trace_entry_t tmp[TRACE_ENTRIES];
+    uint32_t count = copy_chronological(tmp);
+    printf("time_us,type,a,b\n");
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        printf("%lu,%s,%u,%u\n", (unsigned long)tmp[i].time_us, trace_type_name(tmp[i].type),
+               (unsigned)tmp[i].a, (unsigned)tmp[i].b);
+    }
+}
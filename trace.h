@@ -0,0 +1,89 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// リング長（2の冪）。1件8バイトなので 2KB
+#define TRACE_ENTRIES 256
+// 保存ブロブの識別子 'TRC1'
+#define TRACE_MAGIC 0x31435254u
+
+// 電源OFF時にトレースをフラッシュへ保存する（0で無効。保存のたびに1セクタ消去する）
+#ifndef TRACE_PERSIST
+#define TRACE_PERSIST 0
+#endif
+
+    // イベント種別
+    typedef enum
+    {
+        TRACE_NONE = 0,
+        TRACE_BOOT,      // 起動
+        TRACE_KEY,       // a: キーコード, b: イベント種別 | 0x100(マクロ注入)
+        TRACE_OP,        // a: 0=完了 1=取消し, b: 例外フラグ(rpn_get_last_exceptions)
+        TRACE_CLOCK,     // a: 0=低電力 1=高速
+        TRACE_FLASH,     // a: ブロック数, b: 所要時間[ms]
+        TRACE_POWER_OFF, // a: 0=電源OFFシーケンス開始 1=保存完了, b: OFF押下からの所要時間[ms]（a=1 のとき）
+        TRACE_TYPE_COUNT
+    } trace_type_t;
+
+    // 1件分（8バイト）
+    typedef struct
+    {
+        uint32_t time_us; // time_us_32()
+        uint8_t type;     // trace_type_t
+        uint8_t a;
+        uint16_t b;
+    } trace_entry_t;
+
+    // フラッシュ保存形式（古い順に count 件）
+    typedef struct
+    {
+        uint32_t magic;
+        uint32_t crc;   // seq 以降（entries 含む）の CRC32
+        uint32_t seq;   // 保存時点の通算記録件数
+        uint32_t count; // 有効件数（<= TRACE_ENTRIES）
+        trace_entry_t entries[TRACE_ENTRIES];
+    } trace_blob_t;
+
+    // 種別名（デコード表示用）
+    const char *trace_type_name(uint8_t type);
+
+#ifndef TRACE_FORMAT_ONLY
+#include "hardware/timer.h"
+#include "persist.h"
+
+    // リング本体（trace_log のインライン展開用。直接触らないこと）
+    extern trace_entry_t trace_ring[TRACE_ENTRIES];
+    extern uint32_t trace_head;
+
+    // 1件記録する。core0 のスレッド文脈（割込みハンドラ外）からのみ呼ぶこと
+    static inline void trace_log(trace_type_t type, uint8_t a, uint16_t b)
+    {
+        trace_entry_t *e = &trace_ring[trace_head++ & (TRACE_ENTRIES - 1)];
+        e->time_us = time_us_32();
+        e->type = (uint8_t)type;
+        e->a = a;
+        e->b = b;
+    }
+
+    // 起動時に呼ぶ（BOOT を記録）
+    void trace_init(void);
+
+    // 電源OFF時の一括保存用（TRACE_PERSIST 有効時のみ true を返す）
+    bool trace_prepare_save(persist_block_t *out);
+
+    // リングを古い順にCSVでシリアル（stdio）へ出力する
+    void trace_dump(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H
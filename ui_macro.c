@@ -55,7 +55,7 @@ static bool confirm_overwrite_dialog(int slot)
         {
             if (ev.code == K_ENTER)
                 return true; // 上書き実行
-            if (ev.code == K_DEL || ev.code == K_OFF)
+            if (key_is_cancel_event(ev))
                 return false; // キャンセル
         }
         sleep_ms(10);
@@ -0,0 +1,228 @@
+#include "ui_matrix.h"
+#include <stdio.h>
+#include <string.h>
+#include "LCD.h"
+#include "RPN.h"
+#include "key.h"
+
+// 要素の入力バッファ（34桁 + 符号/小数点/指数）
+#define MATRIX_ENTRY_MAX 40
+
+static bool g_matrix_ui_active = false;
+static matrix_id_t g_matrix = MATRIX_A;
+static int g_row = 0;
+static int g_col = 0;
+static char g_entry[MATRIX_ENTRY_MAX + 1];
+static int g_entry_len = 0;
+
+static void render_matrix_ui(void)
+{
+    char line1[17];
+    char line2[17];
+    char head[17];
+    snprintf(head, sizeof(head), "%c(%d,%d)", 'A' + (int)g_matrix, g_row + 1, g_col + 1);
+    snprintf(line1, sizeof(line1), "%-10s%dx%d  ", head, matrix_rows(g_matrix), matrix_cols(g_matrix));
+    if (key_get_shift_state())
+        line1[15] = 's';
+
+    for (int i = 0; i < 16; ++i)
+        line2[i] = ' ';
+    line2[16] = '\0';
+    if (g_entry_len > 0)
+    {
+        // 入力中は右端に最新桁が来るように表示
+        int start = g_entry_len > 16 ? g_entry_len - 16 : 0;
+        memcpy(line2, g_entry + start, (size_t)(g_entry_len - start));
+    }
+    else
+    {
+        BID_UINT128 v;
+        char vbuf[17];
+        if (matrix_get(g_matrix, g_row, g_col, &v))
+        {
+            bid128_to_str(v, vbuf, sizeof(vbuf));
+            memcpy(line2, vbuf, strlen(vbuf));
+        }
+    }
+    lcd_set_cursor(0, 0);
+    lcd_write(line1, 16);
+    lcd_set_cursor(1, 0);
+    lcd_write(line2, 16);
+}
+
+// 行優先で次/前の要素へ（端では反対側へ回る）
+static void move_next(void)
+{
+    if (++g_col >= matrix_cols(g_matrix))
+    {
+        g_col = 0;
+        if (++g_row >= matrix_rows(g_matrix))
+            g_row = 0;
+    }
+}
+
+static void move_prev(void)
+{
+    if (--g_col < 0)
+    {
+        g_col = matrix_cols(g_matrix) - 1;
+        if (--g_row < 0)
+            g_row = matrix_rows(g_matrix) - 1;
+    }
+}
+
+static void entry_append(char c)
+{
+    if (g_entry_len < MATRIX_ENTRY_MAX)
+    {
+        g_entry[g_entry_len++] = c;
+        g_entry[g_entry_len] = '\0';
+    }
+}
+
+// 符号反転: 指数入力中なら指数の符号、そうでなければ仮数の符号
+static void entry_toggle_sign(void)
+{
+    char *e = strchr(g_entry, 'E');
+    char *p = e ? e + 1 : g_entry;
+    if (*p == '-')
+    {
+        memmove(p, p + 1, strlen(p));
+        g_entry_len--;
+    }
+    else if (g_entry_len < MATRIX_ENTRY_MAX)
+    {
+        memmove(p + 1, p, strlen(p) + 1);
+        *p = '-';
+        g_entry_len++;
+    }
+}
+
+// 入力中の値を要素に書き込む。解釈できなければ false（入力は残す）
+static bool entry_commit(void)
+{
+    BID_UINT128 v;
+    bid128_from_string(&v, g_entry);
+    int is_nan = 0;
+    __bid128_isNaN(&is_nan, &v);
+    if (is_nan)
+        return false;
+    matrix_set(g_matrix, g_row, g_col, v);
+    g_entry_len = 0;
+    g_entry[0] = '\0';
+    return true;
+}
+
+static void entry_clear(void)
+{
+    g_entry_len = 0;
+    g_entry[0] = '\0';
+}
+
+static void close_ui(void)
+{
+    entry_clear();
+    key_set_shift_state(false);
+    g_matrix_ui_active = false;
+}
+
+void matrix_ui_open(matrix_id_t m)
+{
+    g_matrix = m;
+    g_row = 0;
+    g_col = 0;
+    entry_clear();
+    g_matrix_ui_active = true;
+    render_matrix_ui();
+}
+
+bool matrix_ui_is_open(void)
+{
+    return g_matrix_ui_active;
+}
+
+bool matrix_ui_handle_key(key_event_t ev)
+{
+    if (!g_matrix_ui_active)
+        return false;
+    if (ev.type == KEY_EVENT_UP || ev.type == KEY_EVENT_NONE)
+        return false;
+    switch (ev.code)
+    {
+    case K_0:
+    case K_1:
+    case K_2:
+    case K_3:
+    case K_4:
+    case K_5:
+    case K_6:
+    case K_7:
+    case K_8:
+    case K_9:
+        entry_append((char)('0' + (ev.code - K_0)));
+        break;
+    case K_DOT:
+        if (!strchr(g_entry, '.') && !strchr(g_entry, 'E'))
+            entry_append('.');
+        break;
+    case K_EE:
+        if (!strchr(g_entry, 'E'))
+        {
+            if (g_entry_len == 0 || (g_entry_len == 1 && g_entry[0] == '-'))
+                entry_append('1');
+            entry_append('E');
+        }
+        break;
+    case K_SIGN:
+        entry_toggle_sign();
+        break;
+    // ENTER: 入力値を書き込んで次の要素へ（入力が無ければそのまま次へ）
+    case K_ENTER:
+        if (g_entry_len > 0 && !entry_commit())
+            break;
+        move_next();
+        break;
+    case K_ROLL:
+    case K_ADD:
+        entry_clear();
+        move_next();
+        break;
+    case K_ROLLUP:
+    case K_SUB:
+        entry_clear();
+        move_prev();
+        break;
+    // SWAP: X の値を要素に書き込む
+    case K_SWAP:
+        entry_clear();
+        matrix_set(g_matrix, g_row, g_col, rpn_stack_x());
+        break;
+    // LD（Shift+1）: 要素を X に呼び出して閉じる
+    case K_LD:
+    {
+        BID_UINT128 v;
+        if (matrix_get(g_matrix, g_row, g_col, &v))
+            rpn_input_value(v);
+        close_ui();
+        return true;
+    }
+    case K_SHIFT:
+        break;
+    case K_DEL:
+        if (g_entry_len > 0)
+        {
+            g_entry[--g_entry_len] = '\0';
+            break;
+        }
+        close_ui();
+        return true;
+    case K_OFF:
+        close_ui();
+        return true;
+    // UI外の操作に影響するキーは無効化
+    default:
+        return false;
+    }
+    render_matrix_ui();
+    return false;
+}
@@ -0,0 +1,28 @@
+#ifndef UI_MATRIX_H
+#define UI_MATRIX_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include "key.h"
+#include "matrix.h"
+
+    // 行列エディタを開く（要素 (1,1) から）。即座に描画する。
+    void matrix_ui_open(matrix_id_t m);
+
+    // エディタが開いているか
+    bool matrix_ui_is_open(void);
+
+    // キー処理（ui_const と同じ戻り値ポリシー）
+    // true: 通常画面の再描画が必要（UIを閉じた等）
+    // false: UI内で再描画済み
+    bool matrix_ui_handle_key(key_event_t ev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UI_MATRIX_H